@@ -11,6 +11,8 @@ if (1)
         src/modem/modem_at.c ...
         src/modem/modem_cmd.c ...
         src/modem/modem_hal.c ...
+        src/modem/modem_log.c ...
+        src/modem/modem_latency.c ...
         src/modem/modem_stats.c ...
         src/modem/modem_umi.c ...
         src/os/os.c ...
@@ -22,56 +24,52 @@ end
 test_modem_app('switch_modem_on');
 assert(test_modem_app('check_last_received_at_cmd','AT') == 1);
 test_modem_app('modem_send_at_cmd', 2, 'AT', 'OK');
-assert(test_modem_app('check_last_received_at_cmd','ATI') == 1);
-test_modem_app('modem_send_at_cmd', 3, 'ATI', 'HL7810', 'OK');
-assert(test_modem_app('check_last_received_at_cmd','AT+CGMR') == 1);
-test_modem_app('modem_send_at_cmd', 3, 'AT+CGMR', 'HL7810.4.6.9.4', 'OK');
+assert(test_modem_app('check_last_received_at_cmd','ATI;+CGMR;+KGSN=3;+CGSN') == 1);
+test_modem_app('modem_send_at_cmd', 6, 'ATI;+CGMR;+KGSN=3;+CGSN', 'HL7810', 'HL7810.4.6.9.4', '+KGSN: D13062105213B1', '354720510148914', 'OK');
+assert(test_modem_app('check_modem_info', '', 'identity', 'HL7810,HL7810.4.6.9.4,D13062105213B1,354720510148914') == 1);
 
 %% Test 2: Modem Configuration
-assert(test_modem_app('check_last_received_at_cmd','AT+KGSN=3') == 1);
-test_modem_app('modem_send_at_cmd', 3, 'AT+KGSN=3','+KGSN: D13062105213B1', 'OK');
-assert(test_modem_app('check_last_received_at_cmd','AT+CGSN') == 1);
-test_modem_app('modem_send_at_cmd', 3, 'AT+CGSN', '354720510148914', 'OK');
-assert(test_modem_app('check_last_received_at_cmd','AT+CGDCONT?') == 1);
+assert(test_modem_app('check_last_received_at_cmd','AT+CGDCONT?;+KBNDCFG?;+KSELACQ?;+CEREG?;+CFUN?;+KBND?;+CCID') == 1);
 
-test_modem_app('modem_send_at_cmd', 3, '+CGDCONT: 1,''IPV4V6'',''.cxn'',,0,0,0,0,0,,0,,,,','+CGDCONT: 2,''IPV4V6'',,,0,0,0,0,0,,0,,,,' , 'OK');
+test_modem_app('modem_send_at_cmd', 11, '+CGDCONT: 1,''IPV4V6'',''.cxn'',,0,0,0,0,0,,0,,,,','+CGDCONT: 2,''IPV4V6'',,,0,0,0,0,0,,0,,,,', '+KBNDCFG: 0,000000000000000A0A188E','+KBNDCFG: 1,0000000000000000080084', '+KBNDCFG: 2,0', '+KSELACQ:2,1', '+CEREG: 2,0', '+CFUN: 0', '+KBND:1,0000000000000000080084', '+CCID: +491747365135', 'OK');
 assert(test_modem_app('check_last_received_at_cmd','AT+CGDCONT=1,IPV4V6,"''internet.cxn''",,0,0,0,0,0,,0,,,,,') == 1);
 test_modem_app('modem_send_at_cmd', 3, '+CGDCONT: 1,''IPV4V6'',"''intet.cxn''",,0,0,0,0,0,,0,,,,','+CGDCONT: 2,''IPV4V6'',,,0,0,0,0,0,,0,,,,' , 'OK');
 assert(test_modem_app('check_last_received_at_cmd','AT+CGDCONT=1,IPV4V6,"''internet.cxn''",,0,0,0,0,0,,0,,,,,') == 1);
 test_modem_app('modem_send_at_cmd', 3, '+CGDCONT: 1,''IPV4V6'',"''internet.cxn''",,0,0,0,0,0,,0,,,,','+CGDCONT: 2,''IPV4V3'',,,0,0,0,0,0,,0,,,,' , 'OK');
-
-assert(test_modem_app('check_last_received_at_cmd','AT+KBNDCFG?') == 1);
-test_modem_app('modem_send_at_cmd', 4, '+KBNDCFG: 0,000000000000000A0A188E','+KBNDCFG: 1,0000000000000000080084', '+KBNDCFG: 2,0' , 'OK');
-assert(test_modem_app('check_last_received_at_cmd','AT+KSELACQ?') == 1);
-test_modem_app('modem_send_at_cmd', 2, '+KSELACQ:2,1','OK');
-assert(test_modem_app('check_last_received_at_cmd','AT+CEREG?') == 1);
-test_modem_app('modem_send_at_cmd', 2, '+CEREG: 2,0','OK');
-assert(test_modem_app('check_last_received_at_cmd','AT+CFUN?') == 1);
-test_modem_app('modem_send_at_cmd', 2, '+CFUN: 0','OK');
-assert(test_modem_app('check_last_received_at_cmd','AT+KBND?') == 1);
-test_modem_app('modem_send_at_cmd', 2, '+KBND:1,0000000000000000080084','OK');
-assert(test_modem_app('check_last_received_at_cmd','AT+CCID') == 1);
-test_modem_app('modem_send_at_cmd', 2, '+CCID: +491747365135','OK');
-test_modem_app('timer_modem_next_action');
+assert(test_modem_app('check_modem_info', '', 'bnd', '1,0000000000000000080084') == 1);
+test_modem_app('timer_modem_watchdog');
 assert(test_modem_app('check_last_received_at_cmd','AT+CFUN=1,1') == 1);
 test_modem_app('modem_send_at_cmd', 4, 'AT+CFUN=1,1','OK','+CEREG: 2','+WDSI: 0');
 test_modem_app('modem_reset');
 assert(test_modem_app('check_last_received_at_cmd','AT') == 1);
 test_modem_app('modem_send_at_cmd', 7, 'AT', 'OK','+CEREG: 2','+CEREG: 0','+CEREG: 2','+CEREG: 2','+CEREG: 5,"DAD9","01AF8F0D",9');
-assert(test_modem_app('check_last_received_at_cmd','AT+CGDCONT?') == 1);
-test_modem_app('modem_send_at_cmd', 3, '+CGDCONT: 1,''IPV4V6'',''internet.cxn'',,0,0,0,0,0,,0,,,,','+CGDCONT: ",''IPV4V6'',,,0,0,0,0,0,,0,,,,' , 'OK');
-assert(test_modem_app('check_last_received_at_cmd','AT+KBND?') == 1);
-test_modem_app('modem_send_at_cmd', 3,'AT+KBND?','+KBND: 1,0000000000000000000080', 'OK');
+assert(test_modem_app('check_last_received_at_cmd','AT+CGDCONT?;+KBND?') == 1);
+test_modem_app('modem_send_at_cmd', 5, 'AT+CGDCONT?;+KBND?', '+CGDCONT: 1,''IPV4V6'',''internet.cxn'',,0,0,0,0,0,,0,,,,','+CGDCONT: ",''IPV4V6'',,,0,0,0,0,0,,0,,,,', '+KBND: 1,0000000000000000000080', 'OK');
 assert(test_modem_app('check_last_received_at_cmd','AT+CESQ') == 1);
 test_modem_app('modem_send_at_cmd', 3, 'AT+CESQ','+CESQ: 99,99,255,255,20,39','OK');
-test_modem_app('timer_modem_next_action');
+test_modem_app('timer_modem_watchdog');
 assert(test_modem_app('check_last_received_at_cmd','AT+KCNXCFG=1,"GPRS","''internet.cxn''"') == 1);
 test_modem_app('modem_send_at_cmd', 2, 'AT+KCNXCFG=1,"GPRS","''internet.cxn''"','OK');
 assert(test_modem_app('check_last_received_at_cmd','AT+KUDPCFG=1,0') == 1);%need to stub connection type as UDP before this step
+test_modem_app('queue_tx_payload', 2500, 1);% tag 1, three fragments sent before the empty frame (tag 0)
+assert(test_modem_app('check_tx_frame_rejected', 'F70001') == 1);% a plain frame must not look like a fragment
 test_modem_app('modem_send_at_cmd', 5, 'AT+KUDPCFG=1,0','+KUDPCFG: 1','OK','+KCNX_IND: 1,1,0','+KUDP_IND: 1,1');
 %% Test 3: Modem Data Transfer
-assert(test_modem_app('check_last_received_at_cmd','AT+KUDPSND=1,"199.64.78.128",4154,0') == 1);%need to stub  uint8_t *modem_queuedTxPkg = (int *)50 from NULL
+assert(test_modem_app('check_last_received_at_cmd','AT+KUDPSND=1,"199.64.78.128",4154,1024') == 1);
+test_modem_app('modem_send_at_cmd', 2, 'AT+KUDPSND=1,"199.64.78.128",4154,1024','CONNECT');
+assert(test_modem_app('check_tx_fragment', 0, 3, 2500) == 1);
+test_modem_app('modem_send_at_cmd', 1, 'OK');
+assert(test_modem_app('check_last_received_at_cmd','AT+KUDPSND=1,"199.64.78.128",4154,1024') == 1);
+test_modem_app('modem_send_at_cmd', 2, 'AT+KUDPSND=1,"199.64.78.128",4154,1024','CONNECT');
+assert(test_modem_app('check_tx_fragment', 1, 3, 2500) == 1);
+test_modem_app('modem_send_at_cmd', 1, 'OK');
+assert(test_modem_app('check_last_received_at_cmd','AT+KUDPSND=1,"199.64.78.128",4154,464') == 1);
+test_modem_app('modem_send_at_cmd', 2, 'AT+KUDPSND=1,"199.64.78.128",4154,464','CONNECT');
+assert(test_modem_app('check_tx_fragment', 2, 3, 2500) == 1);
+test_modem_app('modem_send_at_cmd', 1, 'OK');
+assert(test_modem_app('check_last_received_at_cmd','AT+KUDPSND=1,"199.64.78.128",4154,0') == 1);% empty frame the test app queues by default
 test_modem_app('modem_send_at_cmd', 4, 'AT+KUDPSND=1,"199.64.78.128",4154,0','CONNECT','OK','+KUDP_DATA: 1,51');
+assert(test_modem_app('check_tx_done', '1s,0s') == 1);
 assert(test_modem_app('check_last_received_at_cmd','AT+KUDPRCV=1,51') == 1);
 test_modem_app('modem_send_at_cmd', 5, 'AT+KUDPRCV=1,51','CONNECT','00 01 00 10 00 01 00 2b 60 29 a1 09 06 07 60 85 74 05 08 01 01 a6 0a 04 08 45 49 43 54 43 4f 4d 4d be 10 04 0e 01 00 00 00 06 5f 1f 04 00 00 7e 1f 10 00 --EOF--Pattern--','OK','+KUDP_RCV: "199.64.78.128",4154');
 assert(test_modem_app('check_last_received_at_cmd','AT+CESQ') == 1);
@@ -88,9 +86,108 @@ assert(test_modem_app('check_last_received_at_cmd','AT') == 1);
 test_modem_app('modem_send_at_cmd', 2, 'AT', 'OK');
 assert(test_modem_app('check_last_received_at_cmd','AT+CFUN?') == 1);
 test_modem_app('modem_send_at_cmd', 3, 'AT+CFUN?','+CFUN: 4', 'OK');
-test_modem_app('timer_modem_next_action');
+test_modem_app('timer_modem_watchdog');
 assert(test_modem_app('check_last_received_at_cmd','AT+CPOF') == 1);
 test_modem_app('modem_send_at_cmd', 2, 'AT+CPOF', 'OK');
-test_modem_app('timer_modem_next_action');
+test_modem_app('timer_modem_watchdog');
 
 
+%% Test 5: typed response parsing into modemInfo, out of range or malformed arguments are rejected
+assert(test_modem_app('check_modem_info', '+CESQ: 99,99,255,255,20,39', 'cesq', '99,99,255,255,20,39') == 1);
+assert(test_modem_app('check_modem_info', '+CESQ: 99,99,255,255,19,300', 'cesq', '99,99,255,255,19,39') == 1);
+assert(test_modem_app('check_modem_info', '+CESQ: 99,99,255,255,x,40', 'cesq', '99,99,255,255,19,40') == 1);
+assert(test_modem_app('check_modem_info', '+KSELACQ: 2,1', 'prl', '2,1,0') == 1);
+assert(test_modem_app('check_modem_info', '+KSELACQ: 0', 'prl', '0,0,0') == 1);
+assert(test_modem_app('check_modem_info', '+KBND: 1,0000000000000000080084', 'bnd', '1,0000000000000000080084') == 1);
+assert(test_modem_app('check_modem_info', '+KBND: 1,000000000000000000008000084', 'bnd', '1,0000000000000000080084') == 1);
+assert(test_modem_app('check_modem_info', '+KBND: 7,0000000000000000000080', 'bnd', '1,0000000000000000000080') == 1);
+assert(test_modem_app('check_modem_info', '+KBNDCFG: 0,000000000000000A0A188E', 'bnd_bitmap', '000000000000000A0A188E,0000000000000000080084,0') == 1);
+assert(test_modem_app('check_modem_info', '+KBNDCFG: 1,00000000000000000800G4', 'bnd_bitmap', '000000000000000A0A188E,0000000000000000080084,0') == 1);
+assert(test_modem_app('check_modem_info', '+KBNDCFG: 3,0000000000000000080084', 'bnd_bitmap', '000000000000000A0A188E,0000000000000000080084,0') == 1);
+assert(test_modem_app('check_modem_info', '+CGDCONT: 1,"IPV4V6","internet.cxn",,0,0,0,0,0,,0,,,,', 'pdp_context', '1,IPV4V6,internet.cxn,0') == 1);
+assert(test_modem_app('check_modem_info', '+CGDCONT: 2,"IP","other.apn",,0,0,0,0,0,,0,,,,', 'pdp_context', '1,IPV4V6,internet.cxn,0') == 1);
+%% Test 6: AT lines longer than the 256 byte line buffer (incl. \r) are discarded up to their terminator
+assert(test_modem_app('check_at_line_overflow', 200, 1, 0) == 1);
+assert(test_modem_app('check_at_line_overflow', 257, 64, 0) == 1);
+assert(test_modem_app('check_at_line_overflow', 258, 64, 1) == 1);
+assert(test_modem_app('check_at_line_overflow', 1500, 1, 1) == 1);
+assert(test_modem_app('check_at_line_overflow', 1500, 100, 1) == 1);
+%% Test 7: tokenized modem log keeps the most recent records when it overflows
+assert(test_modem_app('check_log', 10) == 1);
+assert(test_modem_app('check_log', 1000) == 1);
+%% Test 8: AT commands sent while a response is pending are queued and sent on OK, ERROR or timeout
+assert(test_modem_app('check_at_queue', 3, 0) == 1);
+assert(test_modem_app('check_at_queue', 8, 0) == 1);
+assert(test_modem_app('check_at_queue', 10, 2) == 1);
+assert(test_modem_app('check_at_probe', 3) == 1);% the modem does not answer, the timer does not queue more AT probes until the AT timeout
+assert(test_modem_app('check_long_cmd') == 1);
+%% Test 9: AT timeouts are derived from the observed response times of the command class, clamped to its limits
+assert(test_modem_app('check_at_latency', '', 50, 20, 300) == 1);
+assert(test_modem_app('check_at_latency', '+CGSN', 20, 20, 300) == 1);
+assert(test_modem_app('check_at_latency', '+CFUN=1,1', 5000, 10, 30000) == 1);
+assert(test_modem_app('check_at_latency', '+CFUN=1,1', 5000, 20, 16384) == 1);
+assert(test_modem_app('check_at_latency', '+CGSN', 3000, 20, 4000) == 1);
+assert(test_modem_app('check_at_latency', '+COPS=0', 60000, 20, 131072) == 1);
+assert(test_modem_app('check_at_latency', '+COPS=0', 200000, 20, 180000) == 1);
+assert(test_modem_app('check_at_latency', '+CGSN', 5000, 20, 4000) == 1);
+%% Test 10: raw transmit gathers the queued payload and the EOF pattern from their own storage
+assert(test_modem_app('check_raw_tx', 'AA') == 1);
+assert(test_modem_app('check_raw_tx', '000100010010002B6029A109060760857405080101') == 1);
+%% Test 11: EOF pattern detection in raw data mode, frames fed in chunks of 1, 3 and 64 bytes
+assert(test_modem_app('check_eof_frame', '0A2D2D454F462D2D5061747465726E2D2D', '', 1) == 1);
+assert(test_modem_app('check_eof_frame', '0A2D2D454F462D2D5061747465726E2D2D', '', 3) == 1);
+assert(test_modem_app('check_eof_frame', '0A2D2D454F462D2D5061747465726E2D2D', '', 64) == 1);
+assert(test_modem_app('check_eof_frame', '0AAABBCC2D2D454F462D2D5061747465726E2D2D', 'AABBCC', 1) == 1);
+assert(test_modem_app('check_eof_frame', '0AAABBCC2D2D454F462D2D5061747465726E2D2D', 'AABBCC', 3) == 1);
+assert(test_modem_app('check_eof_frame', '0AAABBCC2D2D454F462D2D5061747465726E2D2D', 'AABBCC', 64) == 1);
+assert(test_modem_app('check_eof_frame', '0AAABBCC2D2D2D454F462D2D5061747465726E2D2D', 'AABBCC2D', 1) == 1);
+assert(test_modem_app('check_eof_frame', '0AAABBCC2D2D2D454F462D2D5061747465726E2D2D', 'AABBCC2D', 3) == 1);
+assert(test_modem_app('check_eof_frame', '0AAABBCC2D2D2D454F462D2D5061747465726E2D2D', 'AABBCC2D', 64) == 1);
+assert(test_modem_app('check_eof_frame', '0AAABBCC2D2D2D2D454F462D2D5061747465726E2D2D', 'AABBCC2D2D', 1) == 1);
+assert(test_modem_app('check_eof_frame', '0AAABBCC2D2D2D2D454F462D2D5061747465726E2D2D', 'AABBCC2D2D', 3) == 1);
+assert(test_modem_app('check_eof_frame', '0AAABBCC2D2D2D2D454F462D2D5061747465726E2D2D', 'AABBCC2D2D', 64) == 1);
+assert(test_modem_app('check_eof_frame', '0AAABBCC2D2D2D2D2D454F462D2D5061747465726E2D2D', 'AABBCC2D2D2D', 1) == 1);
+assert(test_modem_app('check_eof_frame', '0AAABBCC2D2D2D2D2D454F462D2D5061747465726E2D2D', 'AABBCC2D2D2D', 3) == 1);
+assert(test_modem_app('check_eof_frame', '0AAABBCC2D2D2D2D2D454F462D2D5061747465726E2D2D', 'AABBCC2D2D2D', 64) == 1);
+assert(test_modem_app('check_eof_frame', '0AAABBCC2D2D2D452D2D2D2D454F462D2D5061747465726E2D2D', 'AABBCC2D2D2D452D2D', 1) == 1);
+assert(test_modem_app('check_eof_frame', '0AAABBCC2D2D2D452D2D2D2D454F462D2D5061747465726E2D2D', 'AABBCC2D2D2D452D2D', 3) == 1);
+assert(test_modem_app('check_eof_frame', '0AAABBCC2D2D2D452D2D2D2D454F462D2D5061747465726E2D2D', 'AABBCC2D2D2D452D2D', 64) == 1);
+assert(test_modem_app('check_eof_frame', '0A2D2D454F462D2D2D454F462D2D5061747465726E2D2D', '2D2D454F462D', 1) == 1);
+assert(test_modem_app('check_eof_frame', '0A2D2D454F462D2D2D454F462D2D5061747465726E2D2D', '2D2D454F462D', 3) == 1);
+assert(test_modem_app('check_eof_frame', '0A2D2D454F462D2D2D454F462D2D5061747465726E2D2D', '2D2D454F462D', 64) == 1);
+assert(test_modem_app('check_eof_frame', '0A2D2D454F462D2D5061747465722D2D454F462D2D5061747465726E2D2D', '2D2D454F462D2D506174746572', 1) == 1);
+assert(test_modem_app('check_eof_frame', '0A2D2D454F462D2D5061747465722D2D454F462D2D5061747465726E2D2D', '2D2D454F462D2D506174746572', 3) == 1);
+assert(test_modem_app('check_eof_frame', '0A2D2D454F462D2D5061747465722D2D454F462D2D5061747465726E2D2D', '2D2D454F462D2D506174746572', 64) == 1);
+%% Test 12: streamed raw data, payload passed on in chunks while the EOF pattern is searched
+assert(test_modem_app('check_eof_stream', '0A2D2D454F462D2D5061747465726E2D2D', '', 1) == 1);
+assert(test_modem_app('check_eof_stream', '0AAABBCC2D2D454F462D2D5061747465726E2D2D', 'AABBCC', 1) == 1);
+assert(test_modem_app('check_eof_stream', '0AAABBCC2D2D2D454F462D2D5061747465726E2D2D', 'AABBCC2D', 1) == 1);
+assert(test_modem_app('check_eof_stream', '0AAABBCC2D2D2D2D454F462D2D5061747465726E2D2D', 'AABBCC2D2D', 1) == 1);
+assert(test_modem_app('check_eof_stream', '0AAABBCC2D2D2D2D2D454F462D2D5061747465726E2D2D', 'AABBCC2D2D2D', 1) == 1);
+assert(test_modem_app('check_eof_stream', '0AAABBCC2D2D2D452D2D2D2D454F462D2D5061747465726E2D2D', 'AABBCC2D2D2D452D2D', 1) == 1);
+assert(test_modem_app('check_eof_stream', '0A2D2D454F462D2D2D454F462D2D5061747465726E2D2D', '2D2D454F462D', 1) == 1);
+assert(test_modem_app('check_eof_stream', '0A2D2D454F462D2D5061747465722D2D454F462D2D5061747465726E2D2D', '2D2D454F462D2D506174746572', 1) == 1);
+assert(test_modem_app('check_eof_stream', '0A2D2D454F462D2D5061747465726E2D2D', '', 3) == 1);
+assert(test_modem_app('check_eof_stream', '0AAABBCC2D2D454F462D2D5061747465726E2D2D', 'AABBCC', 3) == 1);
+assert(test_modem_app('check_eof_stream', '0AAABBCC2D2D2D454F462D2D5061747465726E2D2D', 'AABBCC2D', 3) == 1);
+assert(test_modem_app('check_eof_stream', '0AAABBCC2D2D2D2D454F462D2D5061747465726E2D2D', 'AABBCC2D2D', 3) == 1);
+assert(test_modem_app('check_eof_stream', '0AAABBCC2D2D2D2D2D454F462D2D5061747465726E2D2D', 'AABBCC2D2D2D', 3) == 1);
+assert(test_modem_app('check_eof_stream', '0AAABBCC2D2D2D452D2D2D2D454F462D2D5061747465726E2D2D', 'AABBCC2D2D2D452D2D', 3) == 1);
+assert(test_modem_app('check_eof_stream', '0A2D2D454F462D2D2D454F462D2D5061747465726E2D2D', '2D2D454F462D', 3) == 1);
+assert(test_modem_app('check_eof_stream', '0A2D2D454F462D2D5061747465722D2D454F462D2D5061747465726E2D2D', '2D2D454F462D2D506174746572', 3) == 1);
+assert(test_modem_app('check_eof_stream_large', 10000, 1) == 1);
+assert(test_modem_app('check_eof_stream_large', 10000, 64) == 1);
+assert(test_modem_app('check_eof_stream_large', 10000, 1500) == 1);
+%% Benchmark: rx throughput, per char vs block ingestion
+assert(test_modem_app('benchmark_rx', 2000) > 0);
+%% Benchmark: AT response / URC dispatch on a recorded HL7810 trace
+assert(test_modem_app('benchmark_urc', 20000) > 0);
+%% Benchmark: raw data rx with EOF pattern search, 4 KB frames
+assert(test_modem_app('benchmark_eof', 2000) > 0);
+%% Benchmark: uart rx ring, rx interrupt played by a second thread at 921600 baud and unpaced
+assert(test_modem_app('benchmark_rx_ring', 92160, 921600) > 0);
+assert(test_modem_app('benchmark_rx_ring', 4000000, 0) > 0);
+%% Benchmark: building and transmitting AT commands
+assert(test_modem_app('benchmark_at_cmd', 1000000) > 0);
+%% Benchmark: recording a tokenized log message vs formatting it
+assert(test_modem_app('benchmark_log', 1000000) > 0);
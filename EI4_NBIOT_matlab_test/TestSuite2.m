@@ -11,6 +11,8 @@ if (1)
         src/modem/modem_at.c ...
         src/modem/modem_cmd.c ...
         src/modem/modem_hal.c ...
+        src/modem/modem_log.c ...
+        src/modem/modem_latency.c ...
         src/modem/modem_stats.c ...
         src/modem/modem_umi.c ...
         src/os/os.c ...
@@ -22,19 +24,14 @@ end
 test_modem_app('switch_modem_on');
 assert(test_modem_app('check_last_received_at_cmd','AT') == 1);
 test_modem_app('modem_send_at_cmd', 2, 'AT', 'OK');
-assert(test_modem_app('check_last_received_at_cmd','ATI') == 1);
-test_modem_app('modem_send_at_cmd', 3, 'ATI', 'HL7810', 'OK');
-assert(test_modem_app('check_last_received_at_cmd','AT+CGMR') == 1);
-test_modem_app('modem_send_at_cmd', 3, 'AT+CGMR', 'HL7810.4.6.9.4', 'OK');
+assert(test_modem_app('check_last_received_at_cmd','ATI;+CGMR;+KGSN=3;+CGSN') == 1);
+test_modem_app('modem_send_at_cmd', 6, 'ATI;+CGMR;+KGSN=3;+CGSN', 'HL7810', 'HL7810.4.6.9.4', '+KGSN: D13062105213B1', '354720510148914', 'OK');
+assert(test_modem_app('check_modem_info', '', 'identity', 'HL7810,HL7810.4.6.9.4,D13062105213B1,354720510148914') == 1);
 
 % Test 2: Modem Configuration
-assert(test_modem_app('check_last_received_at_cmd','AT+KGSN=3') == 1);
-test_modem_app('modem_send_at_cmd', 3, 'AT+KGSN=3','+KGSN: D13062105213B1', 'OK');
-assert(test_modem_app('check_last_received_at_cmd','AT+CGSN') == 1);
-test_modem_app('modem_send_at_cmd', 3, 'AT+CGSN', '354720510148914', 'OK');
-assert(test_modem_app('check_last_received_at_cmd','AT+CGDCONT?') == 1);
+assert(test_modem_app('check_last_received_at_cmd','AT+CGDCONT?;+KBNDCFG?;+KSELACQ?;+CEREG?;+CFUN?;+KBND?;+CCID') == 1);
 %% Test 1: injecting_wrong_PDP_Context_from_modem_to_driver
-test_modem_app('modem_send_at_cmd', 3, '+CGDCONT: 1,''IPV4V6'',''.cxn'',,0,0,0,0,0,,0,,,,','+CGDCONT: 2,''IPV4V6'',,,0,0,0,0,0,,0,,,,' , 'OK');% wrong APN
+test_modem_app('modem_send_at_cmd', 11, '+CGDCONT: 1,''IPV4V6'',''.cxn'',,0,0,0,0,0,,0,,,,','+CGDCONT: 2,''IPV4V6'',,,0,0,0,0,0,,0,,,,', '+KBNDCFG: 0,000000000000000A0A188E','+KBNDCFG: , ', '+KBNDCFG: 2,0', '+KSELACQ: ', '+CEREG: 2,0', '+CFUN: 0', '+KBND:1,', '+CCID: +491747365135', 'OK');% wrong APN, +KBNDCFG:, +KSELACQ: and no LTE band
 assert(test_modem_app('check_last_received_at_cmd','AT+CGDCONT=1,IPV4V6,"''internet.cxn''",,0,0,0,0,0,,0,,,,,') == 1);
 test_modem_app('modem_send_at_cmd', 3, '+CGDCONT: 1,''IPV4V6'',"''intet.cxn''",,0,0,0,0,0,,0,,,,','+CGDCONT: 2,''IPV4V6'',,,0,0,0,0,0,,0,,,,' , 'OK');% wrong APN
 assert(test_modem_app('check_last_received_at_cmd','AT+CGDCONT=1,IPV4V6,"''internet.cxn''",,0,0,0,0,0,,0,,,,,') == 1);
@@ -48,8 +45,6 @@ test_modem_app('modem_send_at_cmd', 4, '+KBNDCFG: 0,000000000000000A0A1880','+KB
 assert(test_modem_app('check_last_received_at_cmd','AT+KBNDCFG=0,000000000000000A0A188E') == 1);
 test_modem_app('modem_send_at_cmd', 4, '+KBNDCFG: 0,000000000000000A0A188E','+KBNDCFG: 1,0000000000000000080084', '+KBNDCFG: 2,0' , 'OK');
 %% Test 3: injecting_wrong_RAT_Response_from_modem_to_driver
-assert(test_modem_app('check_last_received_at_cmd','AT+KSELACQ?') == 1);
-test_modem_app('modem_send_at_cmd', 2, '+KSELACQ: ','OK'); %wrong +KSELACQ:
 assert(test_modem_app('check_last_received_at_cmd','AT+KSELACQ=0,2,1') == 1);% need to set +KSELACQ
 test_modem_app('modem_send_at_cmd', 2, '+KSELACQ: 2,1','OK');% reset needed after configuring
 test_modem_app('modem_reset');
@@ -57,44 +52,60 @@ assert(test_modem_app('check_last_received_at_cmd','AT') == 1);
 test_modem_app('modem_send_at_cmd', 2, 'AT', 'OK');
 
 
-assert(test_modem_app('check_last_received_at_cmd','AT+CEREG?') == 1);
-test_modem_app('modem_send_at_cmd', 2, '+CEREG: 2,0','OK');
-assert(test_modem_app('check_last_received_at_cmd','AT+CFUN?') == 1);
-test_modem_app('modem_send_at_cmd', 2, '+CFUN: 0','OK');
 %% Test 4: Giving_no_LTE_band_Response_from_modem_to_driver
 assert(test_modem_app('check_last_received_at_cmd','AT+KBND?') == 1);
 test_modem_app('modem_send_at_cmd', 2, '+KBND:1,','OK');% no LTE Band Resopnse from modem
 assert(test_modem_app('check_last_received_at_cmd','AT+KBND?') == 1);
 test_modem_app('modem_send_at_cmd', 2, '+KBND: 1,0000000000000000080084','OK');
 
-assert(test_modem_app('check_last_received_at_cmd','AT+CCID') == 1);
-test_modem_app('modem_send_at_cmd', 2, '+CCID: +491747365135','OK');
-test_modem_app('timer_modem_next_action');
+test_modem_app('timer_modem_watchdog');
 assert(test_modem_app('check_last_received_at_cmd','AT+CFUN=1,1') == 1);
 test_modem_app('modem_send_at_cmd', 4, 'AT+CFUN=1,1','OK','+CEREG: 2','+WDSI: 0');
 test_modem_app('set_cts');
 assert(test_modem_app('check_last_received_at_cmd','AT') == 1);
-test_modem_app('modem_send_at_cmd', 7, 'AT', 'OK','+CEREG: 2','+CEREG: 0','+CEREG: 2','+CEREG: 2','+CEREG: 5,"DAD9","01AF8F0D",9');
+test_modem_app('modem_send_at_cmd', 8, 'AT', 'OK','+CEREG: 2','+CEREG: 0','+CEREG: 2','+CEREG: 2','+CEREG: 5','+CEREG: 5,"DAD9","01AF8F0D",9');
 test_modem_app('modem_reset');
 assert(test_modem_app('check_last_received_at_cmd','AT') == 1);
 test_modem_app('modem_send_at_cmd', 2, 'AT', 'OK');
 
-assert(test_modem_app('check_last_received_at_cmd','AT+CGDCONT?') == 1);
-test_modem_app('modem_send_at_cmd', 3, '+CGDCONT: 1,''IPV4V6'',''internet.cxn'',,0,0,0,0,0,,0,,,,','+CGDCONT: ",''IPV4V6'',,,0,0,0,0,0,,0,,,,' , 'OK');
-assert(test_modem_app('check_last_received_at_cmd','AT+KBND?') == 1);
-test_modem_app('modem_send_at_cmd', 3,'AT+KBND?','+KBND: 1,0000000000000000000080', 'OK');
+%% Test 5: the AT timeout starts when the last byte of the command left the uart
+test_modem_app('set_uart_tx_hold', 1);
+assert(test_modem_app('check_last_received_at_cmd','AT+CGDCONT?;+KBND?') == 1);
+test_modem_app('modem_send_at_cmd', 5, 'AT+CGDCONT?;+KBND?', '+CGDCONT: 1,''IPV4V6'',''internet.cxn'',,0,0,0,0,0,,0,,,,','+CGDCONT: ",''IPV4V6'',,,0,0,0,0,0,,0,,,,', '+KBND: 1,0000000000000000000080', 'OK');
 assert(test_modem_app('check_last_received_at_cmd','AT+CESQ') == 1);
+assert(test_modem_app('check_at_timeout_running') == 0);
+test_modem_app('set_uart_flow_stop', 1);
+assert(test_modem_app('uart_tx_drain', 64) == 0);% paused by the modem
+test_modem_app('set_uart_flow_stop', 0);
+assert(test_modem_app('uart_tx_drain', 4) == 4);
+assert(test_modem_app('check_at_timeout_running') == 0);
+assert(test_modem_app('uart_tx_drain', 64) == 4);% AT+CESQ<CR>
+assert(test_modem_app('check_at_timeout_running') == 1);
+test_modem_app('set_uart_tx_hold', 0);
 test_modem_app('modem_send_at_cmd', 3, 'AT+CESQ','+CESQ: 99,99,255,255,20,39','OK');
-test_modem_app('timer_modem_next_action');
+test_modem_app('timer_modem_watchdog');
 assert(test_modem_app('check_last_received_at_cmd','AT+KCNXCFG=1,"GPRS","''internet.cxn''"') == 1);
 test_modem_app('modem_send_at_cmd', 2, 'AT+KCNXCFG=1,"GPRS","''internet.cxn''"','OK');
 assert(test_modem_app('check_last_received_at_cmd','AT+KUDPCFG=1,0') == 1);%need to stub connection type as UDP before this step
+test_modem_app('queue_tx_frame', 'AABBCC', 1, 0);% tag 1, sent before the empty frame (tag 0) the app queues by default
+test_modem_app('queue_tx_frame', '0102', 0, 10);% tag 2, expires while tag 1 is sent
 test_modem_app('modem_send_at_cmd', 5, 'AT+KUDPCFG=1,0','+KUDPCFG: 1','OK','+KCNX_IND: 1,1,0','+KUDP_IND: 1,1');
-% Test 3: Modem Data Transfer
-assert(test_modem_app('check_last_received_at_cmd','AT+KUDPSND=1,"199.64.78.128",4154,0') == 1);%need to stub  uint8_t *modem_queuedTxPkg = (int *)50 from NULL
+% Test 3: Modem Data Transfer, the queued frames go out back to back by priority
+assert(test_modem_app('check_last_received_at_cmd','AT+KUDPSND=1,"199.64.78.128",4154,3') == 1);
+test_modem_app('modem_send_at_cmd', 2, 'AT+KUDPSND=1,"199.64.78.128",4154,3','CONNECT');
+test_modem_app('advance_time', 20);
+test_modem_app('modem_send_at_cmd', 1, 'OK');
+assert(test_modem_app('check_last_received_at_cmd','AT+KUDPSND=1,"199.64.78.128",4154,0') == 1);
+test_modem_app('set_rx_read_size', 20);% the 51 announced bytes are read in three chunks, the first byte of each chunk stands for the LF after CONNECT
 test_modem_app('modem_send_at_cmd', 4, 'AT+KUDPSND=1,"199.64.78.128",4154,0','CONNECT','OK','+KUDP_DATA: 1,51');
-assert(test_modem_app('check_last_received_at_cmd','AT+KUDPRCV=1,51') == 1);
-test_modem_app('modem_send_at_cmd', 5, 'AT+KUDPRCV=1,51','CONNECT','00 01 00 10 00 01 00 2b 60 29 a1 09 06 07 60 85 74 05 08 01 01 a6 0a 04 08 45 49 43 54 43 4f 4d 4d be 10 04 0e 01 00 00 00 06 5f 1f 04 00 00 7e 1f 10 00 --EOF--Pattern--','OK','+KUDP_RCV: "199.64.78.128",4154');
+assert(test_modem_app('check_tx_done', '1s,2e,0s') == 1);
+assert(test_modem_app('check_last_received_at_cmd','AT+KUDPRCV=1,20') == 1);
+test_modem_app('modem_send_at_cmd', 4, 'AT+KUDPRCV=1,20','CONNECT',' 00 01 00 10 00 01 00--EOF--Pattern--','OK');
+assert(test_modem_app('check_last_received_at_cmd','AT+KUDPRCV=1,20') == 1);
+test_modem_app('modem_send_at_cmd', 4, 'AT+KUDPRCV=1,20','CONNECT','  2b 60 29 a1 09 06 0--EOF--Pattern--','OK');
+assert(test_modem_app('check_last_received_at_cmd','AT+KUDPRCV=1,11') == 1);
+test_modem_app('modem_send_at_cmd', 5, 'AT+KUDPRCV=1,11','CONNECT',' 7 60 85 74 --EOF--Pattern--','OK','+KUDP_RCV: "199.64.78.128",4154');
+assert(test_modem_app('check_rx_frame', '00 01 00 10 00 01 00 2b 60 29 a1 09 06 07 60 85 74 ') == 1);
 assert(test_modem_app('check_last_received_at_cmd','AT+CESQ') == 1);
 test_modem_app('modem_send_at_cmd', 3, 'AT+CESQ','+CESQ: 99,99,255,255,19,40','OK');
 % Test 4: Modem UDP session closing
@@ -118,9 +129,63 @@ test_modem_app('modem_send_at_cmd', 2, 'AT', 'OK');
 assert(test_modem_app('check_last_received_at_cmd','AT+CFUN?') == 1);
 test_modem_app('modem_send_at_cmd', 3, 'AT+CFUN?','+CFUN: 4', 'OK');
 
-test_modem_app('timer_modem_next_action');
+test_modem_app('timer_modem_watchdog');
 assert(test_modem_app('check_last_received_at_cmd','AT+CPOF') == 1);
 test_modem_app('modem_send_at_cmd', 2, 'AT+CPOF', 'OK');
-test_modem_app('timer_modem_next_action');
+test_modem_app('timer_modem_watchdog');
 
 
+
+%% Test 6: warm start, the identity of the last power up is confirmed by the firmware release and the IMEI alone
+test_modem_app('switch_modem_on');
+test_modem_app('modem_send_at_cmd', 2, 'AT', 'OK');
+assert(test_modem_app('check_last_received_at_cmd','AT+CGMR;+CGSN') == 1);
+test_modem_app('modem_send_at_cmd', 4, 'AT+CGMR;+CGSN', 'HL7810.4.6.9.4', '354720510148914', 'OK');
+assert(test_modem_app('check_last_received_at_cmd','AT+CFUN?;+KBND?') == 1);% the configuration fingerprint matches, no configuration reads
+test_modem_app('switch_modem_on');
+test_modem_app('modem_send_at_cmd', 2, 'AT', 'OK');
+assert(test_modem_app('check_last_received_at_cmd','AT+CGMR;+CGSN') == 1);
+test_modem_app('modem_send_at_cmd', 4, 'AT+CGMR;+CGSN', 'HL7810.4.7.0.0', '354720510148914', 'OK');
+assert(test_modem_app('check_last_received_at_cmd','AT+CGDCONT?;+KBNDCFG?;+KSELACQ?;+CEREG?;+CFUN?;+KBND?') == 1);% a firmware update is verified in full
+%% Test 7: warm start with another modem, the identity is read again
+test_modem_app('switch_modem_on');
+test_modem_app('modem_send_at_cmd', 2, 'AT', 'OK');
+assert(test_modem_app('check_last_received_at_cmd','AT+CGMR;+CGSN') == 1);
+test_modem_app('modem_send_at_cmd', 4, 'AT+CGMR;+CGSN', 'HL7810.4.6.9.4', '354720510148922', 'OK');
+assert(test_modem_app('check_last_received_at_cmd','ATI;+CGMR;+KGSN=3') == 1);
+test_modem_app('modem_send_at_cmd', 5, 'ATI;+CGMR;+KGSN=3', 'HL7810', 'HL7810.4.6.9.4', '+KGSN: D13062105213B2', 'OK');
+assert(test_modem_app('check_last_received_at_cmd','AT+CGDCONT?;+KBNDCFG?;+KSELACQ?;+CEREG?;+CFUN?;+KBND?;+CCID') == 1);% the fingerprint of another modem does not match
+%% Test 8: registration pipeline, the radio is activated once the configuration is verified
+test_modem_app('set_registration_pipeline', 1);
+test_modem_app('switch_modem_on');
+test_modem_app('modem_send_at_cmd', 2, 'AT', 'OK');
+assert(test_modem_app('check_last_received_at_cmd','AT+CGMR;+CGSN') == 1);
+test_modem_app('modem_send_at_cmd', 4, 'AT+CGMR;+CGSN', 'HL7810.4.6.9.4', '354720510148922', 'OK');
+assert(test_modem_app('check_last_received_at_cmd','AT+CGDCONT?;+KBNDCFG?;+KSELACQ?;+CEREG?') == 1);
+test_modem_app('modem_send_at_cmd', 9, 'AT+CGDCONT?;+KBNDCFG?;+KSELACQ?;+CEREG?', '+CGDCONT: 1,''IPV4V6'',''internet.cxn'',,0,0,0,0,0,,0,,,,', '+CGDCONT: 2,''IPV4V6'',,,0,0,0,0,0,,0,,,,', '+KBNDCFG: 0,000000000000000A0A188E', '+KBNDCFG: 1,0000000000000000080084', '+KBNDCFG: 2,0', '+KSELACQ: 2,1,0', '+CEREG: 2,0', 'OK');
+assert(test_modem_app('check_last_received_at_cmd','AT+CFUN=1,1') == 1);
+test_modem_app('modem_send_at_cmd', 3, 'AT+CFUN=1,1', 'OK', '+CEREG: 2');
+test_modem_app('modem_reset');% the modem restarts
+assert(test_modem_app('check_last_received_at_cmd','AT') == 1);
+test_modem_app('modem_send_at_cmd', 2, 'AT', 'OK');
+assert(test_modem_app('check_last_received_at_cmd','AT+KBND?') == 1);% read while the modem searches
+test_modem_app('modem_send_at_cmd', 4, 'AT+KBND?', '+KBND: 1,0000000000000000000000', 'OK', '+CEREG: 5,''DAD9'',''01AF8F0D'',9');
+assert(test_modem_app('check_last_received_at_cmd','AT+CGDCONT?;+KBND?') == 1);
+test_modem_app('set_registration_pipeline', 0);
+%% Test 9: PSM, the session ends in PSM and the next one sends without restarting the radio (simulated modem)
+assert(test_modem_app('check_psm_session', 0) == 1);
+assert(test_modem_app('check_psm_session', 1) == 1);% the network denies PSM, the modem is powered off
+assert(test_modem_app('check_psm_entry_wait', '00100011', 180) == 1);% 3 min
+assert(test_modem_app('check_psm_entry_wait', '01100010', 120) == 1);% undefined unit, 2 min
+%% Test 10: charge per hourly report and delay to the uplink, PSM against the power off cycle
+assert(test_modem_app('check_psm_energy', 3600) == 1);
+%% Test 11: frames which cannot be sent are reported as failed instead of staying queued (simulated modem)
+assert(test_modem_app('check_tx_failed') == 1);
+%% Test 12: downlinks larger than 1 KB are received in one read or reassembled from chunks (simulated modem)
+assert(test_modem_app('check_rx_downlink', 1200, 1024) == 1);
+assert(test_modem_app('check_rx_downlink', 1400, 1500) == 1);
+assert(test_modem_app('check_rx_downlink', 1500, 196) == 1);
+assert(test_modem_app('check_rx_downlink', 2000, 1500) == 1);% too large, read and dropped
+%% Test 13: release assistance on the last uplink, the radio is released without the inactivity timer (simulated modem)
+assert(test_modem_app('check_tx_release', 3600) == 1);
+assert(test_modem_app('check_tx_release_reply', 51) == 1);% the session ends with the single reply
@@ -28,3 +28,7 @@ Project level includes
     MAKE_UMI_CODE(200UL, 2UL, 64UL, 6UL)
 #define UMI_CODE_MODEM_EVENT_FIFO \
     MAKE_UMI_CODE(200UL, 2UL, 64UL, 7UL)
+#define UMI_CODE_MODEM_AT_LATENCY \
+    MAKE_UMI_CODE(200UL, 2UL, 64UL, 8UL)
+#define UMI_CODE_MODEM_CFG_FINGERPRINT \
+    MAKE_UMI_CODE(200UL, 2UL, 64UL, 9UL)
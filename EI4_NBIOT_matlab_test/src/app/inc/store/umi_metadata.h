@@ -45,7 +45,10 @@ typedef struct
     egm_uint8_t rat1;
     egm_uint8_t rat2;
     egm_uint8_t rat3;
-    egm_uint8_t padding;
+    egm_uint8_t psm_mode;
+    egm_uint8_t psm_periodic_tau[12];
+    egm_uint8_t psm_active_time[12];
+    egm_uint8_t edrx_value[8];
 } umi_modem_cfg_native_object_t;
 #define UMI_STRUCT_MODEM_CFG_ACCESS_POINT_NAME	MAKE_MEMBER_INDEX(0U)
 #define UMI_STRUCT_MODEM_CFG_ACCESS_POINT_NAME_SIZE	MAKE_MEMBER_SIZE(64U)
@@ -71,9 +74,15 @@ typedef struct
 #define UMI_STRUCT_MODEM_CFG_RAT2_SIZE	MAKE_MEMBER_SIZE(1U)
 #define UMI_STRUCT_MODEM_CFG_RAT3	MAKE_MEMBER_INDEX(11U)
 #define UMI_STRUCT_MODEM_CFG_RAT3_SIZE	MAKE_MEMBER_SIZE(1U)
-#define UMI_STRUCT_MODEM_CFG_PADDING	MAKE_MEMBER_INDEX(12U)
-#define UMI_STRUCT_MODEM_CFG_PADDING_SIZE	MAKE_MEMBER_SIZE(1U)
-#define UMI_STRUCT_MODEM_CFG__MEMBER_COUNT	MAKE_MEMBER_INDEX(13U)
+#define UMI_STRUCT_MODEM_CFG_PSM_MODE	MAKE_MEMBER_INDEX(12U)
+#define UMI_STRUCT_MODEM_CFG_PSM_MODE_SIZE	MAKE_MEMBER_SIZE(1U)
+#define UMI_STRUCT_MODEM_CFG_PSM_PERIODIC_TAU	MAKE_MEMBER_INDEX(13U)
+#define UMI_STRUCT_MODEM_CFG_PSM_PERIODIC_TAU_SIZE	MAKE_MEMBER_SIZE(12U)
+#define UMI_STRUCT_MODEM_CFG_PSM_ACTIVE_TIME	MAKE_MEMBER_INDEX(14U)
+#define UMI_STRUCT_MODEM_CFG_PSM_ACTIVE_TIME_SIZE	MAKE_MEMBER_SIZE(12U)
+#define UMI_STRUCT_MODEM_CFG_EDRX_VALUE	MAKE_MEMBER_INDEX(15U)
+#define UMI_STRUCT_MODEM_CFG_EDRX_VALUE_SIZE	MAKE_MEMBER_SIZE(8U)
+#define UMI_STRUCT_MODEM_CFG__MEMBER_COUNT	MAKE_MEMBER_INDEX(16U)
 
 
 /* Declaration of the structure umi_modem_stats_native_object_t. */
@@ -191,3 +200,32 @@ typedef struct
 #define UMI_STRUCT_MODEM_EVENT_FIFO_DATA_SIZE	MAKE_MEMBER_SIZE(2U)
 #define UMI_STRUCT_MODEM_EVENT_FIFO__MEMBER_COUNT	MAKE_MEMBER_INDEX(5U)
 
+
+/* Declaration of the structure umi_modem_at_latency_native_object_t. */
+typedef struct
+{
+    egm_uint16_t ewma[8];
+    egm_uint16_t histogram[8][14];
+} umi_modem_at_latency_native_object_t;
+#define UMI_STRUCT_MODEM_AT_LATENCY_EWMA	MAKE_MEMBER_INDEX(0U)
+#define UMI_STRUCT_MODEM_AT_LATENCY_EWMA_SIZE	MAKE_MEMBER_SIZE(16U)
+#define UMI_STRUCT_MODEM_AT_LATENCY_HISTOGRAM	MAKE_MEMBER_INDEX(1U)
+#define UMI_STRUCT_MODEM_AT_LATENCY_HISTOGRAM_SIZE	MAKE_MEMBER_SIZE(224U)
+#define UMI_STRUCT_MODEM_AT_LATENCY__MEMBER_COUNT	MAKE_MEMBER_INDEX(2U)
+
+
+/* Declaration of the structure umi_modem_cfg_fingerprint_native_object_t. */
+typedef struct
+{
+    egm_uint32_t cfg_hash;
+    egm_uint8_t imei[32];
+    egm_uint8_t SW_release[32];
+} umi_modem_cfg_fingerprint_native_object_t;
+#define UMI_STRUCT_MODEM_CFG_FINGERPRINT_CFG_HASH	MAKE_MEMBER_INDEX(0U)
+#define UMI_STRUCT_MODEM_CFG_FINGERPRINT_CFG_HASH_SIZE	MAKE_MEMBER_SIZE(4U)
+#define UMI_STRUCT_MODEM_CFG_FINGERPRINT_IMEI	MAKE_MEMBER_INDEX(1U)
+#define UMI_STRUCT_MODEM_CFG_FINGERPRINT_IMEI_SIZE	MAKE_MEMBER_SIZE(32U)
+#define UMI_STRUCT_MODEM_CFG_FINGERPRINT_SW_RELEASE	MAKE_MEMBER_INDEX(2U)
+#define UMI_STRUCT_MODEM_CFG_FINGERPRINT_SW_RELEASE_SIZE	MAKE_MEMBER_SIZE(32U)
+#define UMI_STRUCT_MODEM_CFG_FINGERPRINT__MEMBER_COUNT	MAKE_MEMBER_INDEX(3U)
+
@@ -22,6 +22,7 @@ Required header files
 #include <os/rtc.h>
 
 #include <stdint.h>
+#include <stddef.h>
 
 #include <os/error.h>
 
@@ -32,11 +33,49 @@ Public defines
 #define RAT_NB_IOT  1
 #define RAT_GSM 2
 
+/* uplink frames queued at a time, their payloads share a 1024 byte buffer */
+#define MODEM_TX_QUEUE_FRAMES       8U
+/* sessions a frame stays queued for before it is dropped as failed */
+#define MODEM_TX_SESSIONS_MAX       3U
+#define MODEM_TX_PRIORITY_NORMAL    0U
+
+/* fragments of a payload queued by Modem_QueueTxPayload(), header included.
+   Only fragments start with the marker, Modem_QueueTxFrameEx() refuses a
+   frame starting with it, so the head-end can tell both apart. */
+#define MODEM_TX_FRAGMENT_LEN           1024U
+#define MODEM_TX_FRAGMENT_HDR_LEN       4U
+#define MODEM_TX_FRAGMENT_PAYLOAD_LEN   (MODEM_TX_FRAGMENT_LEN - MODEM_TX_FRAGMENT_HDR_LEN)
+#define MODEM_TX_FRAGMENT_MARKER        0xF7U
+
+/* bytes per AT+KUDPRCV/AT+KTCPRCV, the HL7810 takes up to 1500 */
+#define MODEM_RX_READ_SIZE_MAX          1500U
+#define MODEM_RX_READ_SIZE_DEFAULT      1024U
+
 /*-----------------------------------------------------------------------------
 Public data types
 -----------------------------------------------------------------------------*/
 /* Callback function pointer for modem comms */
 typedef void(*Modem_CommunicationFinishedCb)(egm_error_t result);
+enum modem_tx_result_e
+{
+    modem_tx_result_sent,
+    modem_tx_result_expired, /* lifetime passed before it could be sent */
+    modem_tx_result_failed, /* rejected by the modem or not sent within MODEM_TX_SESSIONS_MAX sessions */
+};
+
+/* release assistance indication for the final uplink of a session (3GPP 24.301),
+   the values are the <rai> parameter of AT+KUDPSND */
+enum modem_tx_release_e
+{
+    modem_tx_release_none = 0, /* more data may follow */
+    modem_tx_release_no_reply = 1, /* no further uplink or downlink data */
+    modem_tx_release_single_reply = 2, /* only a single downlink reply expected */
+};
+
+/* Callback function pointer for queued uplink frames, tag as passed to Modem_QueueTxFrameEx() */
+typedef void(*Modem_TxFrameDoneCb)(uint16_t tag, enum modem_tx_result_e result);
+/* Callback function pointer for streamed rx frames, last marks the final chunk */
+typedef void(*Modem_RxChunkCb)(const uint8_t *p, size_t len, bool last);
 
 struct pdp_context_s
 {
@@ -108,6 +147,9 @@ enum modem_state_e
     modem_state_powered_down_wait_for_cts_low = 9, /*!< SHTDWN: power down request sent (AT) and waiting for modem to turn off */
     modem_state_powered_off = 10, /*!< OFF: Powered off by at command (no wakeup possible) */
     modem_state_hold_reset = 11, /*!< RST: Hold in reset, caused by fatal error */
+    modem_state_psm_entry_wait_for_cts_high = 12, /*!< PSM: session done, waiting for the attached modem to fall asleep */
+    modem_state_psm = 13, /*!< PSM: modem sleeps in power saving mode and stays attached */
+    modem_state_psm_exit_wait_for_cts_low = 14, /*!< WAKE: wake up pin asserted, waiting for the modem to wake up */
 };
 /* auto gen end */
 
@@ -139,10 +181,25 @@ enum modem_test_case_e
 };
 /* auto gen end */
 
+/*
+ * auto gen start
+ * type="enum modem_psm_mode_e"
+ * catalog="../umi/obj_catalog/common/elster_umi_objects_all_catalog.xml"
+ * object="MODEM_CFG.psm_mode"
+ * prefix="modem_psm_mode_"
+ */
+enum modem_psm_mode_e
+{
+    modem_psm_mode_off = 0, /*!< power off the modem after each session */
+    modem_psm_mode_psm = 1, /*!< keep the modem attached and sleeping in PSM between sessions */
+    modem_psm_mode_psm_edrx = 2, /*!< PSM, eDRX paging while the active timer runs */
+};
+/* auto gen end */
+
 /*-----------------------------------------------------------------------------
  Public Data
  -----------------------------------------------------------------------------*/
-extern const char *modem_state_descr[12];
+extern const char *modem_state_descr[15];
 extern const char *modem_error_descr[12];
 extern const char *modem_rat_descr[4];
 
@@ -154,6 +211,7 @@ egm_error_t Modem_DeInit(void);
 
 /* events */
 void Modem_NextAction(void);
+void Modem_Watchdog(void);
 void Modem_RtsChanged(void);
 void Modem_AtReqTimeout(void);
 
@@ -164,7 +222,16 @@ bool Modem_DropRx(void);
 void Modem_StartProcess(Modem_CommunicationFinishedCb pCallback, bool request_to_send);
 
 void Modem_QueueTxFrame(const uint8_t *b, uint16_t bs);
+bool Modem_QueueTxFrameEx(const uint8_t *b, uint16_t bs, uint8_t priority, uint32_t lifetime_s, Modem_TxFrameDoneCb cb, uint16_t tag);
+bool Modem_QueueTxPayload(const uint8_t *b, uint32_t bs, uint8_t priority, uint32_t lifetime_s, Modem_TxFrameDoneCb cb, uint16_t tag);
+uint8_t Modem_TxFramesQueued(void);
 void Modem_GetLastRxFrame(uint8_t *b, uint16_t *bs);
+bool Modem_PeekRxFrame(const uint8_t **p, uint16_t *len);
+void Modem_ReleaseRxFrame(void);
+void Modem_SetRxChunkCb(Modem_RxChunkCb cb);
+void Modem_SetRxReadSize(uint16_t size);
+void Modem_SetRegistrationPipeline(bool enable);
+void Modem_SetTxRelease(enum modem_tx_release_e release);
 void Modem_GetConfigurationFromUmi(void);
 void Modem_RequestToSend(void);
 void Modem_Wakeup(void);
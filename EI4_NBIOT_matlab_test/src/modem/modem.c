@@ -37,6 +37,8 @@ Project level includes
 
 #include <modem/modem.h>
 
+#include <store/umi_metadata.h>
+
 #ifdef CONSOLE_ENABLED
 #include <modem/modem_console.h>
 #endif
@@ -49,7 +51,9 @@ Local includes
 #include <modem_umi.h>
 #include <modem_cmd.h>
 #include <modem_stats.h>
+#include <modem_latency.h>
 #include <modem_debug.h>
+#include <modem_log.h>
 
 /*-----------------------------------------------------------------------------
 Public data
@@ -62,7 +66,7 @@ Public data
  * object="MODEM_STATS.current_state"
  * prefix="_"
  */
-const char *modem_state_descr[12] =
+const char *modem_state_descr[15] =
 {
     "N/A", /*!< Modem driver not initialized */
     "OFF", /*!< Modem stays in initial powered off state */
@@ -76,6 +80,9 @@ const char *modem_state_descr[12] =
     "SHTDWN", /*!< power down request sent (AT) and waiting for modem to turn off */
     "OFF", /*!< Powered off by at command (no wakeup possible) */
     "RST", /*!< Hold in reset, caused by fatal error */
+    "PSM", /*!< session done, waiting for the attached modem to fall asleep */
+    "PSM", /*!< modem sleeps in power saving mode and stays attached */
+    "WAKE", /*!< wake up pin asserted, waiting for the modem to wake up */
 };
 /* auto gen end */
 
@@ -134,7 +141,8 @@ Private defines
 #define MODEM_MAX_ACTION_RETRIES_WAIT_FOR_CTS_LOW 20U
 
 #define EX_TX_BUFFER_SIZE 1024
-#define EX_RX_BUFFER_SIZE 1024
+/* a downlink frame read in several chunks, up to the largest single read */
+#define EX_RX_BUFFER_SIZE MODEM_RX_READ_SIZE_MAX
 #define MODEM_HW_RESET_IN_N_ASSERTION_TIME_MIN_US   100U /* table 4-10 */
 #define PKG_FRAME_SIZE 4096
 
@@ -146,7 +154,14 @@ Private defines
 
 #define MODEM_TCP_UDP_STATUS_NOTIF_DATA_SENDING_OK_INV_LEN  8
 
-#define MODEM_NEXT_ACTION_TIMER_PERIOD_MS 1000U
+#define MODEM_WATCHDOG_TIMER_PERIOD_MS 1000U
+#define MODEM_INFO_BATCH_CMDS_MAX   8U
+#define MODEM_CFG_HASH_BASIS    2166136261UL /* FNV-1a */
+#define MODEM_CFG_HASH_PRIME    16777619UL
+/* the modem falls asleep after the RRC release and the active timer */
+#define MODEM_PSM_ENTRY_MARGIN_S    30U
+#define MODEM_ACTION_RETRIES_PSM_EXIT   5U
+#define MODEM_KSELACQ_RAT_CAT_M1    1U
 
 #define STRCMP_EQUAL    0
 
@@ -200,6 +215,10 @@ enum modem_action_e
     modem_action_close_session = 34, /*!< session will be closed */
     modem_action_delete_session = 35, /*!< existing session will be deleted */
     modem_action_request_factory_serial_number = 36, /*!< request factory serial number */
+    modem_action_read_info_batch = 37, /*!< read missing values with one compound command */
+    modem_action_set_psm = 38, /*!< request PSM (and eDRX) timers, AT+CPSMS/AT+CEDRXS */
+    modem_action_enter_psm = 39, /*!< release the wake up pin, wait until the modem sleeps */
+    modem_action_exit_psm = 40, /*!< assert the wake up pin, wait until the modem is awake */
 };
 /* auto gen end */
 
@@ -293,6 +312,19 @@ static bool Modem_FunctionalityIsNotOff(void);
 static bool Modem_FunctionalityIsFull(void);
 static void Modem_NotReadyWaitForCts(void);
 static void Modem_CloseSession(uint8_t session_id);
+static bool Modem_CheckWarmIdentity(void);
+static uint32_t Modem_CfgHashAdd(uint32_t hash, const void *data, size_t len);
+static uint32_t Modem_CfgHash(void);
+static bool Modem_CfgVerified(void);
+static void Modem_CfgFingerprint(void);
+static bool Modem_RadioOnPending(void);
+static uint32_t Modem_PsmActiveTimeS(void);
+static bool Modem_PsmWanted(void);
+static bool Modem_PsmEntryPossible(void);
+static void Modem_PsmLost(void);
+static void Modem_SessionTimeoutStart(void);
+static bool Modem_ReadInfoBatch(void);
+static void Modem_ReadInfoBatchDone(enum modem_at_result_e result);
 static bool Modem_ReadData(void);
 static bool Modem_IsStartupRequired(void);
 static bool Modem_NoMoreActionsRequired(void);
@@ -308,6 +340,17 @@ static void Modem_RequestPowerDown(void);
 static void Modem_StopProcess(void);
 static uint8_t Modem_GetBandFromStr(void);
 static void Modem_SetupRetries(void);
+static void Modem_RawDataConsumed(uint16_t len);
+static void Modem_SignalQualityReadDone(enum modem_at_result_e result);
+static void Modem_TxQueueRemove(uint8_t idx, enum modem_tx_result_e result);
+static void Modem_TxQueueExpire(void);
+static void Modem_TxQueueSessionEnd(void);
+static bool Modem_TxQueueHeadLocked(void);
+static struct modem_tx_frame_s *Modem_TxQueueInsert(uint8_t priority, uint32_t lifetime_s, Modem_TxFrameDoneCb cb, uint16_t tag);
+static void Modem_SendTxQueueHead(void);
+static void Modem_RawDataFrameDone(void);
+static void Modem_ReadPendingRx(void);
+static void Modem_ReadPendingRxDone(enum modem_at_result_e result);
 
 /*-----------------------------------------------------------------------------
 Private data - declare static
@@ -348,25 +391,82 @@ static uint32_t action_retry_first = 0;
 static enum modem_session_state_e modemSessionState[6] = {modem_session_state_closed, modem_session_state_closed, modem_session_state_closed, modem_session_state_closed, modem_session_state_closed, modem_session_state_closed};
 
 
+/* uplink frames, ordered by priority and FIFO within a priority. The
+   payloads are packed into ex_tx_buffer in the order they were queued,
+   a fragmented payload stays in the buffer of the application. */
+struct modem_tx_frame_s
+{
+    uint16_t offset;
+    uint16_t len;           /* bytes in ex_tx_buffer, 0 for a fragmented payload */
+    const uint8_t *ext;     /* fragmented payload, NULL for a frame */
+    uint32_t ext_len;
+    uint8_t frag;           /* next fragment to send */
+    uint8_t frag_count;
+    uint8_t msg_id;
+    uint8_t priority;
+    uint16_t tag;
+    uint32_t expiry; /* uptime in seconds, 0: never */
+    uint8_t sessions; /* ended without the frame being sent */
+    Modem_TxFrameDoneCb cb;
+};
+
 static uint8_t ex_tx_buffer[EX_TX_BUFFER_SIZE];
+static struct modem_tx_frame_s tx_queue[MODEM_TX_QUEUE_FRAMES];
+static uint8_t tx_queue_count = 0U;
+static uint16_t tx_queue_bytes = 0U;
+/* tx_queue[0] is handed to the AT layer, its payload must not move */
+static bool tx_in_flight = false;
+static uint8_t tx_frag_hdr[MODEM_TX_FRAGMENT_HDR_LEN];
+static uint8_t tx_msg_id = 0U;
 
 #if 0
 static uint8_t dlmsRsp[] = {0x00, 0x01, 0x00, 0x01, 0x00, 0x10, 0x00, 0x2B, 0x61, 0x29, 0xA1, 0x09, 0x06, 0x07, 0x60, 0x85, 0x74, 0x05, 0x08, 0x01, 0x01, 0xA2, 0x03, 0x02, 0x01, 0x00, 0xA3, 0x05, 0xA1, 0x03, 0x02, 0x01, 0x00, 0xBE, 0x10, 0x04, 0x0E, 0x08, 0x00, 0x06, 0x5F, 0x1F, 0x04, 0x00, 0x00, 0x12, 0x1C, 0x03, 0x84, 0x00, 0x07};
 #endif
 
-//static uint8_t *modem_queuedTxPkg = NULL;
-static uint16_t modem_queuedTxPkgLen = 0U;
-static uint8_t *modem_queuedTxPkg = (int *)50;
 
 static bool pushInfoToUmi = true;
+/* compound reads failed, fall back to single commands until the next power up */
+static bool info_batch_failed = false;
+static bool info_batch_identity = false;
+static bool info_batch_bands = false;
+/* identity restored from the store, confirmed by AT+CGMR;+CGSN once per power up */
+static bool identity_warm = false;
+static char identity_imei[sizeof(modemInfo.imei)];
+/* configuration reads skipped, the modem is set up as verified before */
+static bool cfg_fingerprint_checked = false;
+static bool cfg_fingerprint_valid = false;
+/* radio activation right after the configuration, see Modem_SetRegistrationPipeline() */
+static bool registration_pipeline = false;
+/* release assistance for the last frame of the session, see Modem_SetTxRelease() */
+static enum modem_tx_release_e tx_release = modem_tx_release_none;
+/* the last frame went out with release assistance, the session ends with the reply */
+static bool tx_release_sent = false;
+/* power saving mode, AT+CPSMS is sent once per reset, a modem not falling
+   asleep is powered off after each session until the next init */
+static bool psm_configured = false;
+static bool psm_rejected = false;
 static bool modem_want_read_signal_quality = false;
+/* repeated write requests of one setting, counted per session */
+static enum modem_action_e lastSetAction = modem_action_none;
+static uint16_t setRetry = 0;
 
 static bool cfgWritten = false;
 static uint8_t retryTimer = 0;
 
-/* last rx frame */
-static uint8_t ex_rx_buffer[EX_RX_BUFFER_SIZE] = {0};
-static uint16_t ex_rx_buffer_len = 0;
+/* last rx frame, a view into the raw rx buffer of the AT layer or into
+   ex_rx_buffer when it was read in several chunks */
+static const uint8_t *ex_rx_frame = NULL;
+static uint16_t ex_rx_frame_len = 0;
+static uint8_t ex_rx_buffer[EX_RX_BUFFER_SIZE];
+static uint16_t ex_rx_assembled = 0U;
+static bool ex_rx_overflow = false;
+
+/* bytes per AT+KUDPRCV/AT+KTCPRCV, one read is pending at a time */
+static uint16_t rx_read_size = MODEM_RX_READ_SIZE_DEFAULT;
+static bool rx_read_pending = false;
+
+/* streaming receive, frames are handed over in chunks while they arrive */
+static Modem_RxChunkCb ex_rx_chunk_cb = NULL;
 
 static bool tcpConfig = false;
 
@@ -401,6 +501,8 @@ static void Modem_SetCurrentState(enum modem_state_e state)
         modem.state = state;
         Modem_Umi_SetCurrentState(state);
         MODEM_PRINTF_INFO("ModemNextAction %u(%s%s%s%s%s) %u (state changed)\n", modem.state, modem_state_descr[modem.state], ready_to_send ? " REG" : "", modem.connected ? " CON" : "", Modem_IsUdpSessionActive() ? " UDP" : "", Modem_IsTcpSessionActive() ? " TCP" : "", modem.last_action);
+        /* continue in the new state right away, not on the next watchdog tick */
+        Sched_SetEvent(SCHED_MODEM_NEXT_ACTION);
     }
 }
 
@@ -417,13 +519,11 @@ static enum modem_action_e action_setter_list[] =
     modem_action_update_band_configuration,
     modem_action_update_prl,
     modem_action_set_cereg,
+    modem_action_set_psm,
 };
 
 static void Modem_SetCurrentAction_SetReq(enum modem_action_e action)
 {
-    static enum modem_action_e lastSetAction = modem_action_none;
-    static uint16_t setRetry = 0;
-
     if (action != lastSetAction)
     {
         setRetry = 0;
@@ -520,6 +620,14 @@ static void Modem_SetCurrentAction(enum modem_action_e action)
             Modem_SetActionRetries(MODEM_ACTION_RETRIES_SHUTDOWN);
             break;
 
+        case modem_action_enter_psm:
+            Modem_SetActionRetries(Modem_PsmActiveTimeS() + MODEM_PSM_ENTRY_MARGIN_S);
+            break;
+
+        case modem_action_exit_psm:
+            Modem_SetActionRetries(MODEM_ACTION_RETRIES_PSM_EXIT);
+            break;
+
         default:
             Modem_SetActionRetries(MODEM_MAX_ACTION_RETRIES);
             break;
@@ -543,7 +651,7 @@ static void Modem_TriggerAction(enum modem_action_e action)
 
     if (wait_before_retry > 0U)
     {
-        wait_before_retry --;
+        /* counted down by Modem_Watchdog() */
         MODEM_PRINTF_INFO("Wait before retry: %u\n", wait_before_retry);
         return;
     }
@@ -552,7 +660,7 @@ static void Modem_TriggerAction(enum modem_action_e action)
     {
 
     case modem_action_get_pending_rx_packet:
-        Modem_Cmd_AtGetData(waiting_bytes, Modem_Umi_GetCnxType());
+        Modem_ReadPendingRx();
         break;
 
     case modem_action_reset:
@@ -656,36 +764,20 @@ static void Modem_TriggerAction(enum modem_action_e action)
 
     case modem_action_send_queued_packet:
         {
-            if (Modem_Umi_CnxTypeIsTCP())
-            {
-                Modem_Cmd_SendTcpPacket(modem_queuedTxPkg, modem_queuedTxPkgLen);
-            }
-            else if (Modem_Umi_CnxTypeIsUDP())
-            {
-                Modem_Cmd_SendUdpPacket(modem_queuedTxPkg, modem_queuedTxPkgLen, Modem_Umi_CfgGetRemoteAddress(), Modem_Umi_CfgGetRemotePort());
-            }
-            else
+            Modem_TxQueueExpire();
+            if (tx_queue_count == 0U)
             {
-                MODEM_PRINTF_ERROR("Invalid cnx configuration!\n");
+                break;
             }
+
+            Modem_SendTxQueueHead();
         }
         break;
 
     case modem_action_wait_for_response:
         {
+            /* counted down by Modem_Watchdog() */
             MODEM_PRINTF_INFO("wait_for_rsp (%d, %d, %d)\n", wait_for_rsp, Rtc_GetUptimeSeconds() - action_retry_first, action_retry_last - Rtc_GetUptimeSeconds());
-            if (wait_for_rsp > 0U)
-            {
-                wait_for_rsp --;
-            }
-            if (wait_for_rsp == 0U)
-            {
-                MODEM_PRINTF_WARN("No response received!\n");
-                wait_for_rsp = 0U;
-#if 0 /* timer should be active */
-                Timer_StartOnce(SCHED_MODEM_NEXT_ACTION, 1000);
-#endif
-            }
         }
         break;
 
@@ -747,6 +839,23 @@ static void Modem_TriggerAction(enum modem_action_e action)
         modemInfo.cereg[0] = 0; /* ensure cereg will be requested again */
         break;
 
+    case modem_action_set_psm:
+        Modem_Cmd_SetPowerSaving(Modem_Umi_CfgGetPsmPeriodicTau(), Modem_Umi_CfgGetPsmActiveTime(),
+                                 (Modem_Umi_CfgGetRat1() == MODEM_KSELACQ_RAT_CAT_M1) ? MODEM_EDRX_ACT_CAT_M1 : MODEM_EDRX_ACT_NB_IOT,
+                                 (Modem_Umi_CfgGetPsmMode() == (uint8_t)modem_psm_mode_psm_edrx) ? Modem_Umi_CfgGetEdrxValue() : NULL);
+        break;
+
+    case modem_action_enter_psm:
+        MODEM_PRINTF_INFO("release wake up, wait for PSM (%u s)\n", Modem_PsmActiveTimeS());
+        Modem_Hal_WakeUpLow();
+        Modem_SetCurrentState(modem_state_psm_entry_wait_for_cts_high);
+        break;
+
+    case modem_action_exit_psm:
+        Modem_Hal_WakeUpHigh();
+        Modem_SetCurrentState(modem_state_psm_exit_wait_for_cts_low);
+        break;
+
     case modem_action_get_cfun:
         if (Modem_TestCaseActive(modem_tc_cfun_req))
         {
@@ -776,20 +885,21 @@ static void Modem_TriggerAction(enum modem_action_e action)
 
 static bool Modem_WantsToSend(void)
 {
-    return (modem.want_to_send) || (modem_queuedTxPkg != NULL);
+    return (modem.want_to_send) || (tx_queue_count > 0U);
 }
 
 static void Modem_NextAtCmdAction(void)
 {
-    if (Modem_IsReceivedDataWaiting())
+    /* commands are queued, one per pending response is enough */
+    if (Modem_At_Busy())
     {
-        Modem_TriggerAction(modem_action_get_pending_rx_packet);
+        MODEM_PRINTF_INFO("At busy\n");
         return;
     }
 
-    if (Modem_At_Busy())
+    if (Modem_IsReceivedDataWaiting())
     {
-        MODEM_PRINTF_INFO("At busy\n");
+        Modem_TriggerAction(modem_action_get_pending_rx_packet);
         return;
     }
 
@@ -907,6 +1017,329 @@ static void Modem_CloseSession(uint8_t session_id)
     }
 }
 
+/*!
+ * \brief Confirms the identity restored from the store by reading the IMEI
+ *        and the firmware release
+ *
+ * Another IMEI means another modem, then all identity values are read again.
+ * Another firmware release does not match the configuration fingerprint, so
+ * an update is verified in full.
+ *
+ * \return true if the IMEI was requested
+ */
+static bool Modem_CheckWarmIdentity(void)
+{
+    if (identity_warm == false)
+    {
+        return false;
+    }
+
+    if (modemInfo.imei[0] == 0)
+    {
+        /* AT+CGMR;+CGSN, the release is read on its own after a failed batch */
+        if (Modem_ReadInfoBatch() == false)
+        {
+            Modem_Cmd_RequestProductSerialNumberIdentification();
+            Modem_SetCurrentAction(modem_action_request_serial_number_identification);
+        }
+        return true;
+    }
+
+    identity_warm = false;
+    if (strcmp(modemInfo.imei, identity_imei) != 0)
+    {
+        MODEM_PRINTF_WARN("IMEI %s != %s, read identity\n", modemInfo.imei, identity_imei);
+        modemInfo.model[0] = 0;
+        modemInfo.SW_release[0] = 0;
+        modemInfo.fsn[0] = 0;
+        modemInfo.ICCID[0] = 0;
+    }
+    return false;
+}
+
+static uint32_t Modem_CfgHashAdd(uint32_t hash, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        hash = (hash ^ p[i]) * MODEM_CFG_HASH_PRIME;
+    }
+    return hash;
+}
+
+/* covers the values Modem_ReadData() verifies, strings with their terminator */
+static uint32_t Modem_CfgHash(void)
+{
+    uint8_t rat[3] = { Modem_Umi_CfgGetRat1(), Modem_Umi_CfgGetRat2(), Modem_Umi_CfgGetRat3() };
+    const char *apn = Modem_Umi_CfgGetApn();
+    uint32_t hash = Modem_CfgHashAdd(MODEM_CFG_HASH_BASIS, apn, strlen(apn) + 1U);
+
+    for (int rat_idx = RAT_CAT_M1; rat_idx <= RAT_NB_IOT; rat_idx++)
+    {
+        const char *bnd = Modem_Umi_CfgGetBndConfig(rat_idx);
+
+        hash = Modem_CfgHashAdd(hash, bnd, strlen(bnd) + 1U);
+    }
+    return Modem_CfgHashAdd(hash, rat, sizeof(rat));
+}
+
+/* the values read back from the modem match the configuration */
+static bool Modem_CfgVerified(void)
+{
+    return (modemInfo.pdp_context[0].cid[0] != 0) && (strcmp(modemInfo.pdp_context[0].APN, Modem_Umi_CfgGetApn()) == 0) &&
+           (strcmp(modemInfo.bnd_bitmap[RAT_CAT_M1], Modem_Umi_CfgGetBndConfig(RAT_CAT_M1)) == 0) &&
+           (strcmp(modemInfo.bnd_bitmap[RAT_NB_IOT], Modem_Umi_CfgGetBndConfig(RAT_NB_IOT)) == 0) &&
+           modemInfo.prl_valid && (modemInfo.prl[0] == Modem_Umi_CfgGetRat1()) && (modemInfo.prl[1] == Modem_Umi_CfgGetRat2()) &&
+           (modemInfo.prl[2] == Modem_Umi_CfgGetRat3()) && (strcmp(modemInfo.cereg, "2") == 0);
+}
+
+/*!
+ * \brief Skips the configuration reads while nothing changed since they passed
+ *
+ * The fingerprint covers the configuration, the IMEI and the firmware
+ * release. While the stored one matches, the values the reads would return
+ * are filled in. Otherwise the configuration is verified as before and the
+ * fingerprint is stored once the values read back match.
+ */
+static void Modem_CfgFingerprint(void)
+{
+    umi_modem_cfg_fingerprint_native_object_t fingerprint;
+
+    if (cfg_fingerprint_valid || (modemInfo.imei[0] == 0) || (modemInfo.SW_release[0] == 0))
+    {
+        return;
+    }
+
+    memset(&fingerprint, 0, sizeof(fingerprint));
+    fingerprint.cfg_hash = Modem_CfgHash();
+    /* zero padded, the terminator is kept */
+    memcpy(fingerprint.imei, modemInfo.imei, strnlen(modemInfo.imei, sizeof(fingerprint.imei) - 1U));
+    memcpy(fingerprint.SW_release, modemInfo.SW_release, strnlen(modemInfo.SW_release, sizeof(fingerprint.SW_release) - 1U));
+
+    if (cfg_fingerprint_checked == false)
+    {
+        umi_modem_cfg_fingerprint_native_object_t stored;
+
+        cfg_fingerprint_checked = true;
+        memset(&stored, 0, sizeof(stored));
+        if (Modem_Umi_RestoreCfgFingerprint(&stored, SIZEOFU16(stored)) && (memcmp(&stored, &fingerprint, sizeof(stored)) == 0))
+        {
+            MODEM_PRINTF_INFO("configuration unchanged, skip verification\n");
+            strcpy(modemInfo.pdp_context[0].cid, "1");
+            strncpy(modemInfo.pdp_context[0].APN, Modem_Umi_CfgGetApn(), sizeof(modemInfo.pdp_context[0].APN) - 1U);
+            for (int rat = RAT_CAT_M1; rat <= RAT_NB_IOT; rat++)
+            {
+                strncpy(modemInfo.bnd_bitmap[rat], Modem_Umi_CfgGetBndConfig(rat), sizeof(modemInfo.bnd_bitmap[rat]) - 1U);
+            }
+            modemInfo.prl[0] = Modem_Umi_CfgGetRat1();
+            modemInfo.prl[1] = Modem_Umi_CfgGetRat2();
+            modemInfo.prl[2] = Modem_Umi_CfgGetRat3();
+            modemInfo.prl_valid = true;
+            strcpy(modemInfo.cereg, "2");
+            cfg_fingerprint_valid = true;
+            return;
+        }
+    }
+
+    if (Modem_CfgVerified())
+    {
+        Modem_Umi_StoreCfgFingerprint(&fingerprint, sizeof(fingerprint));
+        cfg_fingerprint_valid = true;
+    }
+}
+
+/* the radio is to be switched on before the remaining values are read */
+static bool Modem_RadioOnPending(void)
+{
+    return registration_pipeline && Modem_WantsToSend() && (modem.abort_requested == false) && (Modem_FunctionalityIsFull() == false);
+}
+
+/*!
+ * \brief Decodes the requested active time (T3324)
+ *
+ * GPRS timer 2 as in 3GPP 24.008, bits 8 to 6 select the unit and bits 5 to
+ * 1 hold the value. The undefined units 3 to 6 count minutes.
+ *
+ * \return seconds, 0 if deactivated or not configured
+ */
+static uint32_t Modem_PsmActiveTimeS(void)
+{
+    static const uint16_t unit_s[8] = { 2U, 60U, 360U, 60U, 60U, 60U, 60U, 0U };
+    const char *t = Modem_Umi_CfgGetPsmActiveTime();
+    uint8_t v = 0U;
+
+    for (uint8_t i = 0U; i < 8U; i++)
+    {
+        if ((t[i] != '0') && (t[i] != '1'))
+        {
+            return 0U;
+        }
+        v = (uint8_t)((v << 1) | (uint8_t)(t[i] - '0'));
+    }
+    return (uint32_t)unit_s[v >> 5] * (v & 0x1FU);
+}
+
+static bool Modem_PsmWanted(void)
+{
+    return (Modem_Umi_CfgGetPsmMode() != (uint8_t)modem_psm_mode_off) && (psm_rejected == false);
+}
+
+/* the session ends in PSM instead of a power off */
+static bool Modem_PsmEntryPossible(void)
+{
+    return Modem_PsmWanted() && psm_configured && ready_to_send && Modem_FunctionalityIsFull();
+}
+
+/* the attach kept through PSM is gone, the next session registers again */
+static void Modem_PsmLost(void)
+{
+    ready_to_send = false;
+    modem.connected = false;
+    cfgWritten = false;
+    modemInfo.fun[0] = 0;
+}
+
+static void Modem_SessionTimeoutStart(void)
+{
+    session_timeout = Rtc_GetUptimeSeconds();
+    session_timeout += Modem_Umi_CfgGetCommunicationSessionTimeout();
+    MODEM_PRINTF_INFO("max session duration: %u s\n", Modem_Umi_CfgGetCommunicationSessionTimeout());
+}
+
+/*!
+ * \brief Reads missing identity or configuration values with one command line
+ *
+ * The identity queries and the configuration queries form one batch each.
+ * A batch is sent once at least two of its values are missing, a single
+ * missing value is read by Modem_ReadData() as before.
+ *
+ * \return true if a batch was sent
+ */
+static bool Modem_ReadInfoBatch(void)
+{
+    const char *cmds[MODEM_INFO_BATCH_CMDS_MAX];
+    uint8_t count = 0U;
+
+    if (info_batch_failed)
+    {
+        return false;
+    }
+
+    if (modemInfo.model[0] == 0)
+    {
+        cmds[count++] = "I";
+    }
+    if (modemInfo.SW_release[0] == 0)
+    {
+        cmds[count++] = "+CGMR";
+    }
+    if (modemInfo.fsn[0] == 0)
+    {
+        cmds[count++] = "+KGSN=3";
+    }
+    if (modemInfo.imei[0] == 0)
+    {
+        cmds[count++] = "+CGSN";
+    }
+    info_batch_identity = (count >= 2U);
+    info_batch_bands = false;
+
+    /* configuration reads up to the first value known to need a write */
+    if (info_batch_identity == false)
+    {
+        count = 0U;
+        if (modemInfo.pdp_context[0].cid[0] == 0)
+        {
+            cmds[count++] = "+CGDCONT?";
+        }
+        else if ((strcmp(modemInfo.pdp_context[0].APN, Modem_Umi_CfgGetApn()) != 0) || Modem_TestCaseActive(modem_tc_cfg_pdp_context))
+        {
+            return false;
+        }
+
+        for (int rat = RAT_CAT_M1; rat <= RAT_NB_IOT; rat++)
+        {
+            if ((modemInfo.bnd_bitmap[rat][0] != 0) && (strcmp(modemInfo.bnd_bitmap[rat], Modem_Umi_CfgGetBndConfig(rat)) != 0))
+            {
+                return false;
+            }
+        }
+        if ((modemInfo.bnd_bitmap[RAT_CAT_M1][0] == 0) || (modemInfo.bnd_bitmap[RAT_NB_IOT][0] == 0))
+        {
+            cmds[count++] = "+KBNDCFG?";
+        }
+        if (modemInfo.prl_valid == false)
+        {
+            cmds[count++] = "+KSELACQ?";
+        }
+        else if ((modemInfo.prl[0] != Modem_Umi_CfgGetRat1()) || (modemInfo.prl[1] != Modem_Umi_CfgGetRat2()) || (modemInfo.prl[2] != Modem_Umi_CfgGetRat3()) || Modem_TestCaseActive(modem_tc_cfg_prl_set_err))
+        {
+            return false;
+        }
+
+        if (modemInfo.cereg[0] == 0)
+        {
+            cmds[count++] = "+CEREG?";
+        }
+        else if ((strcmp(modemInfo.cereg, "2") != 0) || Modem_TestCaseActive(modem_tc_cfg_cereg_fail))
+        {
+            return false;
+        }
+
+        /* with the registration pipeline the rest is read while the modem searches the network */
+        if (Modem_RadioOnPending() == false)
+        {
+            if ((modemInfo.fun[0] == 0) && Modem_TestCaseNotActive(modem_tc_cfun_req))
+            {
+                cmds[count++] = "+CFUN?";
+            }
+            if (modemInfo.bnd[0] == 0)
+            {
+                cmds[count++] = "+KBND?";
+                info_batch_bands = true;
+            }
+            if (modemInfo.ICCID[0] == 0)
+            {
+                cmds[count++] = "+CCID";
+            }
+        }
+    }
+
+    if (count < 2U)
+    {
+        return false;
+    }
+
+    Modem_Cmd_SendBatch(cmds, count, Modem_ReadInfoBatchDone);
+    Modem_SetCurrentAction(modem_action_read_info_batch);
+    return true;
+}
+
+static void Modem_ReadInfoBatchDone(enum modem_at_result_e result)
+{
+    if (result != modem_at_result_ok)
+    {
+        MODEM_PRINTF_WARN("batch read failed, use single commands\n");
+        info_batch_failed = true;
+    }
+
+    /* values a single command action hands over when the action changes */
+    if (info_batch_identity)
+    {
+        Modem_Umi_ModemIdentification(modemInfo.model, sizeof(modemInfo.model));
+        Modem_Umi_RevisionIdentification(modemInfo.SW_release, sizeof(modemInfo.SW_release));
+        Modem_Umi_FactorySerialNumber(modemInfo.fsn, sizeof(modemInfo.fsn));
+        Modem_Umi_ProductSerialNumberIdentification(modemInfo.imei, sizeof(modemInfo.imei));
+    }
+    if (info_batch_bands && (modemInfo.bnd[0] != 0))
+    {
+        Modem_Umi_WriteActiveLTEBands(modemInfo.rat, modemInfo.bnd, sizeof(modemInfo.bnd));
+        pushInfoToUmi = true;
+    }
+
+    Sched_SetEvent(SCHED_MODEM_NEXT_ACTION);
+}
 
 static bool Modem_ReadData(void)
 {
@@ -917,8 +1350,19 @@ static bool Modem_ReadData(void)
         modemInfo.cesq.datetime_lastsync = modemInfo.cesq.datetime;
     }
 
+    if (Modem_CheckWarmIdentity())
+    {
+        /* restored identity is checked before anything else is read */
+        return true;
+    }
+    Modem_CfgFingerprint();
+
+    if (Modem_ReadInfoBatch())
+    {
+        /* missing values are read with one compound command */
+    }
     /* read non-variable parameters using execution commands */
-    if (modemInfo.model[0] == 0)
+    else if (modemInfo.model[0] == 0)
     {
         Modem_Cmd_RequestModelIdentification();
         Modem_SetCurrentAction(modem_action_request_model_identification);
@@ -983,6 +1427,16 @@ static bool Modem_ReadData(void)
     {
         Modem_TriggerAction(modem_action_set_cereg);
     }
+    else if (Modem_PsmWanted() && (psm_configured == false))
+    {
+        Modem_TriggerAction(modem_action_set_psm);
+    }
+    else if (Modem_RadioOnPending())
+    {
+        /* configuration verified, the modem registers while the rest is read */
+        MODEM_PRINTF_INFO("activate radio before reading the rest\n");
+        Modem_TriggerAction(modem_action_setup_full_func);
+    }
     else if (modemInfo.fun[0] == 0)
     {
         Modem_TriggerAction(modem_action_get_cfun);
@@ -997,7 +1451,7 @@ static bool Modem_ReadData(void)
         Modem_At_SendCmd("+CCID");
         Modem_SetCurrentAction(modem_action_read_iccid);
     }
-    else if (modem_want_read_signal_quality)
+    else if (modem_want_read_signal_quality && (tx_release_sent == false))
     {
         Modem_TriggerAction(modem_action_req_signal_quality);
     }
@@ -1027,16 +1481,19 @@ static bool Modem_NoMoreActionsRequired(void)
     return (modem.state == modem_state_powered_off) || ((modem.state == modem_state_init_powered_down) && (modem.want_to_send == false) && (modemInfo.model[0] != 0));
 }
 
+/* true while bytes are announced and no read is pending, the next chunk
+   is requested when the pending read completes */
 static bool Modem_IsReceivedDataWaiting(void)
 {
-    return waiting_bytes > 0;
+    return (waiting_bytes > 0U) && (rx_read_pending == false);
 }
 
 static bool Modem_IsActionRetryCounterExceeded(void)
 {
-    MODEM_PRINTF_INFO("tries: %u, limit: %u\n", Rtc_GetUptimeSeconds(), action_retry_last);
-    printf("tries: %u, limit: %u\n", Rtc_GetUptimeSeconds(), action_retry_last);
-    return Rtc_GetUptimeSeconds() >= action_retry_last;
+    uint32_t uptime = Rtc_GetUptimeSeconds();
+
+    MODEM_LOG2(MODEM_LOG_RETRY_CHECK, uptime, action_retry_last);
+    return uptime >= action_retry_last;
     //return true;
 }
 
@@ -1065,6 +1522,11 @@ static void Modem_ShutdownActions(void)
     {
         Modem_TriggerAction(modem_action_delete_session);
     }
+    else if (Modem_PsmEntryPossible())
+    {
+        /* stays attached, the next session starts without registration */
+        Modem_TriggerAction(modem_action_enter_psm);
+    }
     else if (Modem_FunctionalityIsNotOff())
     {
         Modem_TriggerAction(modem_action_shutdown);
@@ -1100,28 +1562,15 @@ static void Modem_SetupSession(void)
 
 static void Modem_ConnectActions(void)
 {
-    MODEM_PRINTF_INFO("ready_to_send\n");
-    MODEM_PRINTF_WARN("All info collect\nReady for communication\n");
-    MODEM_PRINTF_INFO("  Connected: %s\n", modem.connected ? "TRUE" : "FALSE");
-    MODEM_PRINTF_INFO("  modemSessionState[0]: %s\n", modemSessionState[0] != modem_session_state_closed ? "TRUE" : "FALSE");
-    MODEM_PRINTF_INFO("  modemSessionState[1]: %s\n", modemSessionState[1] != modem_session_state_closed ? "TRUE" : "FALSE");
-    MODEM_PRINTF_INFO("  modemSessionState[2]: %s\n", modemSessionState[2] != modem_session_state_closed ? "TRUE" : "FALSE");
-    MODEM_PRINTF_INFO("  want_to_send: %s\n", modem.want_to_send ? "TRUE" : "FALSE");
-    MODEM_PRINTF_INFO("  wait_for_rsp: %d\n", wait_for_rsp);
-    MODEM_PRINTF_INFO("  modem_queuedTxPkg: %s\n", modem_queuedTxPkg != NULL ? "TRUE" : "FALSE");
-    MODEM_PRINTF_INFO("  cfgWritten: %s\n", cfgWritten ? "TRUE" : "FALSE");
-    
-    printf("ready_to_send\n");
-    printf("All info collect\nReady for communication\n");
-    printf("  Connected: %s\n", modem.connected ? "TRUE" : "FALSE");
-    printf("  modemSessionState[0]: %s\n", modemSessionState[0] != modem_session_state_closed ? "TRUE" : "FALSE");
-    printf("  modemSessionState[1]: %s\n", modemSessionState[1] != modem_session_state_closed ? "TRUE" : "FALSE");
-    printf("  modemSessionState[2]: %s\n", modemSessionState[2] != modem_session_state_closed ? "TRUE" : "FALSE");
-    printf("  want_to_send: %s\n", modem.want_to_send ? "TRUE" : "FALSE");
-    printf("  wait_for_rsp: %d\n", wait_for_rsp);
-    printf("  modem_queuedTxPkg: %s\n", modem_queuedTxPkg != NULL ? "TRUE" : "FALSE");
-    printf("  cfgWritten: %s\n", cfgWritten ? "TRUE" : "FALSE");
-
+    MODEM_LOG2(MODEM_LOG_READY_FOR_COMM,
+               (modem.connected ? 0x01U : 0U) |
+               ((modemSessionState[0] != modem_session_state_closed) ? 0x02U : 0U) |
+               ((modemSessionState[1] != modem_session_state_closed) ? 0x04U : 0U) |
+               ((modemSessionState[2] != modem_session_state_closed) ? 0x08U : 0U) |
+               (modem.want_to_send ? 0x10U : 0U) |
+               ((tx_queue_count > 0U) ? 0x20U : 0U) |
+               (cfgWritten ? 0x40U : 0U),
+               wait_for_rsp);
 
     if ((cfgWritten == false) && (modemSessionState[0] == modem_session_state_closed))
     {
@@ -1151,21 +1600,17 @@ static void Modem_ConnectActions(void)
 #endif
     else if ((modem.connected == true) && (modemSessionState[0] != modem_session_state_closed))
     {
-        if ((modem_queuedTxPkg == NULL) && (modem.want_to_send))
+        if ((tx_queue_count == 0U) && (modem.want_to_send))
         {
-            MODEM_PRINTF_SUCCESS("Ready to send!\n");
-            printf("Ready to send!\n");
+            MODEM_LOG0(MODEM_LOG_READY_TO_SEND);
             Modem_ReadyToSendInd();
         }
-        else if (modem_queuedTxPkg != NULL)
+        /* frames queued from the indication go out right away */
+        if (tx_queue_count > 0U)
         {
             Modem_TriggerAction(modem_action_send_queued_packet);
             modem.want_to_send = false;
         }
-        else
-        {
-            MODEM_PRINTF_ERROR("invalide state, should never come here (862)\n");
-        }
     }
     else if ((modem.connected == false) && (modemSessionState[0] != modem_session_state_closed))
     {
@@ -1221,13 +1666,24 @@ static void Modem_StopProcess(void)
     MODEM_PRINTF_INFO("Modem_StopProcess\n");
 
     Modem_Hal_UartClose();
-    Timer_Stop(SCHED_MODEM_NEXT_ACTION);
+    Modem_At_FlushQueue();
+    Timer_Stop(SCHED_MODEM_WATCHDOG);
+    /* an unconfirmed frame stays queued for the next sessions */
+    tx_in_flight = false;
+    Modem_TxQueueSessionEnd();
+    rx_read_pending = false;
+    tx_release = modem_tx_release_none;
+    tx_release_sent = false;
+    /* AT+CPSMS is written in every PSM session */
+    lastSetAction = modem_action_none;
 
 #ifdef OS_DEBUG_PRINTF_ENABLED
     Modem_Stats_PrintStats();
+    Modem_Latency_PrintStats();
 #endif
 
     Modem_Stats_Save();
+    Modem_Latency_Save();
 
     Modem_SetCurrentAction(modem_action_stop_req_umi_power_down);
 
@@ -1275,55 +1731,149 @@ static void Modem_SetupRetries(void)
     action_retry_last = Rtc_GetUptimeSeconds() + 10;
 }
 
-/*-----------------------------------------------------------------------------
-Public Function implementations
------------------------------------------------------------------------------*/
-
-#ifdef OS_DEBUG_PRINTF_ENABLED
-void Modem_PrintLocalInfo(void)
-{
-    MODEM_PRINTF_INFO("modem_state: %u\n", modem.state);
-    MODEM_PRINTF_INFO("want_to_send: %s\n", modem.want_to_send ? "TRUE" : "FALSE");
-    MODEM_PRINTF_INFO("abort_requested: %s\n", modem.abort_requested ? "TRUE" : "FALSE");
-    MODEM_PRINTF_INFO("test_case: %u\n", modem.test_case);
-    MODEM_PRINTF_INFO("connected: %s\n", modem.connected ? "TRUE" : "FALSE");
-    MODEM_PRINTF_INFO("error:\n");
-    MODEM_PRINTF_INFO("  last: %u\n", modem.error.last);
-    MODEM_PRINTF_INFO("  state: %u\n", modem.error.state);
-    MODEM_PRINTF_INFO("  action: %u\n", modem.error.action);
-    MODEM_PRINTF_INFO("  datetime: %u\n", modem.error.datetime);
-}
-#endif
-
-#ifndef RELEASE_BUILD
-bool Modem_DropRx(void)
-{
-    return Modem_TestCaseActive(modem_tc_no_rx);
-}
-#endif
-
-void Modem_RequestToSend(void)
-{
-    modem.want_to_send = true;
-}
-
-void Modem_Wakeup(void)
+static void Modem_RawDataConsumed(uint16_t len)
 {
-    modem.abort_requested = false;
-
-    if (modem.state == modem_state_powered_off)
+    if (len > waiting_bytes)
     {
-        modem.state = modem_state_init_powered_down;
+        MODEM_PRINTF_ERROR("waiting_bytes: %u -> reset to 0\n", waiting_bytes);
+        waiting_bytes = 0;
+    }
+    else
+    {
+        waiting_bytes -= len;
+    }
+
+    if (waiting_bytes == 0)
+    {
+#if 0
+        MODEM_PRINTF_SUCCESS("Frame done, queue next...\n");
+        if (modem_queuedTxPkg != dlmsRsp)
+        {
+            modem.want_to_send = true;
+            modem_queuedTxPkg = dlmsRsp;
+            modem_queuedTxPkgLen = sizeof(dlmsRsp);
+        }
+#endif
+        wait_for_rsp = 0U;
+    }
+
+    if (Modem_IsUdpSessionActive())
+    {
+        Modem_Stats_UDPRxBytes(len);
+    }
+    if (Modem_IsTcpSessionActive())
+    {
+        Modem_Stats_TCPRxBytes(len);
+    }
+}
+
+/* the signal quality read after a frame replaces the one of the state machine */
+static void Modem_SignalQualityReadDone(enum modem_at_result_e result)
+{
+    if (result == modem_at_result_ok)
+    {
+        modem_want_read_signal_quality = false;
+    }
+}
+
+/* requests the next chunk of the announced bytes */
+static void Modem_ReadPendingRx(void)
+{
+    uint16_t len = waiting_bytes;
+
+    if (len > rx_read_size)
+    {
+        len = rx_read_size;
+    }
+    rx_read_pending = Modem_Cmd_AtGetData(len, Modem_Umi_GetCnxType(), Modem_ReadPendingRxDone);
+}
+
+/* the next chunk is requested right away, not with the next action */
+static void Modem_ReadPendingRxDone(enum modem_at_result_e result)
+{
+    /* bytes of a failed or short read are requested again */
+    rx_read_pending = false;
+    if ((result == modem_at_result_ok) && Modem_IsReceivedDataWaiting())
+    {
+        Modem_ReadPendingRx();
+    }
+    else
+    {
+        Sched_SetEvent(SCHED_MODEM_NEXT_ACTION);
     }
-    Timer_StartRecurring(SCHED_MODEM_NEXT_ACTION, MODEM_NEXT_ACTION_TIMER_PERIOD_MS);
-    Modem_ErrorClear();
-    Modem_Stats_ModemStarted();
-    Modem_SetupRetries();
+}
+
+static void Modem_RawDataFrameDone(void)
+{
+    if (Modem_IsUdpSessionActive())
+    {
+        Modem_Stats_UDPRxFrames(1U);
+    }
+    if (Modem_IsTcpSessionActive())
+    {
+        Modem_Stats_TCPRxFrames(1U);
+    }
+
+    /* queued behind the response of the receive command, not after the
+       single reply the network releases the radio connection with */
+    if (tx_release_sent == false)
+    {
+        Modem_Cmd_ReadExtendedSignalQuality(Modem_SignalQualityReadDone);
+    }
+
+    Sched_SetEvent(SCHED_MODEM_NEXT_ACTION);
+}
+
+/*-----------------------------------------------------------------------------
+Public Function implementations
+-----------------------------------------------------------------------------*/
+
+#ifdef OS_DEBUG_PRINTF_ENABLED
+void Modem_PrintLocalInfo(void)
+{
+    MODEM_PRINTF_INFO("modem_state: %u\n", modem.state);
+    MODEM_PRINTF_INFO("want_to_send: %s\n", modem.want_to_send ? "TRUE" : "FALSE");
+    MODEM_PRINTF_INFO("abort_requested: %s\n", modem.abort_requested ? "TRUE" : "FALSE");
+    MODEM_PRINTF_INFO("test_case: %u\n", modem.test_case);
+    MODEM_PRINTF_INFO("connected: %s\n", modem.connected ? "TRUE" : "FALSE");
+    MODEM_PRINTF_INFO("error:\n");
+    MODEM_PRINTF_INFO("  last: %u\n", modem.error.last);
+    MODEM_PRINTF_INFO("  state: %u\n", modem.error.state);
+    MODEM_PRINTF_INFO("  action: %u\n", modem.error.action);
+    MODEM_PRINTF_INFO("  datetime: %u\n", modem.error.datetime);
+}
+#endif
+
+#ifndef RELEASE_BUILD
+bool Modem_DropRx(void)
+{
+    return Modem_TestCaseActive(modem_tc_no_rx);
+}
+#endif
+
+void Modem_RequestToSend(void)
+{
+    modem.want_to_send = true;
+}
+
+void Modem_Wakeup(void)
+{
+    modem.abort_requested = false;
+
+    if (modem.state == modem_state_powered_off)
+    {
+        modem.state = modem_state_init_powered_down;
+    }
+    Timer_StartRecurring(SCHED_MODEM_WATCHDOG, MODEM_WATCHDOG_TIMER_PERIOD_MS);
+    Modem_ErrorClear();
+    Modem_Stats_ModemStarted();
+    Modem_SetupRetries();
+    Sched_SetEvent(SCHED_MODEM_NEXT_ACTION);
 }
 
 bool Modem_CommunicationInProgress(void)
 {
-    return Timer_IsRunning(SCHED_MODEM_NEXT_ACTION) && (Modem_WantsToSend() || wait_for_rsp);
+    return Timer_IsRunning(SCHED_MODEM_WATCHDOG) && (Modem_WantsToSend() || wait_for_rsp);
 }
 
 void Modem_AbortCommunication(void)
@@ -1347,6 +1897,23 @@ egm_error_t Modem_Init(void)
 {
     memset(&modemInfo, 0, sizeof(modemInfo));
 
+    /* warm start, the identity of the last power up is only confirmed */
+    identity_warm = Modem_Umi_RestoreIdentity(&modemInfo);
+    cfg_fingerprint_checked = false;
+    cfg_fingerprint_valid = false;
+    /* an attach kept through PSM does not survive a restart of the host */
+    Modem_PsmLost();
+    psm_configured = false;
+    psm_rejected = false;
+    if (identity_warm)
+    {
+        MODEM_PRINTF_INFO("identity restored: %s %s\n", modemInfo.model, modemInfo.imei);
+        strcpy(identity_imei, modemInfo.imei);
+        modemInfo.imei[0] = 0;
+        /* read live, the fingerprint detects a firmware update */
+        modemInfo.SW_release[0] = 0;
+    }
+
     Modem_Hal_Init();
 
 #ifdef CONSOLE_ENABLED
@@ -1364,12 +1931,14 @@ egm_error_t Modem_Init(void)
     }
 
     Modem_Stats_Load();
+    Modem_Latency_Init();
 
     if (Modem_Stats_FirstPowerUp())
     {
-        Timer_StartRecurring(SCHED_MODEM_NEXT_ACTION, MODEM_NEXT_ACTION_TIMER_PERIOD_MS);
+        Timer_StartRecurring(SCHED_MODEM_WATCHDOG, MODEM_WATCHDOG_TIMER_PERIOD_MS);
         Modem_ErrorClear();
         Modem_Stats_ModemStarted();
+        Sched_SetEvent(SCHED_MODEM_NEXT_ACTION);
     }
 
     return EGM_ERR_OK;
@@ -1388,7 +1957,7 @@ void Modem_StartProcess(Modem_CommunicationFinishedCb pCallback, bool request_to
         Modem_RequestToSend();
     }
 
-    if (Timer_IsRunning(SCHED_MODEM_NEXT_ACTION) == FALSE)
+    if (Timer_IsRunning(SCHED_MODEM_WATCHDOG) == FALSE)
     {
         Modem_Wakeup();
     }
@@ -1397,6 +1966,17 @@ void Modem_StartProcess(Modem_CommunicationFinishedCb pCallback, bool request_to
 void Modem_ExecuteReset(void)
 {
     Modem_Hal_UartClose();
+    Modem_At_FlushQueue();
+    tx_in_flight = false;
+    rx_read_pending = false;
+    if (psm_configured)
+    {
+        /* a reset ends the attach the modem kept through PSM */
+        Modem_PsmLost();
+        psm_configured = false;
+    }
+    /* the modem is kept awake while the host talks to it */
+    Modem_Hal_WakeUpHigh();
     if (Modem_TestCaseNotActive(modem_tc_no_reset))
     {
         Modem_Hal_ResetLow();
@@ -1409,27 +1989,47 @@ void Modem_ExecuteReset(void)
     }
 }
 
+/*!
+ * \brief Periodic supervision, runs every MODEM_WATCHDOG_TIMER_PERIOD_MS
+ *
+ * The state machine is continued by SCHED_MODEM_NEXT_ACTION events posted
+ * from AT completions, URCs and CTS edges. The watchdog only counts down the
+ * second based waits and polls the state machine in case no event arrives.
+ */
+void Modem_Watchdog(void)
+{
+    if (wait_before_retry > 0U)
+    {
+        wait_before_retry --;
+    }
+    if (wait_for_rsp > 0U)
+    {
+        wait_for_rsp --;
+        if (wait_for_rsp == 0U)
+        {
+            MODEM_PRINTF_WARN("No response received!\n");
+        }
+    }
+
+    Modem_NextAction();
+}
+
 void Modem_NextAction(void)
 {
-    printf("ModemNextAction %u(%s%s%s%s%s) %u\n", modem.state, modem_state_descr[modem.state], ready_to_send ? " REG" : "", modem.connected ? " CON" : "", Modem_IsUdpSessionActive() ? " UDP" : "", Modem_IsTcpSessionActive() ? " TCP" : "", modem.last_action);
+    MODEM_LOG3(MODEM_LOG_NEXT_ACTION, modem.state,
+               (ready_to_send ? 0x01U : 0U) | (modem.connected ? 0x02U : 0U) | (Modem_IsUdpSessionActive() ? 0x04U : 0U) | (Modem_IsTcpSessionActive() ? 0x08U : 0U),
+               modem.last_action);
 
     if (Modem_NoMoreActionsRequired())
     {
-        MODEM_PRINTF_INFO("Module powered down, all actions done\n");
+        MODEM_LOG0(MODEM_LOG_POWERED_DOWN);
         Modem_StopProcess();
         return;
     }
 
     if (Modem_IsActionRetryCounterExceeded())
     {
-        if ((modem.state == modem_state_at_ready) && (modem.last_action == modem_action_wait_for_response))
-        {
-            MODEM_PRINTF_WARN("Modem max action retries exceeded (no err)\nmodem.last_action: %d\n", modem.last_action);
-        }
-        else
-        {
-            MODEM_PRINTF_ERROR("Modem max action retries exceeded!\nmodem.last_action: %d\n", modem.last_action);
-        }
+        MODEM_LOG2(MODEM_LOG_RETRIES_EXCEEDED, modem.state, modem.last_action);
 
         switch (modem.state)
         {
@@ -1466,7 +2066,7 @@ void Modem_NextAction(void)
                 break;
             case modem_action_wait_for_registration:
                 modem.want_to_send = false;
-                MODEM_PRINTF_ERROR("Not able to access network!\n");
+                MODEM_LOG0(MODEM_LOG_NO_NETWORK);
                 //wait_for_registration = Modem_Umi_CfgGetWaitForRegistrationTimeout();
                 Modem_ErrorOccured(modem_error_wait_for_registration_timed_out);
                 Modem_RequestPowerDown();
@@ -1476,6 +2076,16 @@ void Modem_NextAction(void)
                 MODEM_PRINTF_WARN("No response received!\n");
                 wait_for_rsp = 0U;
                 break;
+            case modem_action_send_queued_packet:
+                /* the modem keeps rejecting the frame, later sessions would not do better */
+                tx_in_flight = false;
+                if (tx_queue_count > 0U)
+                {
+                    Modem_TxQueueRemove(0U, modem_tx_result_failed);
+                }
+                Modem_ErrorOccured(modem_error_action_retries_exceeded);
+                Modem_RequestPowerDown();
+                break;
 
             default:
                 Modem_ErrorOccured(modem_error_action_retries_exceeded);
@@ -1489,6 +2099,18 @@ void Modem_NextAction(void)
             Modem_HoldReset();
             break;
 
+        case modem_state_psm_entry_wait_for_cts_high:
+            MODEM_PRINTF_WARN("modem does not sleep, PSM rejected\n");
+            psm_rejected = true;
+            Modem_SetCurrentState(modem_state_at_ready);
+            break;
+
+        case modem_state_psm_exit_wait_for_cts_low:
+            MODEM_PRINTF_WARN("modem does not wake up, restart\n");
+            Modem_PsmLost();
+            Modem_SetCurrentState(modem_state_reset_required);
+            break;
+
         default:
             Modem_ErrorOccured(modem_error_at_not_ready_action_retries_exceeded);
             break;
@@ -1548,7 +2170,11 @@ void Modem_NextAction(void)
         break;
 
     case modem_state_check_At:
-        Modem_TriggerAction(modem_action_check_at);
+        /* the AT timeout paces the next probe */
+        if (Modem_At_Busy() == false)
+        {
+            Modem_TriggerAction(modem_action_check_at);
+        }
         break;
 
     case modem_state_at_ready:
@@ -1570,6 +2196,27 @@ void Modem_NextAction(void)
     case modem_state_hold_reset:
         Modem_StopProcess();
         break;
+
+    case modem_state_psm_entry_wait_for_cts_high:
+        Modem_CtsCheck();
+        break;
+
+    case modem_state_psm:
+        if (Modem_IsStartupRequired())
+        {
+            Modem_GetConfigurationFromUmi();
+            Modem_TriggerAction(modem_action_exit_psm);
+        }
+        else
+        {
+            Modem_StopProcess();
+        }
+        break;
+
+    case modem_state_psm_exit_wait_for_cts_low:
+        Modem_CtsCheck();
+        break;
+
     default:
         /* nothing to do, handling only a subset of possible states */
         break;
@@ -1583,7 +2230,6 @@ void Modem_RawDataRecvdInd(char *msg, uint16_t len)
         MODEM_PRINTF_ERROR("Modem_RawDataRecvdInd, invalid length\n");
         return;
     }
-
     MODEM_PRINTF_INFO("Modem_RawDataRecvdInd");
     for (uint16_t i = 0; i < len; i++)
     {
@@ -1591,48 +2237,67 @@ void Modem_RawDataRecvdInd(char *msg, uint16_t len)
     }
     MODEM_PRINTF_INFO("\n");
 
-    if (len > waiting_bytes)
+    Modem_RawDataConsumed(len);
+
+    if ((ex_rx_assembled == 0U) && (ex_rx_overflow == false) && (waiting_bytes == 0U))
     {
-        MODEM_PRINTF_ERROR("waiting_bytes: %u -> reset to 0\n", waiting_bytes);
-        waiting_bytes = 0;
+        /* read in one go, no copy */
+        ex_rx_frame = (const uint8_t *)msg;
+        ex_rx_frame_len = len;
     }
     else
     {
-        waiting_bytes -= len;
-    }
+        /* chunks of one frame are collected until all announced bytes are read */
+        if ((ex_rx_overflow == false) && (len <= EX_RX_BUFFER_SIZE - ex_rx_assembled))
+        {
+            memcpy(&ex_rx_buffer[ex_rx_assembled], msg, len);
+            ex_rx_assembled += len;
+        }
+        else
+        {
+            Modem_Stats_ModemLostBytes(len);
+            ex_rx_overflow = true;
+        }
+        if (waiting_bytes > 0U)
+        {
+            return;
+        }
 
-    if (waiting_bytes == 0)
-    {
-#if 0
-        MODEM_PRINTF_SUCCESS("Frame done, queue next...\n");
-        if (modem_queuedTxPkg != dlmsRsp)
+        ex_rx_frame = ex_rx_buffer;
+        ex_rx_frame_len = ex_rx_overflow ? 0U : ex_rx_assembled;
+        ex_rx_assembled = 0U;
+        if (ex_rx_overflow)
         {
-            modem.want_to_send = true;
-            modem_queuedTxPkg = dlmsRsp;
-            modem_queuedTxPkgLen = sizeof(dlmsRsp);
+            MODEM_PRINTF_ERROR("Modem_RawDataRecvdInd, frame too long\n");
+            ex_rx_overflow = false;
+            return;
         }
-#endif
-        wait_for_rsp = 0U;
     }
-
-    memcpy(ex_rx_buffer, msg, (size_t)len);
-    ex_rx_buffer_len = (uint16_t)len;
     Modem_UpdPkgRecvdInd();
 
-    if (Modem_IsUdpSessionActive())
+    Modem_RawDataFrameDone();
+}
+
+/*!
+ * \brief Passes a chunk of a streamed frame to the registered callback
+ *
+ * \param last true for the final chunk of the frame, it may be empty
+ */
+void Modem_RawDataChunkInd(const char *msg, size_t len, bool last)
+{
+    Modem_RawDataConsumed((uint16_t)len);
+
+    /* a frame read in several chunks ends with the last one */
+    last = last && (waiting_bytes == 0U);
+    if (ex_rx_chunk_cb != NULL)
     {
-        Modem_Stats_UDPRxFrames(1U);
-        Modem_Stats_UDPRxBytes(ex_rx_buffer_len);
+        ex_rx_chunk_cb((const uint8_t *)msg, len, last);
     }
-    if (Modem_IsTcpSessionActive())
+
+    if (last)
     {
-        Modem_Stats_TCPRxFrames(1U);
-        Modem_Stats_TCPRxBytes(ex_rx_buffer_len);
+        Modem_RawDataFrameDone();
     }
-
-    Modem_Cmd_ReadExtendedSignalQuality();
-
-    Sched_SetEvent(SCHED_MODEM_NEXT_ACTION);
 }
 
 void Modem_TcpDataReadyInd(uint16_t bytes_ready)
@@ -1654,9 +2319,11 @@ void Modem_NoDatIndication(void)
 {
     /* packet lost */
     Modem_Stats_ModemEmptyPackets();
-    Modem_Stats_ModemLostBytes(waiting_bytes);
+    Modem_Stats_ModemLostBytes(waiting_bytes + ex_rx_assembled);
 
     waiting_bytes = 0;
+    ex_rx_assembled = 0U;
+    ex_rx_overflow = false;
 }
 
 void Modem_RtsChanged(void)
@@ -1720,6 +2387,12 @@ void Modem_CtsCheck(void)
                 MODEM_PRINTF_INFO("now wait for low\n");
                 Modem_SetCurrentState(modem_state_powered_up_wait_for_cts_low);
             }
+            if (modem.state == modem_state_psm_entry_wait_for_cts_high)
+            {
+                MODEM_PRINTF_SUCCESS("modem sleeps in PSM\n");
+                Modem_Hal_UartClose();
+                Modem_SetCurrentState(modem_state_psm);
+            }
         }
     }
     else
@@ -1741,6 +2414,15 @@ void Modem_CtsCheck(void)
                 Modem_SetCurrentState(modem_state_powered_off);
                 Sched_SetEvent(SCHED_MODEM_NEXT_ACTION);
             }
+            if (modem.state == modem_state_psm_exit_wait_for_cts_low)
+            {
+                /* still attached, the session continues without registration */
+                MODEM_PRINTF_SUCCESS("modem woke up from PSM\n");
+                Modem_SessionTimeoutStart();
+                Modem_SetCurrentState(modem_state_ready);
+
+                Modem_Hal_UartOpen();
+            }
         }
     }
 #endif
@@ -1751,6 +2433,7 @@ void Modem_AtIndication(void)
     if (modem.state == modem_state_check_At)
     {
         MODEM_PRINTF_SUCCESS("at ready\n");
+        info_batch_failed = false;
         Modem_SetCurrentState(modem_state_at_ready);
         Sched_SetEvent(SCHED_MODEM_NEXT_ACTION);
     }
@@ -1801,9 +2484,7 @@ void Modem_AtReqDone(void)
         break;
 
     case modem_action_setup_full_func:
-        session_timeout = Rtc_GetUptimeSeconds();
-        session_timeout += Modem_Umi_CfgGetCommunicationSessionTimeout();
-        MODEM_PRINTF_INFO("max session duration: %u s\n", Modem_Umi_CfgGetCommunicationSessionTimeout());
+        Modem_SessionTimeoutStart();
 
         Modem_NotReadyWaitForCts();
         //wait_for_registration = Modem_Umi_CfgGetWaitForRegistrationTimeout();
@@ -1819,6 +2500,10 @@ void Modem_AtReqDone(void)
         modemInfo.fun[0] = 0;
         break;
 
+    case modem_action_set_psm:
+        psm_configured = true;
+        break;
+
     case  modem_action_close_session:
         {
             if (modemSessionState[3] != modem_session_state_closed)
@@ -1849,12 +2534,31 @@ void Modem_AtReqDone(void)
         break;
 
     case modem_action_send_queued_packet:
-        MODEM_PRINTF_WARN("modem_queuedTxPkg: %s\n", modem_queuedTxPkg ? "TRUE" : "FALSE");
-        modem_queuedTxPkg = NULL;
-        MODEM_PRINTF_WARN("modem_queuedTxPkg: %s\n", modem_queuedTxPkg ? "TRUE" : "FALSE");
-        modem_queuedTxPkgLen = 0U;
-        wait_for_rsp = Modem_Umi_CfgGetWaitForResponseTimeout();
         MODEM_PRINTF_INFO("remove tx pkg from queue\n");
+        tx_in_flight = false;
+        if ((tx_queue_count > 0U) && (tx_queue[0].ext != NULL) && (++tx_queue[0].frag < tx_queue[0].frag_count))
+        {
+            MODEM_PRINTF_INFO("fragment %u of %u sent\n", tx_queue[0].frag, tx_queue[0].frag_count);
+        }
+        else if (tx_queue_count > 0U)
+        {
+            Modem_TxQueueRemove(0U, modem_tx_result_sent);
+        }
+        if (tx_queue_count > 0U)
+        {
+            /* next frame back to back in the same session, with its own retries */
+            Modem_SetActionRetries(MODEM_MAX_ACTION_RETRIES);
+        }
+        else if (tx_release_sent && (tx_release == modem_tx_release_no_reply))
+        {
+            /* the network releases the radio, no reply to wait for */
+            MODEM_PRINTF_INFO("last frame sent, no reply expected\n");
+            wait_for_rsp = 0U;
+        }
+        else
+        {
+            wait_for_rsp = Modem_Umi_CfgGetWaitForResponseTimeout();
+        }
         break;
 
     default:
@@ -1868,6 +2572,8 @@ void Modem_AtReqDone(void)
 void Modem_AtReqTimeout(void)
 {
     MODEM_PRINTF_WARN("No answer received!\n");
+    /* the timeout already paced the retry */
+    Sched_SetEvent(SCHED_MODEM_NEXT_ACTION);
 }
 
 void Modem_TcpSessionStatusChangedInd(int session_id, uint8_t tcp_notif)
@@ -2023,24 +2729,312 @@ void Modem_ErrorInd(int errorNum)
 uint8_t pkg[99] = {0x00, 0x01, 0x00, 0x01, 0x00, 0x01, 0x00, 0x5b, 0xdb, 0x08, 0x93, 0x15, 0x43, 0x67, 0x75, 0x48, 0x25, 0x03, 0x50, 0x30, 0x00, 0x0f, 0x42, 0x40, 0xab, 0x9b, 0xb3, 0x80, 0x08, 0xb3, 0xe2, 0xca, 0x6b, 0xe5, 0x35, 0xba, 0x53, 0xa2, 0x53, 0x50, 0xe0, 0xd3, 0x33, 0xf3, 0x48, 0x1a, 0x57, 0x7b, 0x8b, 0x8a, 0x53, 0x38, 0x73, 0xf6, 0x7c, 0x76, 0xbc, 0xd0, 0x9e, 0xd2, 0xbd, 0xa3, 0x4d, 0xcb, 0xde, 0x74, 0x79, 0x41, 0x66, 0x4b, 0x93, 0x61, 0xe6, 0x47, 0x2b, 0xb9, 0xc0, 0x43, 0xc5, 0x38, 0xbf, 0xe5, 0x86, 0xbe, 0x16, 0xf6, 0xba, 0x90, 0x68, 0xcc, 0xe0, 0xca, 0x07, 0x78, 0xa0, 0xb4, 0xd5, 0x5c, 0x87};
 #endif
 
+static void Modem_TxQueueRemove(uint8_t idx, enum modem_tx_result_e result)
+{
+    struct modem_tx_frame_s frame = tx_queue[idx];
+
+    /* close the gap in the payload buffer */
+    memmove(&ex_tx_buffer[frame.offset], &ex_tx_buffer[frame.offset + frame.len], (size_t)(tx_queue_bytes - frame.offset - frame.len));
+    tx_queue_bytes -= frame.len;
+    for (uint8_t i = idx; i + 1U < tx_queue_count; i++)
+    {
+        tx_queue[i] = tx_queue[i + 1U];
+    }
+    tx_queue_count--;
+    for (uint8_t i = 0U; i < tx_queue_count; i++)
+    {
+        if (tx_queue[i].offset > frame.offset)
+        {
+            tx_queue[i].offset -= frame.len;
+        }
+    }
+
+    MODEM_PRINTF_INFO("tx frame %u done: %u, %u left\n", frame.tag, (uint16_t)result, tx_queue_count);
+    if (frame.cb != NULL)
+    {
+        frame.cb(frame.tag, result);
+    }
+}
+
+/* tx_queue[0] is being sent or partially sent, it is neither displaced nor dropped */
+static bool Modem_TxQueueHeadLocked(void)
+{
+    return tx_in_flight || ((tx_queue_count > 0U) && (tx_queue[0].frag > 0U));
+}
+
+/* takes a free entry in priority order, the caller fills in the payload */
+static struct modem_tx_frame_s *Modem_TxQueueInsert(uint8_t priority, uint32_t lifetime_s, Modem_TxFrameDoneCb cb, uint16_t tag)
+{
+    uint8_t pos = tx_queue_count;
+
+    /* behind all frames of the same or a higher priority, never in front of the frame being sent */
+    while ((pos > (Modem_TxQueueHeadLocked() ? 1U : 0U)) && (tx_queue[pos - 1U].priority < priority))
+    {
+        tx_queue[pos] = tx_queue[pos - 1U];
+        pos--;
+    }
+    /* a frame queued after the last one, the release assistance moves on */
+    tx_release_sent = false;
+    memset(&tx_queue[pos], 0, sizeof(tx_queue[pos]));
+    tx_queue[pos].offset = tx_queue_bytes;
+    tx_queue[pos].priority = priority;
+    tx_queue[pos].tag = tag;
+    tx_queue[pos].expiry = (lifetime_s > 0U) ? Rtc_GetUptimeSeconds() + lifetime_s : 0U;
+    tx_queue[pos].cb = cb;
+    tx_queue_count++;
+
+    Sched_SetEvent(SCHED_MODEM_NEXT_ACTION);
+    return &tx_queue[pos];
+}
+
+/* hands the frame or the next fragment of tx_queue[0] to the AT layer */
+static void Modem_SendTxQueueHead(void)
+{
+    const struct modem_tx_frame_s *frame = &tx_queue[0];
+    const uint8_t *hdr = NULL;
+    uint8_t hdr_len = 0U;
+    const uint8_t *pkg = &ex_tx_buffer[frame->offset];
+    uint16_t len = frame->len;
+    /* the last frame or fragment of the queue carries the release assistance */
+    bool last = (tx_queue_count == 1U) && ((frame->ext == NULL) || (frame->frag + 1U >= frame->frag_count));
+
+    if (frame->ext != NULL)
+    {
+        uint32_t pos = (uint32_t)frame->frag * MODEM_TX_FRAGMENT_PAYLOAD_LEN;
+        uint32_t left = frame->ext_len - pos;
+
+        tx_frag_hdr[0] = MODEM_TX_FRAGMENT_MARKER;
+        tx_frag_hdr[1] = frame->msg_id;
+        tx_frag_hdr[2] = frame->frag;
+        tx_frag_hdr[3] = frame->frag_count;
+        hdr = tx_frag_hdr;
+        hdr_len = MODEM_TX_FRAGMENT_HDR_LEN;
+        pkg = &frame->ext[pos];
+        len = (uint16_t)((left < MODEM_TX_FRAGMENT_PAYLOAD_LEN) ? left : MODEM_TX_FRAGMENT_PAYLOAD_LEN);
+    }
+
+    tx_in_flight = true;
+    tx_release_sent = false;
+    if (Modem_Umi_CnxTypeIsTCP())
+    {
+        /* TCP acknowledges and closes over the air, no release assistance */
+        Modem_Cmd_SendTcpPacket(hdr, hdr_len, pkg, len);
+    }
+    else if (Modem_Umi_CnxTypeIsUDP())
+    {
+        tx_release_sent = last && (tx_release != modem_tx_release_none);
+        Modem_Cmd_SendUdpPacket(hdr, hdr_len, pkg, len, Modem_Umi_CfgGetRemoteAddress(), Modem_Umi_CfgGetRemotePort(),
+                                tx_release_sent ? (uint8_t)tx_release : (uint8_t)modem_tx_release_none);
+    }
+    else
+    {
+        MODEM_PRINTF_ERROR("Invalid cnx configuration!\n");
+    }
+}
+
+/* drops the frames whose lifetime passed, not while a frame is being sent */
+static void Modem_TxQueueExpire(void)
+{
+    uint32_t uptime = Rtc_GetUptimeSeconds();
+    uint8_t first = Modem_TxQueueHeadLocked() ? 1U : 0U;
+
+    if (tx_in_flight)
+    {
+        return;
+    }
+    for (uint8_t i = tx_queue_count; i > first; i--)
+    {
+        if ((tx_queue[i - 1U].expiry != 0U) && (uptime >= tx_queue[i - 1U].expiry))
+        {
+            Modem_TxQueueRemove(i - 1U, modem_tx_result_expired);
+            Sched_SetEvent(SCHED_MODEM_NEXT_ACTION);
+        }
+    }
+}
+
+/* drops the frames which stayed queued for MODEM_TX_SESSIONS_MAX sessions */
+static void Modem_TxQueueSessionEnd(void)
+{
+    for (uint8_t i = tx_queue_count; i > 0U; i--)
+    {
+        if (++tx_queue[i - 1U].sessions >= MODEM_TX_SESSIONS_MAX)
+        {
+            Modem_TxQueueRemove(i - 1U, modem_tx_result_failed);
+        }
+    }
+}
+
 void Modem_QueueTxFrame(const uint8_t *b, uint16_t bs)
 {
+    (void)Modem_QueueTxFrameEx(b, bs, MODEM_TX_PRIORITY_NORMAL, 0U, NULL, 0U);
+}
+
+/*!
+ * \brief Queues an uplink frame, the queued frames are sent back to back in
+ *        one session
+ *
+ * \param priority frames with a higher priority are sent first
+ * \param lifetime_s the frame is dropped when it could not be sent within
+ *                   this time, 0 keeps it until it is sent
+ * \param cb called once the frame was sent, expired or failed, may be NULL
+ * \param tag passed to cb
+ *
+ * \return false if the frame does not fit into the queue or starts with
+ *         MODEM_TX_FRAGMENT_MARKER
+ */
+bool Modem_QueueTxFrameEx(const uint8_t *b, uint16_t bs, uint8_t priority, uint32_t lifetime_s, Modem_TxFrameDoneCb cb, uint16_t tag)
+{
+    struct modem_tx_frame_s *frame;
+
+    if ((tx_queue_count >= MODEM_TX_QUEUE_FRAMES) || (bs > EX_TX_BUFFER_SIZE - tx_queue_bytes))
+    {
+        MODEM_PRINTF_ERROR("tx queue full, frame %u (%u bytes) dropped\n", tag, bs);
+        return false;
+    }
+    if ((bs > 0U) && (b[0] == MODEM_TX_FRAGMENT_MARKER))
+    {
+        /* the head-end would take it for a fragment */
+        MODEM_PRINTF_ERROR("frame %u starts with the fragment marker, dropped\n", tag);
+        return false;
+    }
     MODEM_PRINTF_WARN("Queued frame, now send it ... !\n");
-#if 0
-    memcpy(ex_tx_buffer, pkg, sizeof(pkg));
-#else
-    memcpy(ex_tx_buffer, b, (size_t)bs);
-#endif
-    modem_queuedTxPkg = ex_tx_buffer;
-    modem_queuedTxPkgLen = bs;
-    Sched_SetEvent(SCHED_MODEM_NEXT_ACTION);
+
+    if (bs > 0U)
+    {
+        memcpy(&ex_tx_buffer[tx_queue_bytes], b, (size_t)bs);
+    }
+
+    frame = Modem_TxQueueInsert(priority, lifetime_s, cb, tag);
+    frame->len = bs;
+    tx_queue_bytes += bs;
+    return true;
+}
+
+/*!
+ * \brief Queues a payload of any size, it is sent in fragments of at most
+ *        MODEM_TX_FRAGMENT_LEN bytes back to back in one session
+ *
+ * Every fragment starts with a MODEM_TX_FRAGMENT_HDR_LEN byte header:
+ * MODEM_TX_FRAGMENT_MARKER, message id, fragment index, fragment count.
+ * The payload is not copied, b must stay valid until cb is called.
+ * A payload is only dropped on expiry before its first fragment was sent,
+ * it fails as a whole like a frame.
+ *
+ * \return false if the queue is full or the payload needs more than 255 fragments
+ */
+bool Modem_QueueTxPayload(const uint8_t *b, uint32_t bs, uint8_t priority, uint32_t lifetime_s, Modem_TxFrameDoneCb cb, uint16_t tag)
+{
+    uint32_t frags = (bs + MODEM_TX_FRAGMENT_PAYLOAD_LEN - 1U) / MODEM_TX_FRAGMENT_PAYLOAD_LEN;
+    struct modem_tx_frame_s *frame;
+
+    if ((tx_queue_count >= MODEM_TX_QUEUE_FRAMES) || (b == NULL) || (frags == 0U) || (frags > UINT8_MAX))
+    {
+        MODEM_PRINTF_ERROR("payload %u (%u bytes) dropped\n", tag, bs);
+        return false;
+    }
+    MODEM_PRINTF_WARN("Queued payload of %u bytes in %u fragments\n", bs, frags);
+
+    frame = Modem_TxQueueInsert(priority, lifetime_s, cb, tag);
+    frame->ext = b;
+    frame->ext_len = bs;
+    frame->frag_count = (uint8_t)frags;
+    frame->msg_id = tx_msg_id++;
+    return true;
+}
+
+uint8_t Modem_TxFramesQueued(void)
+{
+    return tx_queue_count;
+}
+
+/*!
+ * \brief Borrows the last received frame
+ *
+ * The view points into the raw rx buffer of the AT layer and stays valid
+ * until Modem_ReleaseRxFrame() is called or the next frame is received.
+ *
+ * \return true if a frame is available
+ */
+bool Modem_PeekRxFrame(const uint8_t **p, uint16_t *len)
+{
+    *p = ex_rx_frame;
+    *len = ex_rx_frame_len;
+    return ex_rx_frame_len > 0U;
+}
+
+void Modem_ReleaseRxFrame(void)
+{
+    ex_rx_frame = NULL;
+    ex_rx_frame_len = 0U;
+}
+
+/*!
+ * \brief Registers a callback receiving downlink frames in chunks
+ *
+ * With a callback registered frames are no longer collected in the raw rx
+ * buffer, so they are not limited in size and Modem_PeekRxFrame() stays
+ * empty. NULL switches back to whole frames. Takes effect with the next
+ * frame.
+ */
+void Modem_SetRxChunkCb(Modem_RxChunkCb cb)
+{
+    ex_rx_chunk_cb = cb;
+    Modem_At_SetRawStream(cb != NULL);
+}
+
+/*!
+ * \brief Overlaps the network registration with the information reads
+ *
+ * When enabled, AT+CFUN=1,1 is sent as soon as the configuration is
+ * verified. ICCID, active band and signal quality are read while the modem
+ * searches the network, +CEREG then moves the session on. Disabled by
+ * default, the modem is activated once everything is read.
+ */
+void Modem_SetRegistrationPipeline(bool enable)
+{
+    registration_pipeline = enable;
+}
+
+/*!
+ * \brief Marks the frames queued for this session as its last uplink
+ *
+ * The last frame (or fragment) of the queue is sent with the release
+ * assistance indication, the network releases the radio connection right
+ * after it or after the single reply instead of waiting for its inactivity
+ * timer. Without a reply expected the session ends without waiting for
+ * one, with a reply it ends once the reply was read or the wait timed out.
+ * Only for UDP, reset when the session ends.
+ */
+void Modem_SetTxRelease(enum modem_tx_release_e release)
+{
+    tx_release = release;
+}
+
+/*!
+ * \brief Sets the bytes read per AT+KUDPRCV/AT+KTCPRCV
+ *
+ * Larger frames are read in several chunks back to back and handed over as
+ * one frame. Clamped to 1..MODEM_RX_READ_SIZE_MAX.
+ */
+void Modem_SetRxReadSize(uint16_t size)
+{
+    if (size == 0U)
+    {
+        size = 1U;
+    }
+    rx_read_size = (size < MODEM_RX_READ_SIZE_MAX) ? size : MODEM_RX_READ_SIZE_MAX;
 }
 
 void Modem_GetLastRxFrame(uint8_t *b, uint16_t *bs)
 {
-    memcpy(b, ex_rx_buffer, (size_t)ex_rx_buffer_len);
-    *bs = ex_rx_buffer_len;
-    ex_rx_buffer_len = 0U;
+    const uint8_t *p;
+
+    *bs = 0U;
+    if (Modem_PeekRxFrame(&p, bs))
+    {
+        memcpy(b, p, (size_t)*bs);
+    }
+    Modem_ReleaseRxFrame();
 }
 
 bool Modem_IsRfActive(void)
@@ -18,6 +18,8 @@ System level includes
 
 #include <string.h>
 #include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
 #include <stdio.h>
 
 #include <test_modem_app.h>
@@ -29,6 +31,7 @@ Project level includes
 #include <os/sched.h>
 #include <os/timer.h>
 #include <os/debug.h>
+#include <os/utils.h>
 
 #include <modem/modem.h>
 
@@ -38,7 +41,9 @@ Local includes
 #include <modem_hal.h>
 #include <modem_at.h>
 #include <modem_debug.h>
+#include <modem_log.h>
 #include <modem_stats.h>
+#include <modem_latency.h>
 
 /*-----------------------------------------------------------------------------
 Public data
@@ -49,40 +54,125 @@ struct modem_info_s modemInfo; /* shared with modem.c */
 Private defines
 -----------------------------------------------------------------------------*/
 #define AT_QUEUE_COUNT  8
-#define AT_QUEUE_CMD_LEN_MAX    128
-#define MODEM_AT_TIMEOUT_TIME_MS    4000
 #define MODEM_AT_MSG_LEN_MAX    256UL
 
+/* longest received AT line including its terminator, longer lines are discarded */
+#ifndef MODEM_AT_RX_LINE_LEN_MAX
+#define MODEM_AT_RX_LINE_LEN_MAX    256
+#endif
+
 #define strtou8(...)    (uint8_t)strtoul(__VA_ARGS__)
 #define strtou16(...)    (uint16_t)strtoul(__VA_ARGS__)
 #define strtos8(...)    (int8_t)strtol(__VA_ARGS__)
 
+/* commands of one compound command line */
+#define AT_BATCH_CMDS_MAX   12
+
 #define MODEM_EOF_PATTERN_LEN   16
+#define MODEM_AT_ARG_MAX        32
 #define printf mexPrintf
 /*-----------------------------------------------------------------------------
 Private data types
 -----------------------------------------------------------------------------*/
-/* None */
+typedef void (*at_ind_handler_t)(int32_t argc, char **argp);
+
+struct at_ind_entry_s
+{
+    const char *prefix;
+    at_ind_handler_t handler;
+    uint8_t min_argc;
+};
+
+enum at_field_type_e
+{
+    at_field_u8,
+    at_field_u16,
+    at_field_s8,
+    at_field_str,
+    at_field_hex, /* string of hex digits, e.g. a band bitmap */
+};
+
+/* one response argument stored into struct modem_info_s */
+struct at_field_s
+{
+    uint8_t arg; /* index in argp */
+    uint8_t type; /* enum at_field_type_e */
+    uint16_t offset; /* offset of the destination in struct modem_info_s */
+    int16_t min; /* lower bound of integers */
+    int16_t max; /* upper bound of integers, size of the destination of strings */
+};
+
+/*
+ * Fields of a response. With sel_count > 0 the argument sel_arg selects one
+ * of sel_count records, sel_stride bytes apart, the first one for sel_min.
+ */
+struct at_rsp_desc_s
+{
+    const struct at_field_s *fields;
+    uint8_t count;
+    uint8_t sel_arg;
+    uint8_t sel_min;
+    uint8_t sel_count;
+    uint16_t sel_stride;
+};
+
+/* command answered by a line without prefix, e.g. AT+CGSN */
+struct at_bare_rsp_s
+{
+    const char *cmd;
+    char *dest;
+    uint8_t size;
+};
+
+/* command waiting in the queue while a response is pending */
+struct at_queue_entry_s
+{
+    char cmd[MODEM_AT_CMD_LEN_MAX]; /* without "AT" and "\r" */
+    uint32_t timeout_ms;
+    Modem_AtCmdDoneCb cb;
+};
+
+#define AT_FIELD_INT(arg, type, member, min, max) {(arg), (type), (uint16_t)offsetof(struct modem_info_s, member), (min), (max)}
+#define AT_FIELD_STR(arg, type, member) {(arg), (type), (uint16_t)offsetof(struct modem_info_s, member), 0, (int16_t)sizeof(((struct modem_info_s *)0)->member)}
 
 /*-----------------------------------------------------------------------------
 Private functions - declare static
 -----------------------------------------------------------------------------*/
-static void AtCmdDone(void);
+static void AtCmdDone(enum modem_at_result_e result);
+static void AtCmdTransmit(const char *cmd, uint32_t timeout_ms, Modem_AtCmdDoneCb cb);
+static void AtQueueDispatch(void);
+static void AtBatchPrepare(const char *cmd);
+static void AtBatchBareRsp(const char *line);
+static bool AtIdle(void);
+static void AtTxArm(uint32_t timeout_ms, bool latency);
+static void AtTxRejected(void);
 static void AtCmdIndClean(int32_t argc, char **argp);
-static void AtCmdIndication(char *cmd, int len);
+static void AtCmdIndication(void);
 static void Modem_SendQueuedMsg(void);
-static size_t gen_cmd_tx_frame_data(uint8_t *at_cmd, size_t maxLen);
 
 /*-----------------------------------------------------------------------------
 Private data - declare static
 -----------------------------------------------------------------------------*/
-static char at_rx_buffer[2048];
+static char at_rx_buffer[MODEM_AT_RX_LINE_LEN_MAX];
 static int at_rx_in = 0;
+static bool at_rx_discard = false; /* skipping the rest of an overlong line */
+
+/* argument spans of the current line, built while the bytes arrive */
+static char *at_argp[MODEM_AT_ARG_MAX];
+static int32_t at_argc = 0;
+static int at_arg_start = 0;
+static bool at_arg_colon = false;
 static bool sendRawData = false;
 static egm_bool_t waitForData = FALSE;
 
 static char raw_rx_buffer[4096];
 static uint16_t raw_rx_in = 50;//changed from 0  to 50
+static uint16_t raw_rx_drop = 0;
+static uint8_t raw_eof_match = 0;
+/* streaming raw rx, payload is passed on while it arrives */
+static bool raw_stream_enabled = false;
+static bool raw_rx_stream = false;
+static uint32_t raw_stream_len = 0U;
 
 static int queueRx = 0;
 static uint16_t queueTx = 0U;
@@ -91,11 +181,43 @@ static char *infoReq = NULL;
 
 static char modemValueTemp[32];
 
-static uint8_t *queuedTxPkg = NULL;
+static const uint8_t *queuedTxHdr = NULL;
+static uint8_t queuedTxHdrLen = 0U;
+static const uint8_t *queuedTxPkg = NULL;
 static uint16_t queuedTxPkgLen = 0;
 
 
+/* the one tx line, "AT" stays in front */
+static char at_tx_line[MODEM_AT_MSG_LEN_MAX] = "AT";
+
 static bool atWaitForRsp = false;
+static Modem_AtCmdDoneCb at_cmd_cb = NULL; /* completion of the pending command */
+
+/* transmission running, its response timeout starts with the last byte */
+static bool at_tx_pending = false;
+static bool at_tx_latency = false;
+static uint32_t at_tx_timeout_ms = 0U;
+
+/*
+ * Within a compound command line, e.g. AT+CGMR;+CGSN;+KGSN=3, the responses
+ * without prefix are assigned by their order.
+ */
+static const struct at_bare_rsp_s at_bare_rsp[] =
+{
+    {"I",       modemInfo.model,        sizeof(modemInfo.model)},
+    {"+CGMM",   modemInfo.model,        sizeof(modemInfo.model)},
+    {"+CGMR",   modemInfo.SW_release,   sizeof(modemInfo.SW_release)},
+    {"+CGSN",   modemInfo.imei,         sizeof(modemInfo.imei)},
+};
+
+/* bare responses expected by the pending compound command line */
+static const struct at_bare_rsp_s *at_batch_bare[AT_BATCH_CMDS_MAX];
+static uint8_t at_batch_bare_count = 0U;
+static uint8_t at_batch_bare_next = 0U;
+
+static struct at_queue_entry_s at_queue[AT_QUEUE_COUNT];
+static uint8_t at_queue_head = 0U;
+static uint8_t at_queue_count = 0U;
 
 #if 0
 struct
@@ -116,1154 +238,1566 @@ static char currCmd[32] = {0};
 static bool at_ready_rcvd = false;
 
 const char xeofPattern[MODEM_EOF_PATTERN_LEN + 1] = "--EOF--Pattern--";
+/* KMP failure function of xeofPattern: length of the longest proper prefix
+ * which is also a suffix of the first n + 1 pattern bytes */
+static const uint8_t xeofFailure[MODEM_EOF_PATTERN_LEN] = {0, 1, 0, 0, 0, 1, 2, 0, 0, 0, 0, 0, 0, 0, 1, 2};
 
 
 /*-----------------------------------------------------------------------------
 Private Function implementations
 -----------------------------------------------------------------------------*/
 
-static bool str_starts_with(const char *s1, const char *s2)
-{
-    return (strncmp(s1, s2, strlen(s2)) == 0);
-}
-
 static void Modem_AtRawRxStart(void)
 {
+    /* a frame the application still borrows is overwritten now */
+    Modem_ReleaseRxFrame();
     waitForData = true;
     raw_rx_in = 0;
+    raw_rx_drop = 0;
+    raw_eof_match = 0;
+    raw_rx_stream = raw_stream_enabled;
+    raw_stream_len = 0U;
 }
 
-static void Modem_AtPut(char chr)
+/*!
+ * \brief Feeds raw data bytes into the EOF pattern matcher
+ *
+ * KMP matcher, the number of matched pattern bytes is kept in raw_eof_match
+ * so a pattern split over several blocks is found as well. Outside of a
+ * partial match the scan jumps to the next '-' with memchr.
+ *
+ * \return number of bytes scanned, up to and including the end of the pattern
+ */
+static size_t Modem_AtMatchEof(const char *buf, size_t len)
 {
-    if (waitForData)
+    size_t i = 0;
+
+    while (i < len)
     {
-        if (raw_rx_in < 4096U)
+        if (raw_eof_match == 0U)
+        {
+            const char *p = memchr(&buf[i], xeofPattern[0], len - i);
+
+            if (p == NULL)
+            {
+                return len;
+            }
+            i = (size_t)(p - buf);
+        }
+
+        while ((raw_eof_match > 0U) && (buf[i] != xeofPattern[raw_eof_match]))
+        {
+            raw_eof_match = xeofFailure[raw_eof_match - 1U];
+        }
+        if (buf[i] == xeofPattern[raw_eof_match])
+        {
+            raw_eof_match++;
+        }
+        i++;
+
+        if (raw_eof_match == MODEM_EOF_PATTERN_LEN)
         {
-            raw_rx_buffer[raw_rx_in] = chr;
-            raw_rx_in++;
+            break;
         }
     }
-    else
+    return i;
+}
+
+static void Modem_AtRawRxDone(void)
+{
+    uint16_t patternLen = MODEM_EOF_PATTERN_LEN;
+
+    // Entire pattern has been matched
+    MODEM_PRINTF_INFO("Pattern detected!\nrx(%d): <RAW[%d]--EOF--Pattern--\n", raw_rx_in, raw_rx_in - (patternLen + 1));
+    if (queueRx != raw_rx_in - (patternLen + 1))
     {
-        at_rx_buffer[at_rx_in] = chr;
-        at_rx_in++;
+        MODEM_PRINTF_ERROR("data length mismatch!\n");
     }
 
-    if (waitForData)
-    {
-#ifdef MODEM_PRINT_RX_DATA
-        Console_Printf("%c", chr);
+    waitForData = FALSE;
+    queueRx = 0;
+
+#ifdef MODEM_PRINT_RAW_RX_DATA
+    /* this may cause problems because it contains binary data */
+    PRINTF_INFO("%s", raw_rx_buffer);
 #endif
+    /*
+     * drop first byte because we see the \r\n and connect will be treated before the second was received
+     */
+    if (raw_rx_drop > 0U)
+    {
+        MODEM_PRINTF_ERROR("raw rx overflow, %u bytes dropped!\n", raw_rx_drop);
+        Modem_NoDatIndication();
+    }
+    else if (raw_rx_in > (patternLen + 1))
+    {
+        uint16_t rx_pkg_len = raw_rx_in - (patternLen + 1);
+        Modem_Stats_UDPRxBytes(rx_pkg_len);
+        /* the frame stays in raw_rx_buffer until the next raw rx starts */
+        Modem_RawDataRecvdInd(&raw_rx_buffer[1], rx_pkg_len);
+        raw_rx_in = 0U;
+    }
+    else
+    {
+        MODEM_PRINTF_ERROR("no data!\n");
+        Modem_NoDatIndication();
+    }
+}
 
-        uint16_t patternLen = MODEM_EOF_PATTERN_LEN;
+static void Modem_AtRawStreamOut(const char *buf, size_t len, bool last)
+{
+    raw_stream_len += (uint32_t)len;
+    Modem_Stats_UDPRxBytes((uint16_t)len);
+    Modem_RawDataChunkInd(buf, len, last);
+}
 
-        if (raw_rx_in > (patternLen + 1))
-        {
-            if (memcmp(&raw_rx_buffer[raw_rx_in - patternLen], xeofPattern, (uint32_t)patternLen) == 0)
-            {
-                // Entire pattern has been matched
-                MODEM_PRINTF_INFO("Pattern detected!\nrx(%d): <RAW[%d]--EOF--Pattern--\n", raw_rx_in, raw_rx_in - (patternLen + 1));
-                if (queueRx != raw_rx_in - (patternLen + 1))
-                {
-                    MODEM_PRINTF_ERROR("data length mismatch!\n");
-                }
+static void Modem_AtRawStreamDone(void)
+{
+    MODEM_PRINTF_INFO("Pattern detected!\nrx stream: <RAW[%lu]--EOF--Pattern--\n", (unsigned long)raw_stream_len);
+    if ((uint32_t)queueRx != raw_stream_len)
+    {
+        MODEM_PRINTF_ERROR("data length mismatch!\n");
+    }
 
-                waitForData = FALSE;
-                queueRx = 0;
+    waitForData = FALSE;
+    queueRx = 0;
 
-#ifdef MODEM_PRINT_RAW_RX_DATA
-                /* this may cause problems because it contains binary data */
-                PRINTF_INFO("%s", raw_rx_buffer);
-#endif
-                /*
-                 * drop first byte because we see the \r\n and connect will be treated before the second was received
-                 */
-                if (raw_rx_in > (patternLen + 1))
-                {
-                    uint16_t rx_pkg_len = raw_rx_in - (patternLen + 1);
-                    Modem_Stats_UDPRxBytes(rx_pkg_len);
-                    Modem_RawDataRecvdInd(&raw_rx_buffer[1], rx_pkg_len);
-                    memset(raw_rx_buffer, 0, sizeof(raw_rx_buffer));
-                    raw_rx_in = 0U;
-                }
-                else
-                {
-                    MODEM_PRINTF_ERROR("no data!\n");
-                    Modem_NoDatIndication();
-                }
-            }
-        }
+    if (raw_stream_len == 0U)
+    {
+        MODEM_PRINTF_ERROR("no data!\n");
+        Modem_NoDatIndication();
     }
-    else if (chr == '\r' || chr == '\n')
+}
+
+/*!
+ * \brief Passes raw data on while it arrives, until the EOF pattern is received
+ *
+ * Only the bytes which may still be the start of the EOF pattern are held
+ * back. They always equal the first raw_eof_match bytes of xeofPattern, so
+ * they are not stored but replayed from the pattern when the match breaks.
+ *
+ * \return number of bytes consumed, the remaining bytes belong to the AT stream
+ */
+static size_t Modem_AtPutRawStream(const char *buf, size_t len)
+{
+    size_t held = raw_eof_match;
+    size_t n, out, replay;
+    bool done;
+
+    if (raw_rx_in == 0U)
     {
-        if (strlen(at_rx_buffer) > 1)
-        {
-            MODEM_PRINTF_INFO("rx(%u): %s\n", strlen(at_rx_buffer), at_rx_buffer);
+        /* the first byte is the \n behind CONNECT */
+        raw_rx_in = 1U;
+        return 1U;
+    }
 
-            if (str_starts_with(at_rx_buffer, "OK"))
-            {
-                MODEM_PRINTF_SUCCESS("#operation successful\n");
-            }
-            if (str_starts_with(at_rx_buffer, "ERROR"))
-            {
-                MODEM_PRINTF_ERROR("#operation failed\n");
-            }
-            if (str_starts_with(at_rx_buffer, "+KCNX_IND: 1,1"))
-            {
-                MODEM_PRINTF_SUCCESS("#connected\n");
-            }
-            if (str_starts_with(at_rx_buffer, "+CEREG: 5"))
-            {
+    n = Modem_AtMatchEof(buf, len);
+    done = (raw_eof_match == MODEM_EOF_PATTERN_LEN);
 
-            }
-            if (str_starts_with(at_rx_buffer, "+KTCP_IND: 1,1"))
-            {
-                MODEM_PRINTF_SUCCESS("\n#TCP connection established");
-            }
-            Modem_Stats_AtRxCmd(1);
-            AtCmdIndication(at_rx_buffer, at_rx_in);
-        }
-        at_rx_in = 0;
-        memset(at_rx_buffer, 0, sizeof(at_rx_buffer));
+    /* everything in front of the (partial) match is payload */
+    out = held + n - raw_eof_match;
+    replay = (out < held) ? out : held;
+
+    if (replay > 0U)
+    {
+        Modem_AtRawStreamOut(xeofPattern, replay, done && (out == replay));
+    }
+    if (out > replay)
+    {
+        Modem_AtRawStreamOut(buf, out - replay, done);
+    }
+    else if (done && (out == 0U) && (raw_stream_len > 0U))
+    {
+        /* the pattern completed at the start of this block */
+        Modem_AtRawStreamOut(buf, 0U, true);
     }
 
-    if (at_rx_in >= 2048)
+    if (done)
     {
-        MODEM_PRINTF_ERROR("at_rx_buffer full\n");
-        at_rx_in = 0;
+        Modem_AtRawStreamDone();
     }
+    return n;
 }
 
-static void AtCmdDone(void)
+/*!
+ * \brief Stores raw data until the EOF pattern is received
+ *
+ * \return number of bytes consumed, the remaining bytes belong to the AT stream
+ */
+static size_t Modem_AtPutRaw(const char *buf, size_t len)
 {
-    atWaitForRsp = false;
-    Timer_Stop(SCHED_MODEM_AT_TIMEOUT);
-    if (queueTx != 0U)
+    size_t n;
+
+#ifdef MODEM_PRINT_RX_DATA
+    Console_Printf("%.*s", (int)len, buf);
+#endif
+
+    if (raw_rx_stream)
     {
-        MODEM_PRINTF_WARN("wait for connect\n");
-        return;
+        return Modem_AtPutRawStream(buf, len);
+    }
+
+    if ((raw_rx_in == 0U) && (raw_rx_drop == 0U))
+    {
+        /* the first byte is the \n behind CONNECT, it is never part of the pattern */
+        n = 1U;
+    }
+    else
+    {
+        n = Modem_AtMatchEof(buf, len);
+    }
+
+    /* bytes exceeding the buffer are dropped, but still scanned for the pattern */
+    size_t space = sizeof(raw_rx_buffer) - raw_rx_in;
+    size_t copy = (n < space) ? n : space;
+
+    memcpy(&raw_rx_buffer[raw_rx_in], buf, copy);
+    raw_rx_in = (uint16_t)(raw_rx_in + copy);
+    raw_rx_drop = (uint16_t)(raw_rx_drop + (n - copy));
+
+    if (raw_eof_match == MODEM_EOF_PATTERN_LEN)
+    {
+        Modem_AtRawRxDone();
     }
+    return n;
 }
 
-void AtCmdIndClean(int32_t argc, char **argp)
+static void Modem_AtLineReset(void)
 {
-    MODEM_PRINTF_INFO("\nAtCmdInd:\n");
-    for (int n = 0; n < argc; n++)
+    at_rx_in = 0;
+    at_argc = 0;
+    at_arg_start = 0;
+    at_arg_colon = false;
+}
+
+/*!
+ * \brief Closes the argument span running from at_arg_start up to end
+ *
+ * Empty arguments are dropped, surrounding quotes are stripped from all but
+ * the first argument.
+ */
+static void Modem_AtArgClose(int end)
+{
+    char *arg = &at_rx_buffer[at_arg_start];
+    int len = end - at_arg_start;
+
+    if (len <= 0)
     {
-        MODEM_PRINTF_INFO("  argc[%d]:<%s>\n", n, argp[n]);
+        return;
+    }
+    if ((at_argc > 0) && (arg[0] == '\"') && (arg[len - 1] == '\"'))
+    {
+        arg[len - 1] = 0;
+        arg++;
     }
+    at_argp[at_argc++] = arg;
+}
 
-    if (argc > 0)
+/*!
+ * \brief Stores received line bytes and splits them into arguments
+ *
+ * Separators (':', '=', ',') and the line terminator are replaced by 0 so
+ * every argument span is a C string once the line is complete. A blank
+ * behind ':' is skipped.
+ */
+static void Modem_AtLineAppend(const char *buf, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
     {
+        char chr = buf[i];
+        int pos = at_rx_in++;
 
-        if (strcmp(argp[0], "OK") == 0)
+        at_rx_buffer[pos] = chr;
+
+        if (at_arg_colon)
         {
-            if (at_ready_rcvd)
+            at_arg_colon = false;
+            if (chr == ' ')
             {
-                Modem_AtIndication();
+                at_rx_buffer[pos] = 0;
+                at_arg_start = pos + 1;
+                continue;
             }
+        }
 
-            if (sendRawData)
+        switch (chr)
+        {
+        case ':':
+        case '=':
+        case ',':
+            /* the last slot takes the rest of the line */
+            if (at_argc < MODEM_AT_ARG_MAX - 1)
             {
-                MODEM_PRINTF_SUCCESS("Send data done\n");
-                sendRawData = false;
-                queueTx = 0U;
+                at_rx_buffer[pos] = 0;
+                Modem_AtArgClose(pos);
+                at_arg_start = pos + 1;
+                at_arg_colon = (chr == ':');
             }
+            break;
+        case '\r':
+        case '\n':
+            at_rx_buffer[pos] = 0;
+            break;
+        default:
+            break;
+        }
+    }
+}
 
-            if (infoReq != NULL)
-            {
-                if (strlen(modemValueTemp) > 0)
-                {
-                    strncpy(infoReq, modemValueTemp, sizeof(modemValueTemp));
-                    MODEM_PRINTF_SUCCESS("stored info: %s\n", infoReq);
-                }
-                infoReq = NULL;
-            }
-            Modem_AtReqDone();
-#if 0
-            currCmd[0] = 0;
-#endif
+/*!
+ * \brief Collects the next AT line
+ *
+ * A line exceeding MODEM_AT_RX_LINE_LEN_MAX is discarded as a whole, up to
+ * and including its terminator.
+ *
+ * \return number of bytes consumed, stops behind the first line terminator
+ */
+static size_t Modem_AtPutLine(const char *buf, size_t len)
+{
+    const char *eol = memchr(buf, '\r', len);
+    const char *lf = memchr(buf, '\n', (eol != NULL) ? (size_t)(eol - buf) : len);
 
-            AtCmdDone();
-        }
+    if (lf != NULL)
+    {
+        eol = lf;
+    }
 
-        if (strcmp(argp[0], "ERROR") == 0)
-        {
-            /* has to be tested */
-            sendRawData = false;
-            queueTx = 0U;
-            waitForData = false;
-            queueRx = 0;
+    size_t n = (eol != NULL) ? (size_t)(eol - buf) + 1U : len;
 
-            if (infoReq != NULL)
-            {
-                MODEM_PRINTF_ERROR("failed to store value!\n");
-                infoReq = NULL;
-            }
-#if 0 /* retrigger on error? pause would be missing */
-            Modem_AtReqDone();
-            currCmd[0] = 0;
-#endif
+    if (at_rx_discard)
+    {
+        at_rx_discard = (eol == NULL);
+        return n;
+    }
 
-            AtCmdDone();
+    if ((size_t)at_rx_in + n > sizeof(at_rx_buffer))
+    {
+        /* no valid response is that long, drop the line up to its terminator */
+        MODEM_PRINTF_ERROR("at line too long, discarded\n");
+        Modem_Stats_AtRxLineDiscarded();
+        Modem_AtLineReset();
+        at_rx_discard = (eol == NULL);
+        return n;
+    }
+
+    Modem_AtLineAppend(buf, n);
+
+    if (eol != NULL)
+    {
+        /* the terminator is part of the line, so a single byte is an empty line */
+        if (at_rx_in > 1)
+        {
+            Modem_AtArgClose(at_rx_in - 1);
+            Modem_Stats_AtRxCmd(1);
+            AtCmdIndication();
         }
+        Modem_AtLineReset();
+    }
 
-        if (strcmp(argp[0], "AT") == 0)
+    return n;
+}
+
+/*!
+ * \brief Feeds a block of received bytes into the AT / raw data parser
+ *
+ * The mode is re-evaluated after each line or raw frame because a line
+ * (e.g. CONNECT) may switch into raw mode and the EOF pattern back.
+ */
+static void Modem_AtPutBlock(const char *buf, size_t len)
+{
+    while (len > 0U)
+    {
+        size_t used;
+
+        if (waitForData)
         {
-            at_ready_rcvd = true;
-            // Modem_AtIndication();
+            used = Modem_AtPutRaw(buf, len);
         }
         else
         {
-            at_ready_rcvd = false;
+            used = Modem_AtPutLine(buf, len);
         }
+        buf += used;
+        len -= used;
+    }
+}
 
+static void Modem_AtPut(char chr)
+{
+    Modem_AtPutBlock(&chr, 1U);
+}
 
-        /*
-         * +CME
-         */
-        if (strcmp(argp[0], "+CME") == 0)
-        {
-            if (argc == 3)
-            {
-                if (strcmp(argp[1], "ERROR") == 0)
-                {
-#ifdef MODEM_DEBUG_PRINTF_ENABLED
-                    if (strcmp(argp[2], "3") == 0)
-                    {
-                        MODEM_PRINTF_ERROR("3 Operation not allowed\n");
-                    }
-                    if (strcmp(argp[2], "4") == 0)
-                    {
-                        MODEM_PRINTF_ERROR("4 Operation not supported\n");
-                    }
-                    else if (strcmp(argp[2], "910") == 0)
-                    {
-                        MODEM_PRINTF_ERROR("910 (Bad Session ID) for undefined <session_id>s\n");
-                    }
-                    else if (strcmp(argp[2], "912") == 0)
-                    {
-                        MODEM_PRINTF_ERROR("912 No more sessions can be used (maximum session is 6)\n");
-                    }
-                    else if (strcmp(argp[2], "921") == 0)
-                    {
-                        MODEM_PRINTF_ERROR("Error due to invalid state of bearer connection\n");
-                    }
-                    else if (strcmp(argp[2], "911") == 0)
-                    {
-                        MODEM_PRINTF_ERROR("Session is already running\n");
-                    }
-                    else if (strcmp(argp[2], "916") == 0)
-                    {
-                        MODEM_PRINTF_ERROR("A parameter has an invalid range of values\n");
-                    }
-                    else if (strcmp(argp[2], "923") == 0)
-                    {
-                        MODEM_PRINTF_ERROR("rror due to invalid state of terminate port data mode\n");
-                    }
-                    else
-                    {
-                        MODEM_PRINTF_ERROR("Unknown error occurred\n");
-                    }
-#endif
-                    int errorNum = strtol(argp[2], NULL, 10);
-                    Modem_ErrorInd(errorNum);
-                }
-            }
+static void AtCmdDone(enum modem_at_result_e result)
+{
+    Modem_AtCmdDoneCb cb = at_cmd_cb;
 
-            AtCmdDone();
-        }
+    Modem_Latency_Done(result);
+    atWaitForRsp = false;
+    at_cmd_cb = NULL;
+    at_tx_pending = false;
+    at_batch_bare_count = 0U;
+    at_batch_bare_next = 0U;
+    Timer_Stop(SCHED_MODEM_AT_TIMEOUT);
+    if (queueTx != 0U)
+    {
+        MODEM_PRINTF_WARN("wait for connect\n");
+    }
+
+    if (cb != NULL)
+    {
+        cb(result);
+    }
+    else if (result == modem_at_result_timeout)
+    {
+        Modem_AtReqTimeout();
+    }
+
+    AtQueueDispatch();
+}
+
+static void AtCmdIndOk(int32_t argc, char **argp)
+{
+    (void)argc;
+    (void)argp;
+    if (at_ready_rcvd)
+    {
+        Modem_AtIndication();
+    }
+
+    if (sendRawData)
+    {
+        MODEM_PRINTF_SUCCESS("Send data done\n");
+        sendRawData = false;
+        queueTx = 0U;
+    }
 
-        /* Extended Error message */
-        if (strcmp(argp[0], "+CME ERROR") == 0)
+    if (infoReq != NULL)
+    {
+        if (strlen(modemValueTemp) > 0)
         {
-            if (argc == 2)
-            {
-#ifdef MODEM_DEBUG_PRINTF_ENABLED
-                if (strcmp(argp[1], "3") == 0)
-                {
-                    MODEM_PRINTF_ERROR("3 Operation not allowed\n");
-                }
-                if (strcmp(argp[1], "4") == 0)
-                {
-                    MODEM_PRINTF_ERROR("4 Operation not supported\n");
-                }
-                else if (strcmp(argp[1], "910") == 0)
-                {
-                    MODEM_PRINTF_ERROR("910 (Bad Session ID) for undefined <session_id>s\n");
-                }
-                else if (strcmp(argp[1], "921") == 0)
-                {
-                    MODEM_PRINTF_ERROR("Error due to invalid state of bearer connection\n");
-                }
-                else if (strcmp(argp[1], "911") == 0)
-                {
-                    MODEM_PRINTF_ERROR("Session is already running\n");
-                }
-                else if (strcmp(argp[1], "916") == 0)
-                {
-                    MODEM_PRINTF_ERROR("A parameter has an invalid range of values\n");
-                }
-                else if (strcmp(argp[1], "923") == 0)
-                {
-                    MODEM_PRINTF_ERROR("Error due to invalid state of terminate port data mode\n");
-                }
-                else
-                {
-                    MODEM_PRINTF_ERROR("Unknown error occurred\n");
-                }
-#endif
-                int errorNum = strtol(argp[1], NULL, 10);
-                Modem_ErrorInd(errorNum);
-            }
+            strncpy(infoReq, modemValueTemp, sizeof(modemValueTemp));
+            MODEM_PRINTF_SUCCESS("stored info: %s\n", infoReq);
+        }
+        infoReq = NULL;
+    }
+    /* commands with a completion callback are not part of the state machine */
+    if (at_cmd_cb == NULL)
+    {
+        Modem_AtReqDone();
+    }
 #if 0
-            currCmd[0] = 0;
+    currCmd[0] = 0;
 #endif
 
-            AtCmdDone();
-        }
+    AtCmdDone(modem_at_result_ok);
+}
+
+static void AtCmdIndError(int32_t argc, char **argp)
+{
+    (void)argc;
+    (void)argp;
+    /* has to be tested */
+    sendRawData = false;
+    queueTx = 0U;
+    waitForData = false;
+    queueRx = 0;
+
+    if (infoReq != NULL)
+    {
+        MODEM_PRINTF_ERROR("failed to store value!\n");
+        infoReq = NULL;
+    }
+#if 0 /* retrigger on error? pause would be missing */
+    Modem_AtReqDone();
+    currCmd[0] = 0;
+#endif
+
+    AtCmdDone(modem_at_result_error);
+}
+
+/* echo of the AT ready check */
+static void AtCmdIndAt(int32_t argc, char **argp)
+{
+    (void)argc;
+    (void)argp;
+    at_ready_rcvd = true;
+}
 
-        /*
-         * +KGSN Command: Request Product Serial Number Identification and Software Version
-         */
-        if (strcmp(argp[0], "+KGSN") == 0)
+/*
+ * +CME
+ */
+static void AtCmdIndCme(int32_t argc, char **argp)
+{
+    if (argc == 3)
+    {
+        if (strcmp(argp[1], "ERROR") == 0)
         {
-            if (argc == 2)
+#ifdef MODEM_DEBUG_PRINTF_ENABLED
+            if (strcmp(argp[2], "3") == 0)
             {
-                strncpy(modemInfo.fsn, argp[1], sizeof(modemInfo.fsn) - 1U);
-                MODEM_PRINTF_INFO("information stored\n");
+                MODEM_PRINTF_ERROR("3 Operation not allowed\n");
             }
-        }
-
-        /* Command: Request Product Serial Number Identification (IMEI) */
-        if (strcmp(argp[0], "AT+CGSN") == 0)
-        {
-            if (argc == 1)
+            if (strcmp(argp[2], "4") == 0)
             {
-                infoReq = modemInfo.imei;
+                MODEM_PRINTF_ERROR("4 Operation not supported\n");
             }
-            else
+            else if (strcmp(argp[2], "910") == 0)
             {
-                if (strcmp(argp[1], "0") == 0)
-                {
-                    infoReq = modemInfo.imei;
-                }
+                MODEM_PRINTF_ERROR("910 (Bad Session ID) for undefined <session_id>s\n");
             }
-        }
-
-        /* Command: Request Model Identification */
-        if (strcmp(argp[0], "AT+CGMM") == 0)
-        {
-            if (argc == 1)
+            else if (strcmp(argp[2], "912") == 0)
             {
-                infoReq = modemInfo.model;
+                MODEM_PRINTF_ERROR("912 No more sessions can be used (maximum session is 6)\n");
             }
-        }
-
-        /* Command: Request Model Identification */
-        if (strcmp(argp[0], "ATI") == 0)
-        {
-            if (argc == 1)
+            else if (strcmp(argp[2], "921") == 0)
             {
-                infoReq = modemInfo.model;
+                MODEM_PRINTF_ERROR("Error due to invalid state of bearer connection\n");
             }
-        }
-
-        /*
-         * +CGMR/+GMR Command: Request Revision
-         * Identification
-         */
-        if (strcmp(argp[0], "AT+CGMR") == 0)
-        {
-            if (argc == 1)
+            else if (strcmp(argp[2], "911") == 0)
             {
-                infoReq = modemInfo.SW_release;
+                MODEM_PRINTF_ERROR("Session is already running\n");
             }
-        }
-
-#if 0
-        /*
-         * I Command: Request Identification
-         * Information
-         */
-        if (strcmp(argp[0], "ATI") == 0)
-        {
-            if (argc == 1)
+            else if (strcmp(argp[2], "916") == 0)
             {
-                infoReq = modemInfo.identification;
+                MODEM_PRINTF_ERROR("A parameter has an invalid range of values\n");
             }
-        }
-#endif
-        /*
-         * +CGMR/+GMR Command: Request Revision
-         * Identification
-         */
-        if (strcmp(argp[0], "+CCID") == 0)
-        {
-            if (argc == 2)
+            else if (strcmp(argp[2], "923") == 0)
             {
-                strncpy(modemInfo.ICCID, argp[1], sizeof(modemInfo.ICCID) - 1U);
-                MODEM_PRINTF_INFO("information stored\n");
+                MODEM_PRINTF_ERROR("rror due to invalid state of terminate port data mode\n");
             }
-        }
-
-        /*
-         * +CFUN Command: Set Phone Functionality
-         */
-        //if ((strcmp(argp[0], "+CFUN") == 0) || (strcmp(argp[0], "AT+CFUN") == 0))
-        if (strcmp(argp[0], "+CFUN") == 0)
-        {
-            MODEM_PRINTF_INFO("Notification: Phone Functionality\n");
-
-            if (argc >= 2)
+            else
             {
-                int fun = strtol(argp[1], NULL, 10);
-                //modemInfo.fun = fun;
-                strncpy(modemInfo.fun, argp[1], sizeof(modemInfo.fun) - 1U);
-                switch (fun)
-                {
-                case 0:
-                    MODEM_PRINTF_INFO("0 - Minimum functionality, SIM powered off\n");
-                    break;
-                case 1:
-                    MODEM_PRINTF_INFO("1 - Full functionality\n");
-                    break;
-                case 4:
-                    MODEM_PRINTF_INFO("4 - Disable radio transmit and receive; SIM powered on. (i.e. \"Airplane Mode\")\n");
-                    break;
-                }
-                MODEM_PRINTF_INFO("information stored\n");
+                MODEM_PRINTF_ERROR("Unknown error occurred\n");
             }
+#endif
+            int errorNum = strtol(argp[2], NULL, 10);
+            Modem_ErrorInd(errorNum);
         }
+    }
 
-        if (infoReq != NULL)
-        {
-            if (strlen(argp[0]) < 32)
-            {
-                strncpy(modemValueTemp, argp[0], sizeof(modemValueTemp) - 1UL);
+    AtCmdDone(modem_at_result_error);
+}
 
-                // infoReq = NULL;
-            }
-            else
-            {
-                MODEM_PRINTF_ERROR("arg 0 too long!\n");
-            }
+/* Extended Error message */
+static void AtCmdIndCmeError(int32_t argc, char **argp)
+{
+    if (argc == 2)
+    {
+#ifdef MODEM_DEBUG_PRINTF_ENABLED
+        if (strcmp(argp[1], "3") == 0)
+        {
+            MODEM_PRINTF_ERROR("3 Operation not allowed\n");
         }
-
-        /*
-         * +KTCP_DATA Notification: Incoming Data through a
-         * TCP Connection
-         */
-        if (strcmp(argp[0], "+KTCP_DATA") == 0)
+        if (strcmp(argp[1], "4") == 0)
         {
-            MODEM_PRINTF_INFO("Notification: Incoming Data through a TCP Connection\n");
-
-            if (argc >= 3)
-            {
-                if (strcmp(argp[1], "1") == 0)
-                {
-                    uint16_t bytes_ready = strtou16(argp[2], NULL, 10);
-                    Modem_TcpDataReadyInd(bytes_ready);
-                }
-            }
+            MODEM_PRINTF_ERROR("4 Operation not supported\n");
         }
-
-        /*
-         * +KUDP_DATA Notification: Incoming Data through a
-         * TCP Connection
-         */
-        if (strcmp(argp[0], "+KUDP_DATA") == 0)
+        else if (strcmp(argp[1], "910") == 0)
         {
-            MODEM_PRINTF_INFO("Notification: Incoming Data through a UDP Connection\n");
-
-            if (argc >= 3)
-            {
-                if (strcmp(argp[1], "1") == 0)
-                {
-                    uint16_t bytes_ready = strtou16(argp[2], NULL, 10);
-                    Modem_UdpDataReadyInd(bytes_ready);
-                }
-            }
+            MODEM_PRINTF_ERROR("910 (Bad Session ID) for undefined <session_id>s\n");
+        }
+        else if (strcmp(argp[1], "921") == 0)
+        {
+            MODEM_PRINTF_ERROR("Error due to invalid state of bearer connection\n");
         }
+        else if (strcmp(argp[1], "911") == 0)
+        {
+            MODEM_PRINTF_ERROR("Session is already running\n");
+        }
+        else if (strcmp(argp[1], "916") == 0)
+        {
+            MODEM_PRINTF_ERROR("A parameter has an invalid range of values\n");
+        }
+        else if (strcmp(argp[1], "923") == 0)
+        {
+            MODEM_PRINTF_ERROR("Error due to invalid state of terminate port data mode\n");
+        }
+        else
+        {
+            MODEM_PRINTF_ERROR("Unknown error occurred\n");
+        }
+#endif
+        int errorNum = strtol(argp[1], NULL, 10);
+        Modem_ErrorInd(errorNum);
+    }
+#if 0
+    currCmd[0] = 0;
+#endif
+
+    AtCmdDone(modem_at_result_error);
+}
+
+/*
+ * +KGSN Command: Request Product Serial Number Identification and Software Version
+ */
+static void AtCmdIndKgsn(int32_t argc, char **argp)
+{
+    if (argc == 2)
+    {
+        strncpy(modemInfo.fsn, argp[1], sizeof(modemInfo.fsn) - 1U);
+        MODEM_PRINTF_INFO("information stored\n");
+    }
+}
 
-        /*
-         * +KTCPSND Command: Send Data through a TCP
-         * Connection
-         */
-        if (strcmp(argp[0], "AT+KTCPSND") == 0)
+/* Command: Request Product Serial Number Identification (IMEI) */
+static void AtCmdIndAtCgsn(int32_t argc, char **argp)
+{
+    if (argc == 1)
+    {
+        infoReq = modemInfo.imei;
+    }
+    else
+    {
+        if (strcmp(argp[1], "0") == 0)
         {
-            MODEM_PRINTF_WARN("Command: Send Data through a TCP Connection\n");
+            infoReq = modemInfo.imei;
+        }
+    }
+}
 
-            if (argc >= 3)
-            {
-                if (strcmp(argp[1], "1") == 0)
-                {
-                    uint16_t ndata = strtou16(argp[2], NULL, 10);
-                    //Modem_TcpDataReadyInd(ndata);
-                    MODEM_PRINTF_INFO("Ready to send %d bytes\n", ndata);
+/* Command: Request Model Identification */
+static void AtCmdIndAtCgmm(int32_t argc, char **argp)
+{
+    (void)argp;
+    if (argc == 1)
+    {
+        infoReq = modemInfo.model;
+    }
+}
+
+/* Command: Request Model Identification */
+static void AtCmdIndAti(int32_t argc, char **argp)
+{
+    (void)argp;
+    if (argc == 1)
+    {
+        infoReq = modemInfo.model;
+    }
+}
 
+/*
+ * +CGMR/+GMR Command: Request Revision
+ * Identification
+ */
+static void AtCmdIndAtCgmr(int32_t argc, char **argp)
+{
+    (void)argp;
+    if (argc == 1)
+    {
+        infoReq = modemInfo.SW_release;
+    }
+}
 
-                    queueTx = ndata;
+/*
+ * +CCID Command: Read ICCID
+ */
+static void AtCmdIndCcid(int32_t argc, char **argp)
+{
+    if (argc == 2)
+    {
+        strncpy(modemInfo.ICCID, argp[1], sizeof(modemInfo.ICCID) - 1U);
+        MODEM_PRINTF_INFO("information stored\n");
+    }
+}
 
-                }
-            }
+/*
+ * +CFUN Command: Set Phone Functionality
+ */
+static void AtCmdIndCfun(int32_t argc, char **argp)
+{
+    (void)argc;
+    MODEM_PRINTF_INFO("Notification: Phone Functionality\n");
+
+    int fun = strtol(argp[1], NULL, 10);
+    //modemInfo.fun = fun;
+    strncpy(modemInfo.fun, argp[1], sizeof(modemInfo.fun) - 1U);
+    switch (fun)
+    {
+    case 0:
+        MODEM_PRINTF_INFO("0 - Minimum functionality, SIM powered off\n");
+        break;
+    case 1:
+        MODEM_PRINTF_INFO("1 - Full functionality\n");
+        break;
+    case 4:
+        MODEM_PRINTF_INFO("4 - Disable radio transmit and receive; SIM powered on. (i.e. \"Airplane Mode\")\n");
+        break;
+    }
+    MODEM_PRINTF_INFO("information stored\n");
+}
+
+/*
+ * +KTCP_DATA Notification: Incoming Data through a
+ * TCP Connection
+ */
+static void AtCmdIndKtcpData(int32_t argc, char **argp)
+{
+    (void)argc;
+    MODEM_PRINTF_INFO("Notification: Incoming Data through a TCP Connection\n");
+
+    if (strcmp(argp[1], "1") == 0)
+    {
+        uint16_t bytes_ready = strtou16(argp[2], NULL, 10);
+        Modem_TcpDataReadyInd(bytes_ready);
+    }
+}
+
+/*
+ * +KUDP_DATA Notification: Incoming Data through a
+ * TCP Connection
+ */
+static void AtCmdIndKudpData(int32_t argc, char **argp)
+{
+    (void)argc;
+    MODEM_PRINTF_INFO("Notification: Incoming Data through a UDP Connection\n");
+
+    if (strcmp(argp[1], "1") == 0)
+    {
+        uint16_t bytes_ready = strtou16(argp[2], NULL, 10);
+        Modem_UdpDataReadyInd(bytes_ready);
+    }
+}
+
+/*
+ * +KTCPSND Command: Send Data through a TCP
+ * Connection
+ */
+static void AtCmdIndAtKtcpsnd(int32_t argc, char **argp)
+{
+    (void)argc;
+    MODEM_PRINTF_WARN("Command: Send Data through a TCP Connection\n");
+
+    if (strcmp(argp[1], "1") == 0)
+    {
+        uint16_t ndata = strtou16(argp[2], NULL, 10);
+        //Modem_TcpDataReadyInd(ndata);
+        MODEM_PRINTF_INFO("Ready to send %d bytes\n", ndata);
+
+
+        queueTx = ndata;
+
+    }
+}
+
+/*
+ * +KUDPSND Command: Send Data through a UDP
+ * Connection
+ */
+static void AtCmdIndAtKudpsnd(int32_t argc, char **argp)
+{
+    (void)argc;
+    if (strcmp(argp[1], "1") == 0)
+    {
+        uint16_t ndata = strtou16(argp[4], NULL, 10);
+        //uint16_t ndata = 70;
+        //Modem_TcpDataReadyInd(ndata);
+        MODEM_LOG1(MODEM_LOG_UDP_SEND_RSP, ndata);
+
+        queueTx = ndata;
+    }
+}
+
+/*
+ * +KTCPRCV Command: Receive Data through a TCP
+ * Connection
+ */
+static void AtCmdIndAtKtcprcv(int32_t argc, char **argp)
+{
+    (void)argc;
+    if (strcmp(argp[1], "1") == 0)
+    {
+        int ndata = strtol(argp[2], NULL, 10);
+        MODEM_LOG1(MODEM_LOG_TCP_RECV_RSP, ndata);
+        //waitForData = true;
+
+        queueRx = ndata;
+    }
+}
+
+/*
+ * +KUDPRCV Command: Receive Data through a UDP
+ * Connection
+ */
+static void AtCmdIndAtKudprcv(int32_t argc, char **argp)
+{
+    (void)argc;
+    if (strcmp(argp[1], "1") == 0)
+    {
+        int ndata = strtol(argp[2], NULL, 10);
+        MODEM_LOG1(MODEM_LOG_UDP_RECV_RSP, ndata);
+        //waitForData = true;
+
+        queueRx = ndata;// ndata;
+    }
+}
+
+static void AtCmdIndConnect(int32_t argc, char **argp)
+{
+    (void)argc;
+    (void)argp;
+    /* the data transfer is not part of the command latency */
+    Modem_Latency_Done(modem_at_result_ok);
+
+    /* Switch do data mode */
+    if (queueTx)
+    {
+        MODEM_PRINTF_INFO("...Data send...\n");
+        sendRawData = true;
+        queueTx = 0;
+
+        Modem_SendQueuedMsg();
+    }
+    else if (queueRx)
+    {
+        MODEM_PRINTF_INFO("...Receive...\n");
+        Modem_AtRawRxStart();
+    }
+    else
+    {
+        struct modem_hal_txv_s eof = { (const uint8_t *)xeofPattern, MODEM_EOF_PATTERN_LEN };
+
+        MODEM_PRINTF_INFO("No data to send or receive, drop!\n");
+        atWaitForRsp = true;
+        AtTxArm(MODEM_AT_TIMEOUT_TIME_MS, false);
+        if (!Modem_Hal_TxStartRaw(&eof, 1U))
+        {
+            AtTxRejected();
         }
+    }
+}
 
-        /*
-         * +KUDPSND Command: Send Data through a UDP
-         * Connection
-         */
-        if (strcmp(argp[0], "AT+KUDPSND") == 0)
+static const struct at_field_s at_fields_cgdcont[] =
+{
+    AT_FIELD_STR(1, at_field_str, pdp_context[0].cid),
+    AT_FIELD_STR(2, at_field_str, pdp_context[0].PDP_type),
+    AT_FIELD_STR(3, at_field_str, pdp_context[0].APN),
+    AT_FIELD_STR(4, at_field_str, pdp_context[0].PDP_addr),
+};
+
+/* only the first context is kept */
+static const struct at_rsp_desc_s at_rsp_cgdcont =
+{
+    at_fields_cgdcont, sizeof(at_fields_cgdcont) / sizeof(at_fields_cgdcont[0]), 1, 1, 1, sizeof(struct pdp_context_s)
+};
+
+static const struct at_field_s at_fields_kbndcfg[] =
+{
+    AT_FIELD_STR(2, at_field_hex, bnd_bitmap[0]),
+};
+
+static const struct at_rsp_desc_s at_rsp_kbndcfg =
+{
+    at_fields_kbndcfg, sizeof(at_fields_kbndcfg) / sizeof(at_fields_kbndcfg[0]), 1, RAT_CAT_M1, 3, sizeof(modemInfo.bnd_bitmap[0])
+};
+
+/* rxlev and ber use 99, the others 255 for not known */
+static const struct at_field_s at_fields_cesq[] =
+{
+    AT_FIELD_INT(1, at_field_u8, cesq.rxlev, 0, 99),
+    AT_FIELD_INT(2, at_field_u8, cesq.ber, 0, 99),
+    AT_FIELD_INT(3, at_field_u8, cesq.rscp, 0, 255),
+    AT_FIELD_INT(4, at_field_u8, cesq.ecno, 0, 255),
+    AT_FIELD_INT(5, at_field_u8, cesq.rsrq, 0, 255),
+    AT_FIELD_INT(6, at_field_u8, cesq.rsrp, 0, 255),
+};
+
+static const struct at_rsp_desc_s at_rsp_cesq =
+{
+    at_fields_cesq, sizeof(at_fields_cesq) / sizeof(at_fields_cesq[0]), 0, 0, 0, 0
+};
+
+static const struct at_field_s at_fields_kbnd[] =
+{
+    AT_FIELD_INT(1, at_field_u8, rat, RAT_CAT_M1, RAT_GSM),
+    AT_FIELD_STR(2, at_field_hex, bnd),
+};
+
+static const struct at_rsp_desc_s at_rsp_kbnd =
+{
+    at_fields_kbnd, sizeof(at_fields_kbnd) / sizeof(at_fields_kbnd[0]), 0, 0, 0, 0
+};
+
+/* missing entries of the list are cleared */
+static const struct at_field_s at_fields_kselacq[] =
+{
+    AT_FIELD_INT(1, at_field_u8, prl[0], 0, RAT_GSM + 1),
+    AT_FIELD_INT(2, at_field_u8, prl[1], 0, RAT_GSM + 1),
+    AT_FIELD_INT(3, at_field_u8, prl[2], 0, RAT_GSM + 1),
+};
+
+static const struct at_rsp_desc_s at_rsp_kselacq =
+{
+    at_fields_kselacq, sizeof(at_fields_kselacq) / sizeof(at_fields_kselacq[0]), 0, 0, 0, 0
+};
+
+/*!
+ * \brief Stores one response argument, arg is NULL if it is missing
+ *
+ * \return false if the argument is invalid or out of range
+ */
+static bool AtFieldStore(const struct at_field_s *field, uint8_t *dst, const char *arg)
+{
+    long val = 0;
+
+    if (field->type >= (uint8_t)at_field_str)
+    {
+        size_t len;
+
+        if (arg == NULL)
+        {
+            dst[0] = 0;
+            return true;
+        }
+        len = strlen(arg);
+        if ((len >= (size_t)field->max) || ((field->type == (uint8_t)at_field_hex) && (strspn(arg, "0123456789ABCDEFabcdef") != len)))
         {
-            MODEM_PRINTF_WARN("Command: Send Data through a UDP Connection\n");
-            printf("Command: Send Data through a UDP Connection\n");
+            return false;
+        }
+        memcpy(dst, arg, len + 1U);
+        return true;
+    }
 
-            if (argc >= 3)
-            {
-                if (strcmp(argp[1], "1") == 0)
-                {
-                    uint16_t ndata = strtou16(argp[4], NULL, 10);
-                    //uint16_t ndata = 70;
-                    //Modem_TcpDataReadyInd(ndata);
-                    printf("Ready to send %d bytes via UDP\n", ndata);
-
-                    queueTx = ndata;
-                }
-            }
+    if (arg != NULL)
+    {
+        char *end;
+
+        val = strtol(arg, &end, 10);
+        if ((end == arg) || (*end != 0) || (val < field->min) || (val > field->max))
+        {
+            return false;
         }
+    }
+
+    switch (field->type)
+    {
+    case at_field_u8:
+        *dst = (uint8_t)val;
+        break;
+    case at_field_s8:
+        *(int8_t *)dst = (int8_t)val;
+        break;
+    default:
+    {
+        uint16_t u16 = (uint16_t)val;
+        memcpy(dst, &u16, sizeof(u16));
+        break;
+    }
+    }
+    return true;
+}
+
+/*!
+ * \brief Fills modemInfo from the arguments of a response as described by desc
+ *
+ * Missing arguments clear their field, invalid ones leave it untouched.
+ *
+ * \return number of rejected fields
+ */
+static uint8_t AtRspParse(const struct at_rsp_desc_s *desc, int32_t argc, char **argp)
+{
+    uint8_t *base = (uint8_t *)&modemInfo;
+    uint8_t rejected = 0U;
 
-        /*
-         * +KTCPRCV Command: Receive Data through a TCP
-         * Connection
-         */
-        if (strcmp(argp[0], "AT+KTCPRCV") == 0)
+    if (desc->sel_count > 0U)
+    {
+        char *end;
+        long sel = strtol(argp[desc->sel_arg], &end, 10);
+
+        if ((end == argp[desc->sel_arg]) || (*end != 0) || (sel < desc->sel_min) || (sel >= desc->sel_min + desc->sel_count))
         {
-            MODEM_PRINTF_WARN("Command: Receive Data through a TCP Connection\n");
+            MODEM_PRINTF_ERROR("%s: record %s rejected\n", argp[0], argp[desc->sel_arg]);
+            return desc->count;
+        }
+        base += (size_t)(sel - desc->sel_min) * desc->sel_stride;
+    }
 
-            if (argc >= 3)
-            {
-                if (strcmp(argp[1], "1") == 0)
-                {
-                    int ndata = strtol(argp[2], NULL, 10);
-                    MODEM_PRINTF_INFO("Ready to receive %d bytes\n", ndata);
-                    //waitForData = true;
-
-                    queueRx = ndata;
-                }
-            }
+    for (uint8_t i = 0U; i < desc->count; i++)
+    {
+        const struct at_field_s *field = &desc->fields[i];
+
+        if (!AtFieldStore(field, &base[field->offset], (field->arg < argc) ? argp[field->arg] : NULL))
+        {
+            MODEM_PRINTF_ERROR("%s: argument %u rejected\n", argp[0], field->arg);
+            rejected++;
         }
+    }
+    return rejected;
+}
+
+/*
+ * +CGDCONT Command: Define PDP Context
+ */
+static void AtCmdIndCgdcont(int32_t argc, char **argp)
+{
+    MODEM_PRINTF_INFO("Command: Define PDP Context %d\n", argc);
+    (void)AtRspParse(&at_rsp_cgdcont, argc, argp);
+}
+
+/*
+ * +KBNDCFG Command: Set Configured LTE
+ * Band(s)
+ *
+ * 0: CAT-M1
+ * 1: NB-IoT (HL7800/HL7802/HL7810/HL7845/HL7812 only
+ * 2: GSM (for HL7802/HL7812 only)
+ */
+static void AtCmdIndKbndcfg(int32_t argc, char **argp)
+{
+    MODEM_PRINTF_INFO("Command: Set Configured LTE Band(s)\n");
+    (void)AtRspParse(&at_rsp_kbndcfg, argc, argp);
+}
 
-        /*
-         * +KUDPRCV Command: Receive Data through a UDP
-         * Connection
-         */
-        if (strcmp(argp[0], "AT+KUDPRCV") == 0)
+/*
+ * +CESQ Command: Extended Signal Quality
+ */
+static void AtCmdIndCesq(int32_t argc, char **argp)
+{
+    MODEM_PRINTF_INFO("Command: Extended Signal Quality\n");
+    (void)AtRspParse(&at_rsp_cesq, argc, argp);
+
+    modemInfo.cesq.datetime = Rtc_GetDateTime();
+    if (modemInfo.cesq.datetime == modemInfo.cesq.datetime_lastsync)
+    {
+        modemInfo.cesq.datetime++;
+    }
+}
+
+/*
+ * +KBND Command: Get Active LTE Band(s)
+ *
+ * 0: CAT-M1 (this is the only RAT available on the HL7800-M)
+ * 1: NB-IoT
+ * 2: GSM (for HL7802/HL7812 only)
+ */
+static void AtCmdIndKbnd(int32_t argc, char **argp)
+{
+    MODEM_PRINTF_INFO("Command: Get Active LTE Band(s)\n");
+    (void)AtRspParse(&at_rsp_kbnd, argc, argp);
+}
+
+/*
+ * +KSELACQ Command: Configure Preferred
+ * Radio Access Technology List (PRL)
+ */
+static void AtCmdIndKselacq(int32_t argc, char **argp)
+{
+    MODEM_PRINTF_INFO("Command: Configure Preferred Radio Access Technology List (PRL)\n");
+    modemInfo.prl_valid = true;
+    (void)AtRspParse(&at_rsp_kselacq, argc, argp);
+}
+
+/*
+ * +KTCPSTAT Command: Get TCP Socket Status
+ */
+static void AtCmdIndKtcpstat(int32_t argc, char **argp)
+{
+    MODEM_PRINTF_INFO("Command: Get TCP Socket Status\n");
+    if (argc == 6)
+    {
+        uint32_t status = strtoul(argp[2], 0, 10);
+        MODEM_PRINTF_INFO("    session_id: %s\n", argp[1]);
+        MODEM_PRINTF_INFO("    status: %d\n", status);
+        switch (status)
+        {
+        case 0:
+            MODEM_PRINTF_INFO("      (0 - Socket not defined, use +KTCPCFG to create a TCP socket)\n");
+            break;
+        case 1:
+            MODEM_PRINTF_INFO("      (1 - Socket is only defined but not used)\n");
+            break;
+        case 2:
+            MODEM_PRINTF_INFO("      (2 - Socket is opening and connecting to the server, cannot be used)\n");
+            break;
+        case 3:
+            MODEM_PRINTF_INFO("      (3 - Connection is up, socket can be used to send/receive data)\n");
+            break;
+        case 4:
+            MODEM_PRINTF_INFO("      (4 - Connection is closing, it cannot be used, wait for status 5)\n");
+            break;
+        case 5:
+            MODEM_PRINTF_INFO("      (5 - Socket is closed)\n");
+            break;
+        }
+        MODEM_PRINTF_INFO("    tcp_notif: %s\n", argp[3]);
+        if (strcmp(argp[3], "-1") == 0)
+        {
+            MODEM_PRINTF_INFO("      (-1 if socket/connection is OK)\n");
+        }
+        else
         {
-            MODEM_PRINTF_WARN("Command: Receive Data through a UDP Connection\n");
-            printf("Command: Receive Data through a UDP Connection\n");
+            MODEM_PRINTF_INFO("      (<tcp_notif> if an error has happened (see AT+KTCPCNX))\n");
+        }
+        MODEM_PRINTF_INFO("    rem_data: %s (Remaining bytes in the socket buffer, waiting to be sent)\n", argp[4]);
+        MODEM_PRINTF_INFO("    rcv_data: %s (Received bytes, can be read with +KTCPRCV command)\n", argp[5]);
+    }
+}
 
-            if (argc >= 3)
+/*
+ * +CEREG Command: EPS Network
+ * Registration Status
+ */
+static void AtCmdIndCereg(int32_t argc, char **argp)
+{
+    if (atWaitForRsp)
+    {
+#if 1
+        uint32_t n = strtoul(argp[1], 0, 10);
+        //uint32_t stat = strtoul(argp[2], 0, 10);
+        MODEM_PRINTF_INFO("    n: %s, stat: %s\n", argp[1], argp[2]);
+        switch (n)
+        {
+        case 0:
+            MODEM_PRINTF_INFO("Disable network registration unsolicited result code\n");
+            break;
+        case 2:
+            MODEM_PRINTF_INFO("Enable network registration and location information unsolicited result code\n");
+            break;
+        case 5:
+            MODEM_PRINTF_INFO("For a UE that wants to apply PSM, enable network registration, location information and EMM cause value information unsolicited result code\n");
+            break;
+        }
+        Modem_NetworkRegistrationStatusN(argp[1]);
+#endif
+    }
+    else
+    {
+        int8_t stat = strtos8(argp[1], 0, 10);
+        MODEM_PRINTF_INFO("<stat> Indicates the EPS registration status:\n");
+        switch (stat)
+        {
+        case 0:
+            MODEM_PRINTF_INFO("0 - Not registered; MT is currently not searching for an operator to register to\n");
+            break;
+        case 2:
+            MODEM_PRINTF_INFO("2 - Not registered but MT is currently trying to attach or searching for an operator to register to\n");
+            break;
+        case 3:
+            MODEM_PRINTF_INFO("3 - Registration denied\n");
+            break;
+        case 4:
+            MODEM_PRINTF_INFO("4 - Unknown (e.g. out of E-UTRAN coverage)\n");
+            break;
+        case 5:
+            MODEM_PRINTF_INFO("5 - Registered, roaming\n");
+            /* tac, ci and AcT are optional, the table guarantees <stat> only */
+            if (argc >= 5)
             {
-                if (strcmp(argp[1], "1") == 0)
-                {
-                    int ndata = strtol(argp[2], NULL, 10);
-                    MODEM_PRINTF_INFO("Ready to receive %d bytes via UDP\n", ndata);
-                    printf("Ready to receive %d bytes via UDP\n", ndata);
-                    //waitForData = true;
-
-                    queueRx = ndata;// ndata;
-                }
+#ifdef MODEM_DEBUG_PRINTF_ENABLED
+                const char *tac = argp[2];
+                const char *ci = argp[3];
+#endif
+                uint32_t AcT = strtoul(argp[4], 0, 10);
+
+                MODEM_PRINTF_INFO("  tac: %s\n  ci: %s\n  AcT: %d\n", tac, ci, AcT);
             }
+            break;
         }
+        Modem_NetworkRegistrationStatusInd(stat);
+    }
+}
 
-        if (strcmp(argp[0], "CONNECT") == 0)
-        {
-            /* Switch do data mode */
-            if (queueTx)
-            {
-                MODEM_PRINTF_INFO("...Data send...\n");
-                sendRawData = true;
-                queueTx = 0;
+/* Notification: TCP Status */
+static void AtCmdIndKtcpInd(int32_t argc, char **argp)
+{
+    (void)argc;
+    MODEM_PRINTF_INFO("Notification: TCP Status:\n");
+    int session_id = strtol(argp[1], 0, 10);
+    int status = strtol(argp[2], 0, 10);
+    MODEM_PRINTF_INFO("    session_id: %d\n", session_id);
+    MODEM_PRINTF_INFO("    status: %d\n", status);
+    if (status == 1)
+    {
+        MODEM_PRINTF_INFO("      (1 session is set up and ready for operation)\n");
+    }
+    Modem_TcpSessionActiveInd(session_id - 1, status);
+}
+
+/* Notification: UDP Status */
+static void AtCmdIndKudpInd(int32_t argc, char **argp)
+{
+    (void)argc;
+    MODEM_PRINTF_INFO("Notification: UPD Status:\n");
+    int session_id = strtol(argp[1], 0, 10);
+    int status = strtol(argp[2], 0, 10);
+    MODEM_PRINTF_INFO("    session_id: %d\n", session_id);
+    MODEM_PRINTF_INFO("    status: %d\n", status);
+    if (status == 1)
+    {
+        MODEM_PRINTF_INFO("      (1 session is set up and ready for operation)\n");
+    }
+    Modem_UdpSessionActiveInd(session_id - 1, status);
+}
+
+/* Notification: TCP Status */
+static void AtCmdIndKtcpNotif(int32_t argc, char **argp)
+{
+    (void)argc;
+    MODEM_PRINTF_INFO("Notification: TCP Status:\n");
+    int session_id = strtol(argp[1], 0, 10);
+    uint8_t tcp_notif = strtou8(argp[2], 0, 10);
+    MODEM_PRINTF_INFO("    session_id: %d\n", session_id);
+    MODEM_PRINTF_INFO("    tcp_notif: %d\n", tcp_notif);
+    if (tcp_notif == 0)
+    {
+        MODEM_PRINTF_ERROR("      (0 - Network error)\n");
+    }
+    if (tcp_notif == 3)
+    {
+        MODEM_PRINTF_ERROR("      (3 - DNS error)\n");
+    }
+    if (tcp_notif == 4)
+    {
+        MODEM_PRINTF_WARN("       (4 - TCP disconnection by the remote server or remote client)\n");
+    }
+    if (tcp_notif == 5)
+    {
+        MODEM_PRINTF_ERROR("       (5 - TCP connection error)\n");
+    }
+    if (tcp_notif == 8)
+    {
+        MODEM_PRINTF_WARN("       (8 - Data sending is OK but +KTCPSND was waiting for more or less characters)\n");
+    }
+    Modem_TcpSessionStatusChangedInd(session_id - 1, tcp_notif);
+}
+
+/* Notification: UDP Status */
+static void AtCmdIndKudpNotif(int32_t argc, char **argp)
+{
+    (void)argc;
+    MODEM_PRINTF_INFO("Notification: UDP Status:\n");
+    int session_id = strtol(argp[1], 0, 10);
+    uint8_t udp_notif = strtou8(argp[2], 0, 10);
+    MODEM_PRINTF_INFO("    session_id: %d\n", session_id);
+    MODEM_PRINTF_INFO("    tcp_notif: %d\n", udp_notif);
+    if (udp_notif == 0)
+    {
+        MODEM_PRINTF_ERROR("      (0 - Network error)\n");
+    }
+    else if (udp_notif == 3)
+    {
+        MODEM_PRINTF_ERROR("      (3 - DNS error)\n");
+    }
+    else if (udp_notif == 4)
+    {
+        MODEM_PRINTF_WARN("       (4 - TCP disconnection by the remote server or remote client)\n");
+    }
+    else if (udp_notif == 5)
+    {
+        MODEM_PRINTF_ERROR("       (5 - TCP connection error)\n");
+    }
+    else if (udp_notif == 8)
+    {
+        MODEM_PRINTF_WARN("       (8 - Data sending is OK but +KTCPSND was waiting for more or less characters)\n");
+    }
+    else
+    {
+        MODEM_PRINTF_ERROR("      (%d - unknown)\n", udp_notif);
+    }
+    Modem_UdpSessionStatusChangedInd(session_id - 1, udp_notif);
+}
 
-                Modem_SendQueuedMsg();
-            }
-            else if (queueRx)
-            {
-                MODEM_PRINTF_INFO("...Receive...\n");
-                Modem_AtRawRxStart();
-            }
-            else
-            {
-                MODEM_PRINTF_INFO("No data to send or receive, drop!\n");
-                Modem_Hal_TransmitRaw((uint8_t *)xeofPattern, MODEM_EOF_PATTERN_LEN);
-                atWaitForRsp = true;
-                Timer_StartOnce(SCHED_MODEM_AT_TIMEOUT, MODEM_AT_TIMEOUT_TIME_MS);
-            }
-        }
+/* Notification: Connection Status Notification */
+static void AtCmdIndKcnxInd(int32_t argc, char **argp)
+{
+    (void)argc;
+    MODEM_PRINTF_INFO("Notification: Connection Status Notification:\n");
+    int cnx_cnf = strtol(argp[1], 0, 10);
+    int status = strtol(argp[2], 0, 10);
+    MODEM_PRINTF_INFO("    cnx_cnf: %d\n", cnx_cnf);
+    MODEM_PRINTF_INFO("    status: %d\n", status);
+    switch (status)
+    {
+    case 0:
+        MODEM_PRINTF_INFO("0 - Disconnected due to network\n");
+        break;
+    case 1:
+        MODEM_PRINTF_INFO("1 - Connected\n");
+        break;
+    case 2:
+        MODEM_PRINTF_INFO("2 - Failed to connect, <tim1> timer is started if <attempt> is less than <nbtrail>\n");
+        break;
+    case 3:
+        MODEM_PRINTF_INFO("3 - Closed\n");
+        break;
+    case 4:
+        MODEM_PRINTF_INFO("4 - Connecting\n");
+        break;
+    case 5:
+        MODEM_PRINTF_INFO("5 - Idle time down counting started for disconnection\n");
+        break;
+    case 6:
+        MODEM_PRINTF_INFO("6 - Idle time down counting canceled\n");
+        break;
+    }
+    Modem_ConnectionStatusChangedInd(cnx_cnf, status);
+}
 
-        /*
-         * Error: NO CARRIER
-         */
+/*
+ * Responses and URCs, keyed by the first argument of the line.
+ * Keep sorted in strcmp() order, the lookup is a binary search.
+ */
+static const struct at_ind_entry_s at_ind_table[] =
+{
+    {"+CCID",       AtCmdIndCcid,       1},
+    {"+CEREG",      AtCmdIndCereg,      2},
+    {"+CESQ",       AtCmdIndCesq,       7},
+    {"+CFUN",       AtCmdIndCfun,       2},
+    {"+CGDCONT",    AtCmdIndCgdcont,    5},
+    {"+CME",        AtCmdIndCme,        1},
+    {"+CME ERROR",  AtCmdIndCmeError,   1},
+    {"+KBND",       AtCmdIndKbnd,       3},
+    {"+KBNDCFG",    AtCmdIndKbndcfg,    3},
+    {"+KCNX_IND",   AtCmdIndKcnxInd,    3},
+    {"+KGSN",       AtCmdIndKgsn,       1},
+    {"+KSELACQ",    AtCmdIndKselacq,    1},
+    {"+KTCPSTAT",   AtCmdIndKtcpstat,   1},
+    {"+KTCP_DATA",  AtCmdIndKtcpData,   3},
+    {"+KTCP_IND",   AtCmdIndKtcpInd,    3},
+    {"+KTCP_NOTIF", AtCmdIndKtcpNotif,  3},
+    {"+KUDP_DATA",  AtCmdIndKudpData,   3},
+    {"+KUDP_IND",   AtCmdIndKudpInd,    3},
+    {"+KUDP_NOTIF", AtCmdIndKudpNotif,  3},
+    {"AT",          AtCmdIndAt,         1},
+    {"AT+CGMM",     AtCmdIndAtCgmm,     1},
+    {"AT+CGMR",     AtCmdIndAtCgmr,     1},
+    {"AT+CGSN",     AtCmdIndAtCgsn,     1},
+    {"AT+KTCPRCV",  AtCmdIndAtKtcprcv,  3},
+    {"AT+KTCPSND",  AtCmdIndAtKtcpsnd,  3},
+    {"AT+KUDPRCV",  AtCmdIndAtKudprcv,  3},
+    {"AT+KUDPSND",  AtCmdIndAtKudpsnd,  5},
+    {"ATI",         AtCmdIndAti,        1},
+    {"CONNECT",     AtCmdIndConnect,    1},
+    {"ERROR",       AtCmdIndError,      1},
+    {"OK",          AtCmdIndOk,         1},
+};
 
+static const struct at_ind_entry_s *AtCmdIndLookup(const char *key)
+{
+    size_t lo = 0;
+    size_t hi = sizeof(at_ind_table) / sizeof(at_ind_table[0]);
 
-        /*
-         * +CSQ Command: Signal Quality
-         */
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2U;
+        int cmp = strcmp(key, at_ind_table[mid].prefix);
 
-        /*
-         * +CGDCONT Command: Define PDP Context
-         */
-        if (strcmp(argp[0], "+CGDCONT") == 0)
+        if (cmp == 0)
         {
-            MODEM_PRINTF_INFO("Command: Define PDP Context %d\n", argc);
-            if (argc >= 5)
-            {
-                int idx = strtol(argp[1], NULL, 10);
-                MODEM_PRINTF_INFO("cont: %d\n", idx);
-                if ((idx >= 1) && (idx < 2))
-                {
-                    strncpy(modemInfo.pdp_context[idx - 1].cid, argp[1], sizeof(modemInfo.pdp_context[idx - 1].cid) - 1U);
-                    strncpy(modemInfo.pdp_context[idx - 1].PDP_type, argp[2], sizeof(modemInfo.pdp_context[idx - 1].PDP_type) - 1U);
-                    strncpy(modemInfo.pdp_context[idx - 1].APN, argp[3], sizeof(modemInfo.pdp_context[idx - 1].APN) - 1U);
-                    strncpy(modemInfo.pdp_context[idx - 1].PDP_addr, argp[4], sizeof(modemInfo.pdp_context[idx - 1].PDP_addr) - 1U);
-                }
-            }
+            return &at_ind_table[mid];
         }
-
-        /*
-         * +KBNDCFG Command: Set Configured LTE
-         * Band(s)
-         *
-         * 0: CAT-M1
-         * 1: NB-IoT (HL7800/HL7802/HL7810/HL7845/HL7812 only
-         * 2: GSM (for HL7802/HL7812 only)
-         */
-        if (strcmp(argp[0], "+KBNDCFG") == 0)
+        if (cmp < 0)
         {
-            MODEM_PRINTF_INFO("Command: Set Configured LTE Band(s)\n");
-            if (argc >= 3)
-            {
-                int rat = strtol(argp[1], NULL, 10);
-#ifdef MODEM_DEBUG_PRINTF_ENABLED
-                const char *ratstr[] = {"CAT-M1", "NB-IoT", "GSM"};
-                MODEM_PRINTF_INFO("%s: %s\n", ratstr[rat], argp[2]);
-#endif
-                if ((rat >= 0) && (rat <= 2))
-                {
-                    strncpy(modemInfo.bnd_bitmap[rat], argp[2], sizeof(modemInfo.bnd_bitmap[rat]) - 1UL);
-                }
-            }
+            hi = mid;
         }
-
-        /*
-             * +CESQ Command: Extended Signal Quality
-             */
-        if (strcmp(argp[0], "+CESQ") == 0)
+        else
         {
-            MODEM_PRINTF_INFO("Command: Extended Signal Quality\n");
-            if (argc > 6)
-            {
-                uint8_t rxlev = strtou8(argp[1], NULL, 10);
-                MODEM_PRINTF_INFO("rxlev: %u\n", rxlev);
-
-                uint8_t ber = strtou8(argp[2], NULL, 10);
-                MODEM_PRINTF_INFO("ber: %u\n", ber);
-
-                uint8_t rscp = strtou8(argp[3], NULL, 10);
-                MODEM_PRINTF_INFO("rscp: %u\n", rscp);
-
-                uint8_t ecno = strtou8(argp[4], NULL, 10);
-                MODEM_PRINTF_INFO("ecno: %u\n", ecno);
-
-                uint8_t rsrq = strtou8(argp[5], NULL, 10);
-                MODEM_PRINTF_INFO("rsrq: %u\n", rsrq);
-
-                uint8_t rsrp = strtou8(argp[6], NULL, 10);
-                MODEM_PRINTF_INFO("rsrp: %u\n", rsrp);
-
-                modemInfo.cesq.datetime = Rtc_GetDateTime();
-                modemInfo.cesq.rxlev = rxlev;
-                modemInfo.cesq.ber = ber;
-                modemInfo.cesq.rscp = rscp;
-                modemInfo.cesq.ecno = ecno;
-                modemInfo.cesq.rsrq = rsrq;
-                modemInfo.cesq.rsrp = rsrp;
-                if (modemInfo.cesq.datetime == modemInfo.cesq.datetime_lastsync)
-                {
-                    modemInfo.cesq.datetime++;
-                }
-            }
+            lo = mid + 1U;
         }
+    }
+    return NULL;
+}
 
-        /*
-         * +KBND Command: Get Active LTE Band(s)
-         *
-         * 0: CAT-M1 (this is the only RAT available on the HL7800-M)
-         * 1: NB-IoT
-         * 2: GSM (for HL7802/HL7812 only)
-         */
-        if (strcmp(argp[0], "+KBND") == 0)
-        {
-            MODEM_PRINTF_INFO("Command: Get Active LTE Band(s)\n");
-            if (argc >= 3)
-            {
-                uint8_t rat = strtou8(argp[1], NULL, 10);
-#ifdef MODEM_DEBUG_PRINTF_ENABLED
-                const char *ratstr[] = {"CAT-M1", "NB-IoT", "GSM"};
-                MODEM_PRINTF_INFO("%s: %s\n", ratstr[rat], argp[2]);
-#endif
-                modemInfo.rat = rat;
-                if (strlen(argp[2]) >= sizeof(modemInfo.bnd))
-                {
-                    MODEM_PRINTF_ERROR("KBND rsp overflow!\n");
-                }
-                else
-                {
-                    strncpy(modemInfo.bnd, argp[2], sizeof(modemInfo.bnd) - 1U);
-                }
-            }
-        }
+void AtCmdIndClean(int32_t argc, char **argp)
+{
+    const struct at_ind_entry_s *entry;
+
+    MODEM_PRINTF_INFO("\nAtCmdInd:\n");
+    for (int n = 0; n < argc; n++)
+    {
+        MODEM_PRINTF_INFO("  argc[%d]:<%s>\n", n, argp[n]);
+    }
 
-        /*
-         * +KSELACQ Command: Configure Preferred
-         * Radio Access Technology List (PRL)
-         */
-        if (strcmp(argp[0], "+KSELACQ") == 0)
+    if (argc > 0)
+    {
+        entry = AtCmdIndLookup(argp[0]);
+        if ((entry != NULL) && (argc >= (int32_t)entry->min_argc))
         {
-            MODEM_PRINTF_INFO("Command: Configure Preferred Radio Access Technology List (PRL)\n");
-            modemInfo.prl_valid = true;
-            if (argc >= 2)
-            {
-                uint8_t rat1 = strtou8(argp[1], NULL, 10);
-                MODEM_PRINTF_INFO("rat1: %d\n", rat1);
-                modemInfo.prl[0] = rat1;
-            }
-            else
-            {
-                modemInfo.prl[0] = 0;
-            }
-            if (argc >= 3)
-            {
-                uint8_t rat2 = strtou8(argp[2], NULL, 10);
-                MODEM_PRINTF_INFO("rat2: %d\n", rat2);
-                modemInfo.prl[1] = rat2;
-            }
-            else
-            {
-                modemInfo.prl[1] = 0;
-            }
-            if (argc >= 4)
-            {
-                uint8_t rat3 = strtou8(argp[3], NULL, 10);
-                MODEM_PRINTF_INFO("rat3: %d\n", rat3);
-                modemInfo.prl[2] = rat3;
-            }
-            else
-            {
-                modemInfo.prl[2] = 0;
-            }
+            entry->handler(argc, argp);
         }
-
-        /*
-         * +KTCPSTAT Command: Get TCP Socket Status
-         */
-        if (strcmp(argp[0], "+KTCPSTAT") == 0)
+        else if (entry == NULL)
         {
-            MODEM_PRINTF_INFO("Command: Get TCP Socket Status\n");
-            if (argc == 6)
-            {
-                uint32_t status = strtoul(argp[2], 0, 10);
-                MODEM_PRINTF_INFO("    session_id: %s\n", argp[1]);
-                MODEM_PRINTF_INFO("    status: %d\n", status);
-                switch (status)
-                {
-                case 0:
-                    MODEM_PRINTF_INFO("      (0 - Socket not defined, use +KTCPCFG to create a TCP socket)\n");
-                    break;
-                case 1:
-                    MODEM_PRINTF_INFO("      (1 - Socket is only defined but not used)\n");
-                    break;
-                case 2:
-                    MODEM_PRINTF_INFO("      (2 - Socket is opening and connecting to the server, cannot be used)\n");
-                    break;
-                case 3:
-                    MODEM_PRINTF_INFO("      (3 - Connection is up, socket can be used to send/receive data)\n");
-                    break;
-                case 4:
-                    MODEM_PRINTF_INFO("      (4 - Connection is closing, it cannot be used, wait for status 5)\n");
-                    break;
-                case 5:
-                    MODEM_PRINTF_INFO("      (5 - Socket is closed)\n");
-                    break;
-                }
-                MODEM_PRINTF_INFO("    tcp_notif: %s\n", argp[3]);
-                if (strcmp(argp[3], "-1") == 0)
-                {
-                    MODEM_PRINTF_INFO("      (-1 if socket/connection is OK)\n");
-                }
-                else
-                {
-                    MODEM_PRINTF_INFO("      (<tcp_notif> if an error has happened (see AT+KTCPCNX))\n");
-                }
-                MODEM_PRINTF_INFO("    rem_data: %s (Remaining bytes in the socket buffer, waiting to be sent)\n", argp[4]);
-                MODEM_PRINTF_INFO("    rcv_data: %s (Received bytes, can be read with +KTCPRCV command)\n", argp[5]);
-            }
+            AtBatchBareRsp(argp[0]);
         }
 
-
-#if 0
-        /*
-         * +CME
-         */
-        if (strcmp(argp[0], "+KTCP_DATA") == 0)
+        /* the ready flag only holds for the line following the AT echo */
+        if ((entry == NULL) || (entry->handler != AtCmdIndAt))
         {
-            if (argc == 2)
-            {
-                if (strcmp(argp[1], "1") == 0)
-                {
-                    if (strcmp(argp[2], "1388") == 0)
-                    {
-                        MODEM_PRINTF_ERROR("data to read\n");
-                    }
-                    int bytes_ready = strtol(argp[2], NULL, 10);
-                    Modem_TcpDataReadyInd(bytes_ready);
-                }
-            }
+            at_ready_rcvd = false;
         }
-#endif
 
-        /*
-         * +CEREG Command: EPS Network
-         * Registration Status
-         */
-        if (strcmp(argp[0], "+CEREG") == 0)
+        if (infoReq != NULL)
         {
-            if (atWaitForRsp)
+            if (strlen(argp[0]) < 32)
             {
-#if 1
-                uint32_t n = strtoul(argp[1], 0, 10);
-                //uint32_t stat = strtoul(argp[2], 0, 10);
-                MODEM_PRINTF_INFO("    n: %s, stat: %s\n", argp[1], argp[2]);
-                switch (n)
-                {
-                case 0:
-                    MODEM_PRINTF_INFO("Disable network registration unsolicited result code\n");
-                    break;
-                case 2:
-                    MODEM_PRINTF_INFO("Enable network registration and location information unsolicited result code\n");
-                    break;
-                case 5:
-                    MODEM_PRINTF_INFO("For a UE that wants to apply PSM, enable network registration, location information and EMM cause value information unsolicited result code\n");
-                    break;
-                }
-                Modem_NetworkRegistrationStatusN(argp[1]);
-#endif
+                strncpy(modemValueTemp, argp[0], sizeof(modemValueTemp) - 1UL);
             }
             else
             {
-                int8_t stat = strtos8(argp[1], 0, 10);
-                MODEM_PRINTF_INFO("<stat> Indicates the EPS registration status:\n");
-                switch (stat)
-                {
-                case 0:
-                    MODEM_PRINTF_INFO("0 - Not registered; MT is currently not searching for an operator to register to\n");
-                    break;
-                case 2:
-                    MODEM_PRINTF_INFO("2 - Not registered but MT is currently trying to attach or searching for an operator to register to\n");
-                    break;
-                case 3:
-                    MODEM_PRINTF_INFO("3 - Registration denied\n");
-                    break;
-                case 4:
-                    MODEM_PRINTF_INFO("4 - Unknown (e.g. out of E-UTRAN coverage)\n");
-                    break;
-                case 5:
-                    MODEM_PRINTF_INFO("5 - Registered, roaming\n");
-#ifdef MODEM_DEBUG_PRINTF_ENABLED
-                    const char *tac = argp[2];
-                    const char *ci = argp[3];
-#endif
-                    uint32_t AcT = strtoul(argp[4], 0, 10);
-
-                    MODEM_PRINTF_INFO("  tac: %s\n  ci: %s\n  AcT: %d\n", tac, ci, AcT);
-                    break;
-                }
-                Modem_NetworkRegistrationStatusInd(stat);
+                MODEM_PRINTF_ERROR("arg 0 too long!\n");
             }
         }
+    }
+}
 
-        /* Notification: TCP Status */
-        if (strcmp(argp[0], "+KTCP_IND") == 0)
-        {
-            MODEM_PRINTF_INFO("Notification: TCP Status:\n");
-            if (argc >= 3)
-            {
-                int session_id = strtol(argp[1], 0, 10);
-                int status = strtol(argp[2], 0, 10);
-                MODEM_PRINTF_INFO("    session_id: %d\n", session_id);
-                MODEM_PRINTF_INFO("    status: %d\n", status);
-                if (status == 1)
-                {
-                    MODEM_PRINTF_INFO("      (1 session is set up and ready for operation)\n");
-                }
-                Modem_TcpSessionActiveInd(session_id - 1, status);
-            }
-        }
+static void AtCmdIndication(void)
+{
+    if (at_argc > 0)
+    {
+        MODEM_PRINTF_INFO("rx(%d): %s\n", at_rx_in, at_argp[0]);
 
-        /*
-         *
-         */
-        if (strcmp(argp[0], "+KUDP_IND") == 0)
+        if (strcmp(at_argp[0], "OK") == 0)
         {
-            MODEM_PRINTF_INFO("Notification: UPD Status:\n");
-            if (argc >= 3)
-            {
-                int session_id = strtol(argp[1], 0, 10);
-                int status = strtol(argp[2], 0, 10);
-                MODEM_PRINTF_INFO("    session_id: %d\n", session_id);
-                MODEM_PRINTF_INFO("    status: %d\n", status);
-                if (status == 1)
-                {
-                    MODEM_PRINTF_INFO("      (1 session is set up and ready for operation)\n");
-                }
-                Modem_UdpSessionActiveInd(session_id - 1, status);
-            }
+            MODEM_PRINTF_SUCCESS("#operation successful\n");
         }
-
-        /* Notification: TCP Status */
-        if (strcmp(argp[0], "+KTCP_NOTIF") == 0)
+        if (strcmp(at_argp[0], "ERROR") == 0)
         {
-            MODEM_PRINTF_INFO("Notification: TCP Status:\n");
-            if (argc >= 3)
-            {
-                int session_id = strtol(argp[1], 0, 10);
-                uint8_t tcp_notif = strtou8(argp[2], 0, 10);
-                MODEM_PRINTF_INFO("    session_id: %d\n", session_id);
-                MODEM_PRINTF_INFO("    tcp_notif: %d\n", tcp_notif);
-                if (tcp_notif == 0)
-                {
-                    MODEM_PRINTF_ERROR("      (0 - Network error)\n");
-                }
-                if (tcp_notif == 3)
-                {
-                    MODEM_PRINTF_ERROR("      (3 - DNS error)\n");
-                }
-                if (tcp_notif == 4)
-                {
-                    MODEM_PRINTF_WARN("       (4 - TCP disconnection by the remote server or remote client)\n");
-                }
-                if (tcp_notif == 5)
-                {
-                    MODEM_PRINTF_ERROR("       (5 - TCP connection error)\n");
-                }
-                if (tcp_notif == 8)
-                {
-                    MODEM_PRINTF_WARN("       (8 - Data sending is OK but +KTCPSND was waiting for more or less characters)\n");
-                }
-                Modem_TcpSessionStatusChangedInd(session_id - 1, tcp_notif);
-            }
+            MODEM_PRINTF_ERROR("#operation failed\n");
         }
+        AtCmdIndClean(at_argc, at_argp);
+    }
+}
 
-        /* Notification: UDP Status */
-        if (strcmp(argp[0], "+KUDP_NOTIF") == 0)
-        {
-            MODEM_PRINTF_INFO("Notification: UDP Status:\n");
-            if (argc >= 3)
-            {
-                int session_id = strtol(argp[1], 0, 10);
-                uint8_t udp_notif = strtou8(argp[2], 0, 10);
-                MODEM_PRINTF_INFO("    session_id: %d\n", session_id);
-                MODEM_PRINTF_INFO("    tcp_notif: %d\n", udp_notif);
-                if (udp_notif == 0)
-                {
-                    MODEM_PRINTF_ERROR("      (0 - Network error)\n");
-                }
-                else if (udp_notif == 3)
-                {
-                    MODEM_PRINTF_ERROR("      (3 - DNS error)\n");
-                }
-                else if (udp_notif == 4)
-                {
-                    MODEM_PRINTF_WARN("       (4 - TCP disconnection by the remote server or remote client)\n");
-                }
-                else if (udp_notif == 5)
-                {
-                    MODEM_PRINTF_ERROR("       (5 - TCP connection error)\n");
-                }
-                else if (udp_notif == 8)
-                {
-                    MODEM_PRINTF_WARN("       (8 - Data sending is OK but +KTCPSND was waiting for more or less characters)\n");
-                }
-                else
-                {
-                    MODEM_PRINTF_ERROR("      (%d - unknown)\n", udp_notif);
-                }
-                Modem_UdpSessionStatusChangedInd(session_id - 1, udp_notif);
-            }
-        }
+/* header, payload and EOF pattern go out from their own storage, no frame copy */
+static void Modem_SendQueuedMsg(void)
+{
+    struct modem_hal_txv_s frame[3];
+    uint8_t n = 0U;
 
-        /* Notification: Connection Status Notification */
-        if (strcmp(argp[0], "+KCNX_IND") == 0)
-        {
-            MODEM_PRINTF_INFO("Notification: Connection Status Notification:\n");
-            if (argc >= 3)
-            {
-                int cnx_cnf = strtol(argp[1], 0, 10);
-                int status = strtol(argp[2], 0, 10);
-                MODEM_PRINTF_INFO("    cnx_cnf: %d\n", cnx_cnf);
-                MODEM_PRINTF_INFO("    status: %d\n", status);
-                switch (status)
-                {
-                case 0:
-                    MODEM_PRINTF_INFO("0 - Disconnected due to network\n");
-                    break;
-                case 1:
-                    MODEM_PRINTF_INFO("1 - Connected\n");
-                    break;
-                case 2:
-                    MODEM_PRINTF_INFO("2 - Failed to connect, <tim1> timer is started if <attempt> is less than <nbtrail>\n");
-                    break;
-                case 3:
-                    MODEM_PRINTF_INFO("3 - Closed\n");
-                    break;
-                case 4:
-                    MODEM_PRINTF_INFO("4 - Connecting\n");
-                    break;
-                case 5:
-                    MODEM_PRINTF_INFO("5 - Idle time down counting started for disconnection\n");
-                    break;
-                case 6:
-                    MODEM_PRINTF_INFO("6 - Idle time down counting canceled\n");
-                    break;
-                }
-                Modem_ConnectionStatusChangedInd(cnx_cnf, status);
-            }
-        }
+    if (queuedTxHdrLen > 0U)
+    {
+        frame[n].buf = queuedTxHdr;
+        frame[n++].len = queuedTxHdrLen;
+    }
+    frame[n].buf = queuedTxPkg;
+    frame[n++].len = queuedTxPkgLen;
+    frame[n].buf = (const uint8_t *)xeofPattern;
+    frame[n++].len = MODEM_EOF_PATTERN_LEN;
+
+    MODEM_PRINTF_INFO("TRANSMIT OF (%d)\n", queuedTxHdrLen + queuedTxPkgLen + MODEM_EOF_PATTERN_LEN);
+    for (size_t i = 0; i < queuedTxPkgLen; i++)
+    {
+        MODEM_PRINTF_INFO("%02x ", queuedTxPkg[i]);
+    }
+    MODEM_PRINTF_INFO("\n");
+
+    queueTx = 0;
+    atWaitForRsp = true;
+    AtTxArm(MODEM_AT_TIMEOUT_TIME_MS, false);
+    if (!Modem_Hal_TxStartRaw(frame, n))
+    {
+        AtTxRejected();
     }
 }
 
-static void AtCmdIndication(char *cmd, int len)
+/* the length was checked by Modem_At_SendCmdCb() */
+static void AtCmdTransmit(const char *cmd, uint32_t timeout_ms, Modem_AtCmdDoneCb cb)
 {
-    int32_t argc = 0;
-    char *argp[32] = {0};
-    int ptr = 0;
+    size_t cmdLen = strlen(cmd);
+    size_t atLen = 2U + cmdLen + 1U;
 
-    argp[argc] = &cmd[0];
-    argc++;
+    memcpy(&at_tx_line[2], cmd, cmdLen);
+    at_tx_line[atLen - 1U] = '\r';
+    at_tx_line[atLen] = '\0';
 
-    while (len > 0)
+    if (timeout_ms == MODEM_AT_TIMEOUT_ADAPTIVE)
     {
-        if (argc > 1)
-        {
-            if (argp[argc - 2][0] == 0)
-            {
-                argp[argc - 2] = argp[argc - 1];
-                argc--;
-            }
-        }
-#if 0
-        if (cmd[ptr] == ' ')
-        {
-            argp[argc] = &cmd[ptr + 1];
-            argc += 1;
-            cmd[ptr] = 0;
-        }
-#endif
-        if (cmd[ptr] == ':')
-        {
-            argp[argc] = &cmd[ptr + 1];
-            if (cmd[ptr + 1] == ' ')
-            {
-                cmd[ptr] = 0;
-                ptr++;
-                argp[argc] = &cmd[ptr + 1];
-            }
-            argc += 1;
-            cmd[ptr] = 0;
-        }
-        if (cmd[ptr] == '=')
-        {
-            argp[argc] = &cmd[ptr + 1];
-            argc += 1;
-            cmd[ptr] = 0;
-        }
-        if (cmd[ptr] == ',')
-        {
-            argp[argc] = &cmd[ptr + 1];
-            argc += 1;
-            cmd[ptr] = 0;
-        }
-        if (cmd[ptr] == '\r')
-        {
-            cmd[ptr] = 0;
-        }
-        if (cmd[ptr] == '\n')
-        {
-            cmd[ptr] = 0;
-        }
-        ptr++;
-        len--;
+        timeout_ms = Modem_Latency_Timeout(cmd);
     }
 
-    if (argc > 0)
+    atWaitForRsp = true;
+    at_cmd_cb = cb;
+    AtBatchPrepare(cmd);
+
+    MODEM_PRINTF_INFO("ToModem: AT%s<\n", cmd);
+
+    Modem_Stats_AtTxCmd(1);
+    AtTxArm(timeout_ms, true);
+    if (!Modem_Hal_TxStartCmd(at_tx_line, atLen))
     {
-        if (argp[argc - 1][0] == 0)
-        {
-            argc--;
-        }
+        AtTxRejected();
+    }
+}
+
+/* the response timeout of the next transmission, armed by Modem_Hal_TxDoneInd() */
+static void AtTxArm(uint32_t timeout_ms, bool latency)
+{
+    at_tx_timeout_ms = timeout_ms;
+    at_tx_latency = latency;
+    at_tx_pending = true;
+}
+
+/* a transmission still running on the uart, the command runs into its timeout */
+static void AtTxRejected(void)
+{
+    MODEM_PRINTF_ERROR("uart tx busy, dropped!\n");
+    at_tx_latency = false;
+    Modem_Hal_TxDoneInd();
+}
+
+/* collects the bare responses expected by a compound command line */
+static void AtBatchPrepare(const char *cmd)
+{
+    at_batch_bare_count = 0U;
+    at_batch_bare_next = 0U;
+
+    if (strchr(cmd, ';') == NULL)
+    {
+        return;
     }
 
-    for (int i = 1; i < argc; i++)
+    while (*cmd != 0)
     {
-        size_t lastChr = strlen(argp[i]);
-        if (lastChr > 0)
+        size_t len = strcspn(cmd, ";");
+
+        for (size_t i = 0; i < sizeof(at_bare_rsp) / sizeof(at_bare_rsp[0]); i++)
         {
-            lastChr -= 1;
-            if ((argp[i][0] == '\"') && (argp[i][lastChr] == '\"'))
+            if ((strlen(at_bare_rsp[i].cmd) == len) && (strncmp(cmd, at_bare_rsp[i].cmd, len) == 0) && (at_batch_bare_count < AT_BATCH_CMDS_MAX))
             {
-                argp[i][lastChr] = 0;
-                argp[i] += 1;
+                at_batch_bare[at_batch_bare_count++] = &at_bare_rsp[i];
             }
         }
-    }
-
-    if (argc > 0)
-    {
-        AtCmdIndClean(argc, argp);
+        cmd += len;
+        if (*cmd == ';')
+        {
+            cmd++;
+        }
     }
 }
 
-static void Modem_SendQueuedMsg(void)
+/* stores a line without known prefix as the next bare response of the batch */
+static void AtBatchBareRsp(const char *line)
 {
-    uint8_t atMsg[2560];
-    size_t atLen = 0;
-
-    atLen = gen_cmd_tx_frame_data(atMsg, 2560);
-    Modem_Hal_TransmitRaw(atMsg, atLen);
-    MODEM_PRINTF_INFO("TRANSMIT OF (%d): #%s#\n", atLen, atMsg);
-    for (size_t i = 0; i < atLen; i++)
+    if ((at_batch_bare_next >= at_batch_bare_count) || (line[0] == '+') || (strncmp(line, "AT", 2U) == 0))
     {
-        MODEM_PRINTF_INFO("%02x ", atMsg[i]);
+        return;
     }
-    MODEM_PRINTF_INFO("\n");
 
-    queueTx = 0;
-    atWaitForRsp = true;
-    Timer_StartOnce(SCHED_MODEM_AT_TIMEOUT, MODEM_AT_TIMEOUT_TIME_MS);
+    const struct at_bare_rsp_s *rsp = at_batch_bare[at_batch_bare_next++];
+
+    strncpy(rsp->dest, line, rsp->size - 1U);
+    rsp->dest[rsp->size - 1U] = 0;
+    MODEM_PRINTF_SUCCESS("stored info: %s\n", rsp->dest);
 }
 
-static size_t gen_cmd_tx_frame_data(uint8_t *at_cmd, size_t maxLen)
+/* no response pending and no raw data transfer running */
+static bool AtIdle(void)
 {
-    size_t atLen = 0;
+    return !atWaitForRsp && !waitForData && !sendRawData;
+}
 
-    for (int n = 0; n < queuedTxPkgLen; n++)
+/* sends the oldest queued command once the modem is idle */
+static void AtQueueDispatch(void)
+{
+    if (at_queue_count == 0U || !AtIdle())
     {
-        at_cmd[n] = queuedTxPkg[n];
-        atLen++;
+        return;
     }
-    atLen += (size_t)snprintf((char *)&at_cmd[atLen], maxLen, "%s", xeofPattern);
 
-    return atLen;
+    struct at_queue_entry_s *entry = &at_queue[at_queue_head];
+
+    at_queue_head = (uint8_t)((at_queue_head + 1U) % AT_QUEUE_COUNT);
+    at_queue_count--;
+    AtCmdTransmit(entry->cmd, entry->timeout_ms, entry->cb);
 }
 
 /*-----------------------------------------------------------------------------
@@ -1272,14 +1806,27 @@ Public Function implementations
 
 void Modem_At_Init(void)
 {
-    memset(at_rx_buffer, 0, sizeof(at_rx_buffer));
+    Modem_AtLineReset();
+    at_rx_discard = false;
+    atWaitForRsp = false;
+    at_cmd_cb = NULL;
+    at_tx_pending = false;
+    Modem_At_FlushQueue();
     memset(raw_rx_buffer, 0, sizeof(raw_rx_buffer));
 }
 
+/*!
+ * \brief Selects streaming of raw data, applies from the next raw rx on
+ */
+void Modem_At_SetRawStream(bool enable)
+{
+    raw_stream_enabled = enable;
+}
+
 void Modem_At_Timeout(void)
 {
     MODEM_PRINTF_ERROR("Modem_At_Timeout\n");
-    AtCmdDone();
+    AtCmdDone(modem_at_result_timeout);
 }
 
 void Modem_At_ReqSend(uint16_t ndata)
@@ -1293,80 +1840,87 @@ void Modem_At_SendCmdAtTimeout(void)
     Timer_StartOnce(SCHED_MODEM_AT_TIMEOUT, MODEM_AT_TIMEOUT_TIME_MS);
 }
 
-void Modem_At_SendCmd(const char *cmd)
+/*!
+ * \brief Sends an AT command, queues it while a response is pending
+ *
+ * \param cmd command without the leading "AT"
+ * \param timeout_ms response timeout, counted from the transmission,
+ *                   MODEM_AT_TIMEOUT_ADAPTIVE for the learned one
+ * \param cb called with the result once OK, ERROR or the timeout arrived,
+ *           may be NULL. Commands with a callback do not notify the state
+ *           machine via Modem_AtReqDone().
+ *
+ * \return false if the command was dropped
+ */
+bool Modem_At_SendCmdCb(const char *cmd, uint32_t timeout_ms, Modem_AtCmdDoneCb cb)
 {
-    if (strlen(cmd) + strlen("AT") + strlen("\r") >= MODEM_AT_MSG_LEN_MAX - 1U)
+    size_t cmdLen = strlen(cmd);
+
+    if (cmdLen + strlen("AT") + strlen("\r") >= MODEM_AT_MSG_LEN_MAX - 2U)
     {
-        MODEM_PRINTF_ERROR("command to long, dropped!\n");
+        MODEM_PRINTF_ERROR("command too long, dropped!\n");
+        return false;
     }
-    else if (atWaitForRsp == false)
-    {
-        char atMsg[MODEM_AT_MSG_LEN_MAX];
-        size_t atLen = 0;
-
-        atLen += (size_t)snprintf(&atMsg[atLen], MODEM_AT_MSG_LEN_MAX - 1UL, "AT");
-        atLen += (size_t)snprintf(&atMsg[atLen], MODEM_AT_MSG_LEN_MAX - 1UL, "%s", cmd);
-        atLen += (size_t)snprintf(&atMsg[atLen], MODEM_AT_MSG_LEN_MAX - 1UL, "\r");
 
-        if (atLen >= MODEM_AT_MSG_LEN_MAX - 2U)
-        {
-            MODEM_PRINTF_ERROR("At command overflow!\n");
-            return;
-        }
+    if (at_queue_count == 0U && AtIdle())
+    {
+        AtCmdTransmit(cmd, timeout_ms, cb);
+        return true;
+    }
 
-        atWaitForRsp = true;
+    if (at_queue_count >= AT_QUEUE_COUNT || cmdLen >= MODEM_AT_CMD_LEN_MAX)
+    {
+        MODEM_PRINTF_ERROR("at queue full, drop command: %s\n", cmd);
+        Modem_Stats_AtCmdDropped();
+        return false;
+    }
 
-#ifdef OS_DEBUG_PRINTF_ENABLED
-        char atMsg2[MODEM_AT_MSG_LEN_MAX];
+    struct at_queue_entry_s *entry = &at_queue[(at_queue_head + at_queue_count) % AT_QUEUE_COUNT];
 
-        strncpy(atMsg2, atMsg, MODEM_AT_MSG_LEN_MAX - 1UL);
+    memcpy(entry->cmd, cmd, cmdLen + 1U);
+    entry->timeout_ms = timeout_ms;
+    entry->cb = cb;
+    at_queue_count++;
 
-        for (size_t n = 0; n < strlen(atMsg2); n++)
-        {
-            if (atMsg2[n] == '\r')
-            {
-                atMsg2[n] = '<';
-            }
-        }
+    return true;
+}
 
-        MODEM_PRINTF_INFO("ToModem: %s\n", atMsg2);
-#endif
+void Modem_At_SendCmd(const char *cmd)
+{
+    (void)Modem_At_SendCmdCb(cmd, MODEM_AT_TIMEOUT_ADAPTIVE, NULL);
+}
 
-        Modem_Stats_AtTxCmd(1);
-        Modem_Hal_TransmitCmdWaitRsp(atMsg, atLen);
-        Timer_StartOnce(SCHED_MODEM_AT_TIMEOUT, MODEM_AT_TIMEOUT_TIME_MS);
-    }
-    else
+/*!
+ * \brief Drops the queued commands, their callbacks get modem_at_result_flushed
+ */
+void Modem_At_FlushQueue(void)
+{
+    while (at_queue_count > 0U)
     {
-#ifdef OS_DEBUG_PRINTF_ENABLED
-        char atMsg[MODEM_AT_MSG_LEN_MAX];
-        size_t atLen = 0;
-
-        atLen += (size_t)snprintf(&atMsg[atLen], MODEM_AT_MSG_LEN_MAX - 1UL, "AT");
-        atLen += (size_t)snprintf(&atMsg[atLen], MODEM_AT_MSG_LEN_MAX - 1UL, "%s", cmd);
-        atLen += (size_t)snprintf(&atMsg[atLen], MODEM_AT_MSG_LEN_MAX - 1UL, "\r");
-
+        Modem_AtCmdDoneCb cb = at_queue[at_queue_head].cb;
 
-        char atMsg2[MODEM_AT_MSG_LEN_MAX];
-
-        strncpy(atMsg2, atMsg, MODEM_AT_MSG_LEN_MAX - 1UL);
-
-        for (size_t n = 0; n < strlen(atMsg2); n++)
+        at_queue_head = (uint8_t)((at_queue_head + 1U) % AT_QUEUE_COUNT);
+        at_queue_count--;
+        if (cb != NULL)
         {
-            if (atMsg2[n] == '\r')
-            {
-                atMsg2[n] = '<';
-            }
+            cb(modem_at_result_flushed);
         }
-
-        MODEM_PRINTF_ERROR("not waiting for response, drop packet: %s\n", atMsg2);
-#endif
     }
 }
 
-void Modem_At_QueuePacket(uint8_t *pkg, uint16_t len)
+uint8_t Modem_At_QueuedCmds(void)
+{
+    return at_queue_count;
+}
+
+/*!
+ * \brief Queues the data of the next send command, hdr (may be NULL) goes out in front of pkg
+ */
+void Modem_At_QueuePacket(const uint8_t *hdr, uint8_t hdr_len, const uint8_t *pkg, uint16_t len)
 {
-    MODEM_PRINTF_WARN("QueueAtTxCmd(%u)\n", len);
+    MODEM_PRINTF_WARN("QueueAtTxCmd(%u)\n", hdr_len + len);
+    queuedTxHdr = hdr;
+    queuedTxHdrLen = (hdr != NULL) ? hdr_len : 0U;
     queuedTxPkg = pkg;
     queuedTxPkgLen = len;
 }
@@ -1378,7 +1932,7 @@ bool Modem_At_WaitsForData(void)
 
 bool Modem_At_Busy(void)
 {
-    return Modem_At_WaitsForData() || atWaitForRsp;
+    return Modem_At_WaitsForData() || atWaitForRsp || at_queue_count != 0U;
 }
 
 /* callbacks from lower layer */
@@ -1388,68 +1942,30 @@ void Modem_Hal_CharRxIndCb(char chr)
     Modem_AtPut(chr);
 }
 
-#ifdef CONSOLE_ENABLED
-void Modem_At_CheckEof(void)
+/*!
+ * \brief The last byte of a transmission left the uart, starts the response timeout
+ *
+ * A response which arrived before the event ran has ended the command already.
+ */
+void Modem_Hal_TxDoneInd(void)
 {
+    if (!at_tx_pending)
     {
-        /* exp: no data! */
-        const uint8_t msg[] = {0x0a, 0x2D, 0x2D, 0x45, 0x4F, 0x46, 0x2D, 0x2D, 0x50, 0x61, 0x74, 0x74, 0x65, 0x72, 0x6E, 0x2D, 0x2D};
-        Modem_AtRawRxStart();
-
-        for (uint8_t n = 0; n < sizeof(msg); n++)
-        {
-            Modem_AtPut((char)msg[n]);
-        }
-    }
-    {
-        /* exp: aa bb cc */
-        const uint8_t msg[] = {0x0a, 0xaa, 0xbb, 0xcc, 0x2D, 0x2D, 0x45, 0x4F, 0x46, 0x2D, 0x2D, 0x50, 0x61, 0x74, 0x74, 0x65, 0x72, 0x6E, 0x2D, 0x2D};
-        Modem_AtRawRxStart();
-
-        for (uint8_t n = 0; n < sizeof(msg); n++)
-        {
-            Modem_AtPut((char)msg[n]);
-        }
-    }
-    {
-        /* exp: aa bb cc 2d */
-        const uint8_t msg[] = {0x0a, 0xaa, 0xbb, 0xcc, 0x2D, 0x2D, 0x2D, 0x45, 0x4F, 0x46, 0x2D, 0x2D, 0x50, 0x61, 0x74, 0x74, 0x65, 0x72, 0x6E, 0x2D, 0x2D};
-        Modem_AtRawRxStart();
-
-        for (uint8_t n = 0; n < sizeof(msg); n++)
-        {
-            Modem_AtPut((char)msg[n]);
-        }
+        return;
     }
-    {
-        /* exp: aa bb cc 2d 2d */
-        const uint8_t msg[] = {0x0a, 0xaa, 0xbb, 0xcc, 0x2D, 0x2D, 0x2D, 0x2D, 0x45, 0x4F, 0x46, 0x2D, 0x2D, 0x50, 0x61, 0x74, 0x74, 0x65, 0x72, 0x6E, 0x2D, 0x2D};
-        Modem_AtRawRxStart();
+    at_tx_pending = false;
 
-        for (uint8_t n = 0; n < sizeof(msg); n++)
-        {
-            Modem_AtPut((char)msg[n]);
-        }
-    }
+    if (atWaitForRsp)
     {
-        /* exp: aa bb cc 2d 2d 2d */
-        const uint8_t msg[] = {0x0a, 0xaa, 0xbb, 0xcc, 0x2D, 0x2D, 0x2D, 0x2D, 0x2D, 0x45, 0x4F, 0x46, 0x2D, 0x2D, 0x50, 0x61, 0x74, 0x74, 0x65, 0x72, 0x6E, 0x2D, 0x2D};
-        Modem_AtRawRxStart();
-
-        for (uint8_t n = 0; n < sizeof(msg); n++)
+        if (at_tx_latency)
         {
-            Modem_AtPut((char)msg[n]);
+            Modem_Latency_Start(&at_tx_line[2]);
         }
+        Timer_StartOnce(SCHED_MODEM_AT_TIMEOUT, at_tx_timeout_ms);
     }
-    {
-        /* exp: aa bb cc 2d 2d 2d 45 */
-        const uint8_t msg[] = {0x0a, 0xaa, 0xbb, 0xcc, 0x2D, 0x2D, 0x2D, 0x45, 0x2D, 0x2D, 0x45, 0x4F, 0x46, 0x2D, 0x2D, 0x50, 0x61, 0x74, 0x74, 0x65, 0x72, 0x6E, 0x2D, 0x2D};
-        Modem_AtRawRxStart();
+}
 
-        for (uint8_t n = 0; n < sizeof(msg); n++)
-        {
-            Modem_AtPut((char)msg[n]);
-        }
-    }
+void Modem_Hal_RxBlockInd(const uint8_t *buf, size_t len)
+{
+    Modem_AtPutBlock((const char *)buf, len);
 }
-#endif
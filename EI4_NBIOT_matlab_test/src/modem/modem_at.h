@@ -23,12 +23,25 @@ Required header files
 /*-----------------------------------------------------------------------------
 Public defines
 -----------------------------------------------------------------------------*/
-/* None */
+#define MODEM_AT_TIMEOUT_TIME_MS    4000
+/* timeout learned from the observed latency, see modem_latency.h */
+#define MODEM_AT_TIMEOUT_ADAPTIVE   0U
+/* command without "AT" and "\r" including its terminator, fits the longest
+   one, +KUDPSND=1,"<remote address>",65535,65535,2 with a 127 character address */
+#define MODEM_AT_CMD_LEN_MAX        160U
 
 /*-----------------------------------------------------------------------------
 Public data types
 -----------------------------------------------------------------------------*/
-/* None */
+enum modem_at_result_e
+{
+    modem_at_result_ok,
+    modem_at_result_error,
+    modem_at_result_timeout,
+    modem_at_result_flushed, /* dropped from the queue before it was sent */
+};
+
+typedef void(*Modem_AtCmdDoneCb)(enum modem_at_result_e result);
 
 /*-----------------------------------------------------------------------------
  Public Data
@@ -39,9 +52,13 @@ extern struct modem_info_s modemInfo;
 Public functions
 -----------------------------------------------------------------------------*/
 void Modem_At_Init(void);
-void Modem_At_QueuePacket(uint8_t *pkg, uint16_t len);
+void Modem_At_QueuePacket(const uint8_t *hdr, uint8_t hdr_len, const uint8_t *pkg, uint16_t len);
 void Modem_At_SendCmd(const char *cmd);
+bool Modem_At_SendCmdCb(const char *cmd, uint32_t timeout_ms, Modem_AtCmdDoneCb cb);
+void Modem_At_FlushQueue(void);
+uint8_t Modem_At_QueuedCmds(void);
 void Modem_At_SendCmdAtTimeout(void);
+void Modem_At_SetRawStream(bool enable);
 
 /* event callbacks */
 void Modem_At_Timeout(void);
@@ -57,6 +74,7 @@ void Modem_ConnectionStatusChangedInd(int cnx_cnf, int status);
 void Modem_TcpSessionActiveInd(int session_id, int status);
 void Modem_UdpSessionActiveInd(int session_id, int status);
 void Modem_RawDataRecvdInd(char *msg, uint16_t len);
+void Modem_RawDataChunkInd(const char *msg, size_t len, bool last);
 void Modem_NetworkRegistrationStatusN(const char *n);
 void Modem_NetworkRegistrationStatusInd(int8_t status);
 void Modem_ErrorInd(int errorNum);
@@ -64,9 +82,5 @@ bool Modem_At_WaitsForData(void);
 bool Modem_At_Busy(void);
 void Modem_At_ReqSend(uint16_t ndata);
 
-#ifdef CONSOLE_ENABLED
-void Modem_At_CheckEof(void);
-#endif
-
 
 #endif /* SRC_APP_MODEM_MODEM_AT_H_ */
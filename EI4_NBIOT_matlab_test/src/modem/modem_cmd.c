@@ -39,7 +39,7 @@ Local includes
 #include <modem_at.h>
 #include <modem_stats.h>
 #include <modem_cmd.h>
-//#include <modem_debug.h>
+#include <modem_debug.h>
 
 /*-----------------------------------------------------------------------------
 Public data
@@ -49,7 +49,7 @@ Public data
 /*-----------------------------------------------------------------------------
 Private defines
 -----------------------------------------------------------------------------*/
-#define MODEM_CMD_AT_MAX_LEN    512
+/* None */
 
 /*-----------------------------------------------------------------------------
 Private data types
@@ -59,40 +59,69 @@ Private data types
 /*-----------------------------------------------------------------------------
 Private functions - declare static
 -----------------------------------------------------------------------------*/
-static int gen_cmd_send_frame_tcp(char *at_cmd, uint16_t byteCount);
-static int gen_cmd_send_frame_udp(char *at_cmd, uint16_t byteCount, char *addr, uint16_t port);
-static uint16_t gen_cmd_read_bytes(char *at_cmd, const char *tech, uint16_t byteCount);
+static void cmd_start(const char *prefix);
+static void cmd_put_str(const char *s);
+static void cmd_put_uint(uint32_t v);
+static bool cmd_send(Modem_AtCmdDoneCb cb);
 
 /*-----------------------------------------------------------------------------
 Private data - declare static
 -----------------------------------------------------------------------------*/
-/* None */
+/* the command line under construction, it is copied by Modem_At_SendCmdCb() */
+static char cmd_line[MODEM_AT_CMD_LEN_MAX];
+static size_t cmd_len = 0U; /* sizeof(cmd_line) marks an overflow */
 
 /*-----------------------------------------------------------------------------
 Private Function implementations
 -----------------------------------------------------------------------------*/
-static int gen_cmd_send_frame_tcp(char *at_cmd, uint16_t byteCount)
+static void cmd_start(const char *prefix)
 {
-    int atLen = 0;
-    atLen += snprintf(&at_cmd[atLen], MODEM_CMD_AT_MAX_LEN, "+KTCPSND=1,%u", byteCount);
+    cmd_len = 0U;
+    cmd_put_str(prefix);
+}
 
-    return atLen;
+static void cmd_put_str(const char *s)
+{
+    while ((*s != '\0') && (cmd_len < sizeof(cmd_line)))
+    {
+        cmd_line[cmd_len++] = *s++;
+    }
+    if (*s != '\0')
+    {
+        cmd_len = sizeof(cmd_line);
+    }
 }
 
-static int gen_cmd_send_frame_udp(char *at_cmd, uint16_t byteCount, char *addr, uint16_t port)
+static void cmd_put_uint(uint32_t v)
 {
-    int atLen = 0;
-    atLen += snprintf(&at_cmd[atLen], MODEM_CMD_AT_MAX_LEN, "+KUDPSND=1,\"%s\",%u,%u", addr, port, byteCount);
+    char digits[10];
+    uint8_t n = 0U;
+
+    do
+    {
+        digits[n++] = (char)('0' + (v % 10U));
+        v /= 10U;
+    } while (v > 0U);
 
-    return atLen;
+    while ((n > 0U) && (cmd_len < sizeof(cmd_line)))
+    {
+        cmd_line[cmd_len++] = digits[--n];
+    }
+    if (n > 0U)
+    {
+        cmd_len = sizeof(cmd_line);
+    }
 }
 
-static uint16_t gen_cmd_read_bytes(char *at_cmd, const char *tech, uint16_t byteCount)
+static bool cmd_send(Modem_AtCmdDoneCb cb)
 {
-    uint16_t atLen = 0;
-    atLen += snprintf(&at_cmd[atLen], MODEM_CMD_AT_MAX_LEN, "+K%sRCV=1,%d", tech, byteCount);
-
-    return atLen;
+    if (cmd_len >= sizeof(cmd_line))
+    {
+        MODEM_PRINTF_ERROR("command too long, dropped!\n");
+        return false;
+    }
+    cmd_line[cmd_len] = '\0';
+    return Modem_At_SendCmdCb(cmd_line, MODEM_AT_TIMEOUT_ADAPTIVE, cb);
 }
 
 /*-----------------------------------------------------------------------------
@@ -101,26 +130,49 @@ Public Function implementations
 
 void Modem_Cmd_RequestRegStat(void)
 {
-    char at_cmd[MODEM_CMD_AT_MAX_LEN];
-    int atLen = 0;
-    atLen += sprintf(&at_cmd[atLen], "+CEREG?");
-    Modem_At_SendCmd(at_cmd);
+    Modem_At_SendCmd("+CEREG?");
 }
 
 void Modem_Cmd_SetCereg(int n)
 {
-    char at_cmd[MODEM_CMD_AT_MAX_LEN];
-    int atLen = 0;
-    atLen += sprintf(&at_cmd[atLen], "+CEREG=%d", n);
-    Modem_At_SendCmd(at_cmd);
+    cmd_start("+CEREG=");
+    cmd_put_uint((uint32_t)n);
+    (void)cmd_send(NULL);
 }
 
 void Modem_Cmd_SetPhoneFunctionality(int fun, int rst)
 {
-    char at_cmd[MODEM_CMD_AT_MAX_LEN];
-    int atLen = 0;
-    atLen += sprintf(&at_cmd[atLen], "+CFUN=%d,%d", fun, rst);
-    Modem_At_SendCmd(at_cmd);
+    cmd_start("+CFUN=");
+    cmd_put_uint((uint32_t)fun);
+    cmd_put_str(",");
+    cmd_put_uint((uint32_t)rst);
+    (void)cmd_send(NULL);
+}
+
+/*
+ * modem at +KSLEEP=1,2;+CPSMS=1,,,"00100110","00000001";+CEDRXS=1,5,"0101"
+ * the modem hibernates by itself once the active timer expired,
+ * edrx_value NULL switches eDRX off
+ */
+void Modem_Cmd_SetPowerSaving(const char *tau, const char *active_time, int edrx_act, const char *edrx_value)
+{
+    cmd_start("+KSLEEP=1,2;+CPSMS=1,,,\"");
+    cmd_put_str(tau);
+    cmd_put_str("\",\"");
+    cmd_put_str(active_time);
+    if (edrx_value != NULL)
+    {
+        cmd_put_str("\";+CEDRXS=1,");
+        cmd_put_uint((uint32_t)edrx_act);
+        cmd_put_str(",\"");
+        cmd_put_str(edrx_value);
+        cmd_put_str("\"");
+    }
+    else
+    {
+        cmd_put_str("\";+CEDRXS=0");
+    }
+    (void)cmd_send(NULL);
 }
 
 /*
@@ -129,130 +181,139 @@ void Modem_Cmd_SetPhoneFunctionality(int fun, int rst)
  */
 void Modem_Cmd_ConfigurePreferredRadioAccessTechnologyList(uint8_t rat1, uint8_t rat2, uint8_t rat3)
 {
-    char at_cmd[MODEM_CMD_AT_MAX_LEN];
-    int atLen = 0;
-    atLen += sprintf(&at_cmd[atLen], "+KSELACQ=0,%u", rat1);
+    cmd_start("+KSELACQ=0,");
+    cmd_put_uint(rat1);
     if (rat2 > 0)
     {
-        atLen += sprintf(&at_cmd[atLen], ",%u", rat2);
+        cmd_put_str(",");
+        cmd_put_uint(rat2);
     }
     if (rat3 > 0)
     {
-        atLen += sprintf(&at_cmd[atLen], ",%u", rat3);
+        cmd_put_str(",");
+        cmd_put_uint(rat3);
     }
-    Modem_At_SendCmd(at_cmd);
-    //Modem_Hal_TransmitStr(at_cmd);
+    (void)cmd_send(NULL);
 }
 
 #if 0 /* for future use */
 void Modem_Cmd_KSREP(void)
 {
-    static char at_cmd[] = "+KSREP?";
-    Modem_At_SendCmd(at_cmd);
+    Modem_At_SendCmd("+KSREP?");
 }
 #endif
 
 void Modem_Cmd_ReadPreferredRadioAccessTechnologyList(void)
 {
-    static char at_cmd[] = "+KSELACQ?";
-    Modem_At_SendCmd(at_cmd);
+    Modem_At_SendCmd("+KSELACQ?");
 }
 
-void Modem_Cmd_ReadExtendedSignalQuality(void)
+void Modem_Cmd_ReadExtendedSignalQuality(Modem_AtCmdDoneCb cb)
 {
-    static char at_cmd[] = "+CESQ";
-    Modem_At_SendCmd(at_cmd);
+    (void)Modem_At_SendCmdCb("+CESQ", MODEM_AT_TIMEOUT_ADAPTIVE, cb);
 }
 
 void Modem_Cmd_RequestModelIdentification(void)
 {
-    //static char at_cmd[] = "+CGMM";
-    static char at_cmd[] = "I";
-    Modem_At_SendCmd(at_cmd);
+    //Modem_At_SendCmd("+CGMM");
+    Modem_At_SendCmd("I");
 }
 
 void Modem_Cmd_RequestRevisionIdentification(void)
 {
-    static char at_cmd[] = "+CGMR";
-    Modem_At_SendCmd(at_cmd);
+    Modem_At_SendCmd("+CGMR");
 }
 
 void Modem_Cmd_RequestFactorySerialNumber(void)
 {
-    static char at_cmd[] = "+KGSN=3";
-    Modem_At_SendCmd(at_cmd);
+    Modem_At_SendCmd("+KGSN=3");
 }
 
 void Modem_Cmd_RequestProductSerialNumberIdentification(void)
 {
-    static char at_cmd[] = "+CGSN";
-    Modem_At_SendCmd(at_cmd);
+    Modem_At_SendCmd("+CGSN");
+}
+
+/*!
+ * \brief Sends read-only queries as one compound command line
+ *
+ * \param cmds queries without the leading "AT", e.g. "+CGMR"
+ */
+void Modem_Cmd_SendBatch(const char *const *cmds, uint8_t count, Modem_AtCmdDoneCb cb)
+{
+    cmd_start("");
+    for (uint8_t n = 0; n < count; n++)
+    {
+        if (n > 0U)
+        {
+            cmd_put_str(";");
+        }
+        cmd_put_str(cmds[n]);
+    }
+    (void)cmd_send(cb);
 }
 
 void Modem_Cmd_CommandPowerOff(void)
 {
-    static char at_cmd[] = "+CPOF";
-    Modem_At_SendCmd(at_cmd);
+    Modem_At_SendCmd("+CPOF");
 }
 
 void Modem_Cmd_SetPDPContext(const char *conn_type, const char *apn)
 {
-    char at_cmd[MODEM_CMD_AT_MAX_LEN];
-    int atLen = 0;
-    atLen += snprintf(&at_cmd[atLen], MODEM_CMD_AT_MAX_LEN, "+CGDCONT=1,%s,\"%s\",,0,0,0,0,0,,0,,,,,", conn_type, apn);
-    Modem_At_SendCmd(at_cmd);
+    cmd_start("+CGDCONT=1,");
+    cmd_put_str(conn_type);
+    cmd_put_str(",\"");
+    cmd_put_str(apn);
+    cmd_put_str("\",,0,0,0,0,0,,0,,,,,");
+    (void)cmd_send(NULL);
 }
 
 void Modem_Cmd_ReadPDPContext(void)
 {
-    static char at_cmd[] = "+CGDCONT?";
-    Modem_At_SendCmd(at_cmd);
+    Modem_At_SendCmd("+CGDCONT?");
 }
 
 void Modem_Cmd_SetBandConfiguration(int rat, const char *bnd_bitmap)
 {
-    char at_cmd[MODEM_CMD_AT_MAX_LEN];
-    int atLen = 0;
-    atLen += snprintf(&at_cmd[atLen], MODEM_CMD_AT_MAX_LEN, "+KBNDCFG=%d,%s", rat, bnd_bitmap);
-    Modem_At_SendCmd(at_cmd);
+    cmd_start("+KBNDCFG=");
+    cmd_put_uint((uint32_t)rat);
+    cmd_put_str(",");
+    cmd_put_str(bnd_bitmap);
+    (void)cmd_send(NULL);
 }
 
 void Modem_Cmd_ReadBandConfiguration(void)
 {
-    static char at_cmd[] = "+KBNDCFG?";
-    Modem_At_SendCmd(at_cmd);
+    Modem_At_SendCmd("+KBNDCFG?");
 }
 
 void Modem_Cmd_GetActiveLTEBand(void)
 {
-    static char at_cmd[] = "+KBND?";
-    Modem_At_SendCmd(at_cmd);
+    Modem_At_SendCmd("+KBND?");
 }
 
 void Modem_Cmd_Read_SignalQuality(void)
 {
-    static char at_cmd[] = "+CESQ";
-    Modem_At_SendCmd(at_cmd);
+    Modem_At_SendCmd("+CESQ");
 }
 
 void Modem_Cmd_GrpsConnectionConfiguration(char *apn)
 {
-    char at_cmd[MODEM_CMD_AT_MAX_LEN];
-    int atLen = 0;
-    atLen += snprintf(&at_cmd[atLen], MODEM_CMD_AT_MAX_LEN, "+KCNXCFG=1,\"GPRS\",\"%s\"", apn);
-
-    Modem_At_SendCmd(at_cmd);
+    cmd_start("+KCNXCFG=1,\"GPRS\",\"");
+    cmd_put_str(apn);
+    cmd_put_str("\"");
+    (void)cmd_send(NULL);
 }
 
 void Modem_Cmd_TcpConnectionConfiguration(char *apn, char *host, uint16_t port)
 {
     // Modem_Cmd_GrpsConnectionConfiguration(apn);
 
-    char at_cmd[MODEM_CMD_AT_MAX_LEN];
-    int atLen = 0;
-    atLen += snprintf(&at_cmd[atLen], MODEM_CMD_AT_MAX_LEN, "+KTCPCFG=1,0,\"%s\",%u", host, port);
-
-    Modem_At_SendCmd(at_cmd);
+    cmd_start("+KTCPCFG=1,0,\"");
+    cmd_put_str(host);
+    cmd_put_str("\",");
+    cmd_put_uint(port);
+    (void)cmd_send(NULL);
 #if 0
     Modem_At_SendCmd("+KTCPCNX=1");
 #endif
@@ -265,42 +326,36 @@ void Modem_Cmd_TcpStartConnection(void)
 
 void Modem_Cmd_UdpCloseSession(uint8_t session_id)
 {
-    char at_cmd[MODEM_CMD_AT_MAX_LEN];
-    int atLen = 0;
-    atLen += snprintf(&at_cmd[atLen], MODEM_CMD_AT_MAX_LEN, "+KUDPCLOSE=%u", session_id);
-
-    Modem_At_SendCmd(at_cmd);
+    cmd_start("+KUDPCLOSE=");
+    cmd_put_uint(session_id);
+    (void)cmd_send(NULL);
 #if 0
-    atLen = 0;
-    atLen += sprintf(&at_cmd[atLen], "+KUDPDEL=%u", session_id);
-    Modem_At_SendCmd(at_cmd);
+    cmd_start("+KUDPDEL=");
+    cmd_put_uint(session_id);
+    (void)cmd_send(NULL);
 #endif
 }
 
 void Modem_Cmd_TcpCloseSession(uint8_t session_id)
 {
-    char at_cmd[MODEM_CMD_AT_MAX_LEN];
-    int atLen = 0;
-    atLen += snprintf(&at_cmd[atLen], MODEM_CMD_AT_MAX_LEN, "+KTCPCLOSE=%u", session_id);
-
-    Modem_At_SendCmd(at_cmd);
+    cmd_start("+KTCPCLOSE=");
+    cmd_put_uint(session_id);
+    (void)cmd_send(NULL);
 #if 0
-    atLen = 0;
-    atLen += snprintf(&at_cmd[atLen], MODEM_CMD_AT_MAX_LEN, "+KUDPDEL=%u", session_id);
-    Modem_At_SendCmd(at_cmd);
+    cmd_start("+KUDPDEL=");
+    cmd_put_uint(session_id);
+    (void)cmd_send(NULL);
 #endif
 }
 
 void Modem_Cmd_UdpDelSession(void)
 {
-    static char msg[] = "+KUDPDEL=?\r";
-    Modem_At_SendCmd(msg);
+    Modem_At_SendCmd("+KUDPDEL=?\r");
 }
 
 void Modem_Cmd_TcpDelSession(void)
 {
-    static char msg[] = "+KTCPDEL=?\r";
-    Modem_At_SendCmd(msg);
+    Modem_At_SendCmd("+KTCPDEL=?\r");
 }
 
 void Modem_Cmd_UdpConnectionConfiguration(char *apn)
@@ -310,46 +365,59 @@ void Modem_Cmd_UdpConnectionConfiguration(char *apn)
     Modem_At_SendCmd("+KUDPCFG=1,0");
 }
 
-void Modem_Cmd_SendTcpPacket(uint8_t *pkg, uint16_t len)
+void Modem_Cmd_SendTcpPacket(const uint8_t *hdr, uint8_t hdr_len, const uint8_t *pkg, uint16_t len)
 {
-    char atMsg[MODEM_CMD_AT_MAX_LEN];
+    Modem_At_QueuePacket(hdr, hdr_len, pkg, len);
+    len += hdr_len;
 
-    Modem_At_QueuePacket(pkg, len);
-
-    gen_cmd_send_frame_tcp(atMsg, len);
-    Modem_At_SendCmd(atMsg);
+    cmd_start("+KTCPSND=1,");
+    cmd_put_uint(len);
+    (void)cmd_send(NULL);
     Modem_At_ReqSend(len);
 
     Modem_Stats_TCPTxBytes(len);
     Modem_Stats_TCPTxFrames(1);
 }
 
-void Modem_Cmd_SendUdpPacket(uint8_t *pkg, uint16_t len, char *addr, uint16_t port)
-{
-    char atMsg[MODEM_CMD_AT_MAX_LEN];
-
-    Modem_At_QueuePacket(pkg, len);
-
-    gen_cmd_send_frame_udp(atMsg, len, addr, port);
-    Modem_At_SendCmd(atMsg);
+/*
+ * modem at +KUDPSND=1,"199.64.78.128",4154,11,1
+ * rai > 0 adds the release assistance indication, see enum modem_tx_release_e
+ */
+void Modem_Cmd_SendUdpPacket(const uint8_t *hdr, uint8_t hdr_len, const uint8_t *pkg, uint16_t len, char *addr, uint16_t port, uint8_t rai)
+{
+    Modem_At_QueuePacket(hdr, hdr_len, pkg, len);
+    len += hdr_len;
+
+    cmd_start("+KUDPSND=1,\"");
+    cmd_put_str(addr);
+    cmd_put_str("\",");
+    cmd_put_uint(port);
+    cmd_put_str(",");
+    cmd_put_uint(len);
+    if (rai > 0U)
+    {
+        cmd_put_str(",");
+        cmd_put_uint(rai);
+    }
+    (void)cmd_send(NULL);
     Modem_At_ReqSend(len);
 
     Modem_Stats_UDPTxBytes(len);
     Modem_Stats_UDPTxFrames(1);
 }
 
-void Modem_Cmd_AtGetData(uint16_t byte_count, char *tech)
+bool Modem_Cmd_AtGetData(uint16_t byte_count, char *tech, Modem_AtCmdDoneCb cb)
 {
-    char atMsg[MODEM_CMD_AT_MAX_LEN];
-    //size_t atLen = 0;
-    //waitForData = TRUE;
-    if (byte_count > 196U)
+    if (byte_count > MODEM_RX_READ_SIZE_MAX)
     {
-        byte_count = 196U;
+        byte_count = MODEM_RX_READ_SIZE_MAX;
     }
 
-    gen_cmd_read_bytes(atMsg, tech, byte_count);
-    Modem_At_SendCmd(atMsg);
+    cmd_start("+K");
+    cmd_put_str(tech);
+    cmd_put_str("RCV=1,");
+    cmd_put_uint(byte_count);
+    return cmd_send(cb);
 }
 
 void Modem_Cmd_CheckAt(void)
@@ -27,6 +27,10 @@ Public defines
 #define MODEM_FUN_FULL  1
 #define MODEM_FUN_AIRPLANE  4
 
+/* <AcT-type> of AT+CEDRXS */
+#define MODEM_EDRX_ACT_CAT_M1   4
+#define MODEM_EDRX_ACT_NB_IOT   5
+
 /*-----------------------------------------------------------------------------
 Public data types
 -----------------------------------------------------------------------------*/
@@ -48,10 +52,11 @@ void Modem_Cmd_UdpCloseSession(uint8_t session_id);
 void Modem_Cmd_TcpCloseSession(uint8_t session_id);
 void Modem_Cmd_UdpDelSession(void);
 void Modem_Cmd_TcpDelSession(void);
-void Modem_Cmd_SendTcpPacket(uint8_t *pkg, uint16_t len);
-void Modem_Cmd_SendUdpPacket(uint8_t *pkg, uint16_t len, char *addr, uint16_t port);
-void Modem_Cmd_AtGetData(uint16_t byte_count, char *tech);
+void Modem_Cmd_SendTcpPacket(const uint8_t *hdr, uint8_t hdr_len, const uint8_t *pkg, uint16_t len);
+void Modem_Cmd_SendUdpPacket(const uint8_t *hdr, uint8_t hdr_len, const uint8_t *pkg, uint16_t len, char *addr, uint16_t port, uint8_t rai);
+bool Modem_Cmd_AtGetData(uint16_t byte_count, char *tech, Modem_AtCmdDoneCb cb);
 void Modem_Cmd_CheckAt(void);
+void Modem_Cmd_SendBatch(const char *const *cmds, uint8_t count, Modem_AtCmdDoneCb cb);
 
 /* Modem commands */
 void Modem_Cmd_RequestModelIdentification(void);
@@ -64,11 +69,12 @@ void Modem_Cmd_SetBandConfiguration(int rat, const char *bnd_bitmap);
 void Modem_Cmd_ReadBandConfiguration(void);
 void Modem_Cmd_GetActiveLTEBand(void);
 void Modem_Cmd_Read_SignalQuality(void);
-void Modem_Cmd_ReadExtendedSignalQuality(void);
+void Modem_Cmd_ReadExtendedSignalQuality(Modem_AtCmdDoneCb cb);
 void Modem_Cmd_CommandPowerOff(void);
 void Modem_Cmd_RequestRegStat(void);
 void Modem_Cmd_SetCereg(int n);
 void Modem_Cmd_SetPhoneFunctionality(int fun, int rst);
+void Modem_Cmd_SetPowerSaving(const char *tau, const char *active_time, int edrx_act, const char *edrx_value);
 void Modem_Cmd_ConfigurePreferredRadioAccessTechnologyList(uint8_t rat1, uint8_t rat2, uint8_t rat3);
 void Modem_Cmd_ReadPreferredRadioAccessTechnologyList(void);
 
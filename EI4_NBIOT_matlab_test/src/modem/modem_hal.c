@@ -17,6 +17,10 @@ System level includes
 #include <os/config.h>
 #include <modem/modem.h>
 #include<stdio.h>
+#include <string.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 #include <test_modem_app.h>
 
@@ -25,6 +29,7 @@ System level includes
 /*-----------------------------------------------------------------------------
 Project level includes
 -----------------------------------------------------------------------------*/
+#include <os/sched.h>
 
 /*-----------------------------------------------------------------------------
 Local includes
@@ -89,6 +94,21 @@ Private defines
 
 #define PRINT_FUNC_NAME() printf("Call to hal function: %s\n", __func__)
 
+#if (MODEM_HAL_RX_RING_SIZE & (MODEM_HAL_RX_RING_SIZE - 1U)) != 0U
+#error "MODEM_HAL_RX_RING_SIZE must be a power of two"
+#endif
+#define RX_RING_MASK (MODEM_HAL_RX_RING_SIZE - 1U)
+
+/*
+ * Orders the ring data accesses against the index update. A compiler
+ * barrier is enough on the x86 host, gcc emits a dmb on the target.
+ */
+#if defined(_MSC_VER)
+#define RX_RING_FENCE() _ReadWriteBarrier()
+#else
+#define RX_RING_FENCE() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#endif
+
 
 /*-----------------------------------------------------------------------------
 Private data types
@@ -98,19 +118,69 @@ Private data types
 /*-----------------------------------------------------------------------------
 Private functions - declare static
 -----------------------------------------------------------------------------*/
-/* None */
+static bool Modem_Hal_TxStart(const struct modem_hal_txv_s *v, uint8_t n);
+static void Modem_Hal_TxKick(void);
 
 /*-----------------------------------------------------------------------------
 Private data - declare static
 -----------------------------------------------------------------------------*/
 static bool modem_uart_open = false;
 
+/*
+ * Free running indices, head is written by the rx interrupt only and tail by
+ * the scheduler only, so no lock is needed. Both wrap at 2^32, which is a
+ * multiple of the ring size.
+ */
+static uint8_t rx_ring[MODEM_HAL_RX_RING_SIZE];
+static volatile uint32_t rx_ring_head = 0U;
+static volatile uint32_t rx_ring_tail = 0U;
+static volatile uint32_t rx_ring_overflow = 0U;
+static volatile uint32_t rx_ring_high_water = 0U;
+static uint32_t rx_ring_overflow_reported = 0U;
+
+/*
+ * Running transmission, the descriptors are copied, the data stays with the
+ * caller until SCHED_LPUART_TX_DONE. The tx interrupt is the only one moving
+ * tx_part and tx_offset while tx_busy is set.
+ */
+static struct modem_hal_txv_s tx_parts[MODEM_HAL_TX_PARTS_MAX];
+static uint8_t tx_part_count = 0U;
+static uint8_t tx_part = 0U;
+static size_t tx_offset = 0U;
+static volatile bool tx_busy = false;
+static volatile bool tx_flow_stop = false; /* the modem is not ready to receive */
+
 
 
 /*-----------------------------------------------------------------------------
 Private Function implementations
 -----------------------------------------------------------------------------*/
 
+static bool Modem_Hal_TxStart(const struct modem_hal_txv_s *v, uint8_t n)
+{
+    if (tx_busy || (n == 0U) || (n > MODEM_HAL_TX_PARTS_MAX))
+    {
+        return false;
+    }
+    memcpy(tx_parts, v, n * sizeof(v[0]));
+    tx_part_count = n;
+    tx_part = 0U;
+    tx_offset = 0U;
+    tx_busy = true;
+    Modem_Hal_TxKick();
+
+    return true;
+}
+
+/* enables the tx empty interrupt, the host uart model drains on its own */
+static void Modem_Hal_TxKick(void)
+{
+    if (tx_busy && !tx_flow_stop)
+    {
+        test_env_uart_tx_kick();
+    }
+}
+
 /*-----------------------------------------------------------------------------
 Public Function implementations
 -----------------------------------------------------------------------------*/
@@ -128,6 +198,7 @@ void Modem_Hal_ResetLow(void)
 void Modem_Hal_ResetHigh(void)
 {
     PRINT_FUNC_NAME();
+    test_env_hal_reset(true);
 }
 
 void Modem_Hal_CtsLow(void)
@@ -140,6 +211,19 @@ void Modem_Hal_PulseOn(void)
     PRINT_FUNC_NAME();
 }
 
+/* WAKE_UP pin, high wakes the modem from hibernate (PSM) */
+void Modem_Hal_WakeUpHigh(void)
+{
+    PRINT_FUNC_NAME();
+    test_env_hal_wake_up(true);
+}
+
+void Modem_Hal_WakeUpLow(void)
+{
+    PRINT_FUNC_NAME();
+    test_env_hal_wake_up(false);
+}
+
 void Modem_Hal_CtsHigh(void)
 {
     PRINT_FUNC_NAME();
@@ -157,24 +241,101 @@ bool Modem_Hal_RtsIsHigh(void)
     return true;
 }
 
-void LpuartRxSched(char *respStr, uint16_t respLen)
+/*!
+ * \brief Stores bytes received by the uart, called from the rx interrupt
+ *
+ * Bytes not fitting into the ring are dropped and counted.
+ */
+void Modem_Hal_RxIsr(const uint8_t *buf, size_t len)
 {
-    PRINT_FUNC_NAME();
+    uint32_t head = rx_ring_head;
+    uint32_t used = head - rx_ring_tail;
+    size_t space = MODEM_HAL_RX_RING_SIZE - used;
+    size_t n = (len < space) ? len : space;
+    size_t first = MODEM_HAL_RX_RING_SIZE - (head & RX_RING_MASK);
+
+    if (first > n)
+    {
+        first = n;
+    }
+    memcpy(&rx_ring[head & RX_RING_MASK], buf, first);
+    memcpy(rx_ring, &buf[first], n - first);
+
+    /* publish the data before the new head */
+    RX_RING_FENCE();
+    rx_ring_head = head + (uint32_t)n;
+
+    if (n < len)
+    {
+        rx_ring_overflow += (uint32_t)(len - n);
+    }
+    if (used + n > rx_ring_high_water)
+    {
+        rx_ring_high_water = used + (uint32_t)n;
+    }
+    Sched_SetEvent(SCHED_LPUART_RX);
+}
 
-    uint8_t uartBuff[respLen];
-    for (int i = 0; i < strlen(respStr); i++) {
-        uartBuff[i] = (uint8_t)respStr[i];
+/*!
+ * \brief Drains the rx ring into the AT parser, scheduled by the rx interrupt
+ *
+ * The parser is fed with at most two blocks, in front of and behind the wrap
+ * around. The bytes are released after parsing.
+ */
+void LpuartRxSched(void)
+{
+    uint32_t tail = rx_ring_tail;
+    uint32_t head = rx_ring_head;
+    uint32_t overflow = rx_ring_overflow;
+
+    /* read the data not before the head */
+    RX_RING_FENCE();
+
+    while (tail != head)
+    {
+        size_t n = MODEM_HAL_RX_RING_SIZE - (tail & RX_RING_MASK);
+
+        if (n > head - tail)
+        {
+            n = head - tail;
+        }
+        Modem_Hal_RxBlockInd(&rx_ring[tail & RX_RING_MASK], n);
+        Modem_Stats_UartRxBytes((uint16_t)n);
+        tail += (uint32_t)n;
     }
 
-    for (int n = 0; n < respLen; n++)
+    /* done with the data before the space is released */
+    RX_RING_FENCE();
+    rx_ring_tail = tail;
+
+    if (overflow != rx_ring_overflow_reported)
     {
-       Modem_Hal_CharRxIndCb(uartBuff[n]);
+        MODEM_PRINTF_ERROR("uart rx ring overflow, %u bytes lost\n", (unsigned int)(overflow - rx_ring_overflow_reported));
+        Modem_Stats_ModemLostBytes((uint16_t)(overflow - rx_ring_overflow_reported));
+        rx_ring_overflow_reported = overflow;
     }
 }
 
+size_t Modem_Hal_RxRingFree(void)
+{
+    return MODEM_HAL_RX_RING_SIZE - (size_t)(rx_ring_head - rx_ring_tail);
+}
+
+uint32_t Modem_Hal_RxRingOverflows(void)
+{
+    return rx_ring_overflow;
+}
+
+uint32_t Modem_Hal_RxRingHighWater(void)
+{
+    return rx_ring_high_water;
+}
+
 void Modem_Hal_Init(void)
 {
     PRINT_FUNC_NAME();
+    tx_busy = false;
+    tx_flow_stop = false;
 }
 
 void Modem_Hal_UartOpen(void)
@@ -196,6 +357,12 @@ void Modem_Hal_UartClose(void)
 
         modem_uart_open = false;
     }
+    /* the rest is dropped, the command waiting for it runs into its timeout */
+    if (tx_busy)
+    {
+        tx_busy = false;
+        Sched_SetEvent(SCHED_LPUART_TX_DONE);
+    }
 }
 
 void Modem_Hal_TransmitStr(const char *msg)
@@ -211,6 +378,111 @@ void Modem_Hal_TransmitRaw(uint8_t *raw, size_t len)
 
 }
 
+/*!
+ * \brief Starts transmitting an AT command line, returns at once
+ *
+ * The line has to stay valid until SCHED_LPUART_TX_DONE reported the last
+ * byte sent. Returns false while the previous transmission is running.
+ */
+bool Modem_Hal_TxStartCmd(const char *atMsg, size_t atLen)
+{
+    struct modem_hal_txv_s v = { (const uint8_t *)atMsg, atLen };
+
+    PRINT_FUNC_NAME();
+    if (tx_busy)
+    {
+        return false;
+    }
+    test_env_tx_to_modem((char *)atMsg);
+
+    return Modem_Hal_TxStart(&v, 1U);
+}
+
+/*!
+ * \brief Starts transmitting the parts in order, each straight from its own storage
+ *
+ * Nothing is copied, a DMA capable uart chains one descriptor per part. The
+ * parts have to stay valid until SCHED_LPUART_TX_DONE reported the last byte
+ * sent. Returns false while the previous transmission is running.
+ */
+bool Modem_Hal_TxStartRaw(const struct modem_hal_txv_s *v, uint8_t n)
+{
+    PRINT_FUNC_NAME();
+    if (tx_busy)
+    {
+        return false;
+    }
+    test_env_tx_raw_to_modem(v, n);
+
+    return Modem_Hal_TxStart(v, n);
+}
+
+bool Modem_Hal_TxBusy(void)
+{
+    return tx_busy;
+}
+
+/*!
+ * \brief Feeds the uart, called from the tx empty interrupt
+ *
+ * Moves up to room bytes, the free space of the tx fifo, and nothing while
+ * the modem holds the flow control. The last byte schedules
+ * SCHED_LPUART_TX_DONE. Returns the number of bytes moved.
+ */
+size_t Modem_Hal_TxIsr(size_t room)
+{
+    size_t sent = 0U;
+
+    while (tx_busy && !tx_flow_stop && (sent < room))
+    {
+        const struct modem_hal_txv_s *part = &tx_parts[tx_part];
+        size_t n = part->len - tx_offset;
+
+        if (n > room - sent)
+        {
+            n = room - sent;
+        }
+        /* the uart takes part->buf[tx_offset] up to part->buf[tx_offset + n - 1] */
+        tx_offset += n;
+        sent += n;
+
+        if (tx_offset == part->len)
+        {
+            tx_part++;
+            tx_offset = 0U;
+            if (tx_part == tx_part_count)
+            {
+                tx_busy = false;
+                Sched_SetEvent(SCHED_LPUART_TX_DONE);
+            }
+        }
+    }
+
+    return sent;
+}
+
+/*!
+ * \brief Pauses or resumes the transmission, called on a flow control edge
+ */
+void Modem_Hal_TxFlowInd(bool stop)
+{
+    tx_flow_stop = stop;
+    Modem_Hal_TxKick();
+}
+
+/*!
+ * \brief Reports the end of the transmission, scheduled by the tx interrupt
+ *
+ * A transmission started before the event ran reports on its own.
+ */
+void LpuartTxDoneSched(void)
+{
+    if (!tx_busy)
+    {
+        Modem_Hal_TxDoneInd();
+    }
+}
+
 void Modem_Hal_TransmitCmdWaitRsp(const char *atMsg, size_t atLen)
 {
     PRINT_FUNC_NAME();
@@ -22,16 +22,28 @@ Required header files
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stddef.h>
 
 /*-----------------------------------------------------------------------------
 Public defines
 -----------------------------------------------------------------------------*/
-/* None */
+/* rx ring between the uart rx interrupt and SCHED_LPUART_RX, power of two */
+#ifndef MODEM_HAL_RX_RING_SIZE
+#define MODEM_HAL_RX_RING_SIZE 1024U
+#endif
+
+/* parts of one asynchronous transmission, header, payload and EOF pattern */
+#define MODEM_HAL_TX_PARTS_MAX 3U
 
 /*-----------------------------------------------------------------------------
 Public data types
 -----------------------------------------------------------------------------*/
-/* None */
+/* one part of a gathered transmission, see Modem_Hal_TxStartRaw() */
+struct modem_hal_txv_s
+{
+    const uint8_t *buf;
+    size_t len;
+};
 
 /*-----------------------------------------------------------------------------
  Public Data
@@ -51,14 +63,33 @@ void Modem_Hal_CtsHigh(void);
 void Modem_Hal_ResetLow(void);
 void Modem_Hal_ResetHigh(void);
 void Modem_Hal_PulseOn(void);
+void Modem_Hal_WakeUpHigh(void);
+void Modem_Hal_WakeUpLow(void);
 void Modem_Hal_TransmitCmdWaitRsp(const char *atMsg, size_t atLen);
 void Modem_Hal_TransmitStr(const char *msg);
 bool Modem_Hal_CtsIsHigh(void);
 bool Modem_Hal_RtsIsHigh(void);
 void Modem_Hal_TransmitRaw(uint8_t *raw, size_t len);
 
+/* asynchronous transmit, SCHED_LPUART_TX_DONE reports the last byte sent */
+bool Modem_Hal_TxStartCmd(const char *atMsg, size_t atLen);
+bool Modem_Hal_TxStartRaw(const struct modem_hal_txv_s *v, uint8_t n);
+bool Modem_Hal_TxBusy(void);
+size_t Modem_Hal_TxIsr(size_t room);
+void Modem_Hal_TxFlowInd(bool stop);
+void LpuartTxDoneSched(void);
+
+/* rx ring, Modem_Hal_RxIsr() is the only producer, LpuartRxSched() the only consumer */
+void Modem_Hal_RxIsr(const uint8_t *buf, size_t len);
+void LpuartRxSched(void);
+size_t Modem_Hal_RxRingFree(void);
+uint32_t Modem_Hal_RxRingOverflows(void);
+uint32_t Modem_Hal_RxRingHighWater(void);
+
 /* Callback - called from hal, shall be defined in higher layers */
 void Modem_Hal_CharRxIndCb(char chr);
+void Modem_Hal_RxBlockInd(const uint8_t *buf, size_t len);
+void Modem_Hal_TxDoneInd(void);
 
 void test_env_hal_set_Cts(bool status);
 
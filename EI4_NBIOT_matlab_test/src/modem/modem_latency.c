@@ -0,0 +1,302 @@
+/*!
+ * \file    modem_latency.c
+ * \brief   Implementation of the AT command latency tracking
+ *
+ * \note    Company    : Elster GmbH, Osnabrueck
+ * \n       Department : R&D Residential Gas Metering
+ * \n       Copyright  : 2026
+ *
+ * \author  agent
+ * \date    17.10.2026
+ *
+ *********************************************************/
+
+/*-----------------------------------------------------------------------------
+System level includes
+-----------------------------------------------------------------------------*/
+#include <os/config.h>
+
+#include <string.h>
+
+/*-----------------------------------------------------------------------------
+Project level includes
+-----------------------------------------------------------------------------*/
+#include <os/types.h>
+#include <os/debug.h>
+#include <os/rtc.h>
+#include <os/utils.h>
+
+#include <modem/modem.h>
+
+#include <store/umi_codes.h>
+#include <store/umi_metadata.h>
+
+/*-----------------------------------------------------------------------------
+Local includes
+-----------------------------------------------------------------------------*/
+#include <modem_latency.h>
+#include <modem_debug.h>
+#include <modem_umi.h>
+
+/*-----------------------------------------------------------------------------
+Public data
+-----------------------------------------------------------------------------*/
+/* None */
+
+/*-----------------------------------------------------------------------------
+Private defines
+-----------------------------------------------------------------------------*/
+#define LATENCY_CLASS_COUNT     UTILS_ARRAYSIZE(latency_classes)
+#define LATENCY_BUCKET_COUNT    UTILS_ARRAYSIZE(latency.histogram[0])
+
+/* bucket b counts the responses faster than LATENCY_BUCKET_LIMIT(b), the
+   last bucket everything slower */
+#define LATENCY_BUCKET0_MS      16UL
+#define LATENCY_BUCKET_LIMIT(b) (LATENCY_BUCKET0_MS << (b))
+
+/* the buckets are halved once a class reached this count, so that the
+   histogram follows a changing network */
+#define LATENCY_SAMPLES_MAX     1024U
+
+/*-----------------------------------------------------------------------------
+Private data types
+-----------------------------------------------------------------------------*/
+struct latency_class_s
+{
+    const char *prefix;
+    uint32_t min_ms;
+    uint32_t max_ms;
+};
+
+/*-----------------------------------------------------------------------------
+Private functions - declare static
+-----------------------------------------------------------------------------*/
+static uint8_t LatencyClass(const char *cmd);
+static uint32_t LatencySamples(uint8_t cls);
+static uint32_t LatencyP99(uint8_t cls);
+static uint32_t LatencyTimeout(uint8_t cls);
+static void LatencyRecord(uint8_t cls, uint32_t ms);
+
+/*-----------------------------------------------------------------------------
+Private data - declare static
+-----------------------------------------------------------------------------*/
+/* first matching prefix wins, at most UTILS_ARRAYSIZE(latency.ewma) entries,
+   the last entry takes all other commands. The limits follow the maximum
+   response times of the HL7810 AT command guide. */
+static const struct latency_class_s latency_classes[] =
+{
+    { "",       300U,   MODEM_AT_TIMEOUT_TIME_MS }, /* "AT" probe */
+    { "+CFUN",  1000U,  30000U },
+    { "+COPS",  1000U,  180000U },
+    { "+CPOF",  1000U,  30000U },
+    { "+KUDP",  500U,   30000U },
+    { "+KTCP",  500U,   30000U },
+    { NULL,     300U,   MODEM_AT_TIMEOUT_TIME_MS },
+};
+
+static umi_modem_at_latency_native_object_t latency = {0};
+static uint8_t latency_class = 0U;
+static uint32_t latency_start_ms = 0U;
+static bool latency_armed = false;
+
+/*-----------------------------------------------------------------------------
+Private Function implementations
+-----------------------------------------------------------------------------*/
+/* cmd may still end with the \r of the transmitted line */
+static uint8_t LatencyClass(const char *cmd)
+{
+    uint8_t cls;
+
+    for (cls = 0U; cls < LATENCY_CLASS_COUNT - 1U; cls++)
+    {
+        size_t len = strlen(latency_classes[cls].prefix);
+
+        if ((len == 0U) ? ((cmd[0] == '\0') || (cmd[0] == '\r')) : (strncmp(cmd, latency_classes[cls].prefix, len) == 0))
+        {
+            break;
+        }
+    }
+    return cls;
+}
+
+static uint32_t LatencySamples(uint8_t cls)
+{
+    uint32_t total = 0U;
+
+    for (uint8_t b = 0U; b < LATENCY_BUCKET_COUNT; b++)
+    {
+        total += latency.histogram[cls][b];
+    }
+    return total;
+}
+
+/* upper limit of the bucket holding the 99th percentile, 0 without samples */
+static uint32_t LatencyP99(uint8_t cls)
+{
+    uint32_t total = LatencySamples(cls);
+    uint32_t need = total - (total / 100U);
+    uint32_t sum = 0U;
+
+    for (uint8_t b = 0U; (total > 0U) && (b < LATENCY_BUCKET_COUNT); b++)
+    {
+        sum += latency.histogram[cls][b];
+        if (sum >= need)
+        {
+            return LATENCY_BUCKET_LIMIT(b);
+        }
+    }
+    return 0U;
+}
+
+static uint32_t LatencyTimeout(uint8_t cls)
+{
+    /* an unlearned class waits as long as the command guide allows */
+    uint32_t timeout = latency_classes[cls].max_ms;
+
+    if (LatencySamples(cls) >= MODEM_LATENCY_SAMPLES_MIN)
+    {
+        timeout = MODEM_LATENCY_TIMEOUT_FACTOR * LatencyP99(cls);
+    }
+    if (timeout < latency_classes[cls].min_ms)
+    {
+        timeout = latency_classes[cls].min_ms;
+    }
+    if (timeout > latency_classes[cls].max_ms)
+    {
+        timeout = latency_classes[cls].max_ms;
+    }
+    return timeout;
+}
+
+static void LatencyRecord(uint8_t cls, uint32_t ms)
+{
+    uint8_t bucket = 0U;
+    uint16_t *ewma = &latency.ewma[cls];
+
+    while ((bucket < LATENCY_BUCKET_COUNT - 1U) && (ms >= LATENCY_BUCKET_LIMIT(bucket)))
+    {
+        bucket++;
+    }
+
+    if (ms > UINT16_MAX)
+    {
+        ms = UINT16_MAX;
+    }
+    if (LatencySamples(cls) == 0U)
+    {
+        *ewma = (uint16_t)ms;
+    }
+    else
+    {
+        /* alpha = 1/8 */
+        *ewma = (uint16_t)((int32_t)*ewma + (((int32_t)ms - (int32_t)*ewma) / 8));
+    }
+
+    latency.histogram[cls][bucket]++;
+    if (LatencySamples(cls) >= LATENCY_SAMPLES_MAX)
+    {
+        for (uint8_t b = 0U; b < LATENCY_BUCKET_COUNT; b++)
+        {
+            latency.histogram[cls][b] /= 2U;
+        }
+    }
+}
+
+/*-----------------------------------------------------------------------------
+Public Function implementations
+-----------------------------------------------------------------------------*/
+
+void Modem_Latency_Init(void)
+{
+    memset(&latency, 0, sizeof(latency));
+    latency_armed = false;
+    Modem_Umi_RestoreAtLatency(&latency, SIZEOFU16(latency));
+}
+
+void Modem_Latency_Save(void)
+{
+    Modem_Umi_StoreAtLatency(&latency, SIZEOFU16(latency));
+}
+
+/*!
+ * \brief Response timeout of a command, without the leading "AT"
+ *
+ * The maximum of the class until it has MODEM_LATENCY_SAMPLES_MIN samples,
+ * then MODEM_LATENCY_TIMEOUT_FACTOR times its p99, clamped to the limits of
+ * the class. A slow class is so first measured and then narrowed.
+ */
+uint32_t Modem_Latency_Timeout(const char *cmd)
+{
+    return LatencyTimeout(LatencyClass(cmd));
+}
+
+uint32_t Modem_Latency_P99(const char *cmd)
+{
+    return LatencyP99(LatencyClass(cmd));
+}
+
+uint32_t Modem_Latency_Ewma(const char *cmd)
+{
+    return latency.ewma[LatencyClass(cmd)];
+}
+
+/*!
+ * \brief Starts measuring the response time, call when the command is sent
+ */
+void Modem_Latency_Start(const char *cmd)
+{
+    latency_class = LatencyClass(cmd);
+    latency_start_ms = Rtc_GetUptimeMs();
+    latency_armed = true;
+}
+
+/*!
+ * \brief Ends the measurement started by Modem_Latency_Start()
+ *
+ * OK and ERROR responses are recorded. A timeout is only recorded once the
+ * timeout of the class is learned, so that a timeout which turned out to be
+ * too short widens itself, while a modem which does not answer within the
+ * maximum of the class teaches nothing.
+ */
+void Modem_Latency_Done(enum modem_at_result_e result)
+{
+    uint32_t elapsed = Rtc_GetUptimeMs() - latency_start_ms;
+
+    if (!latency_armed)
+    {
+        return;
+    }
+    latency_armed = false;
+
+    switch (result)
+    {
+    case modem_at_result_ok:
+    case modem_at_result_error:
+        LatencyRecord(latency_class, elapsed);
+        break;
+
+    case modem_at_result_timeout:
+        if (LatencySamples(latency_class) >= MODEM_LATENCY_SAMPLES_MIN)
+        {
+            LatencyRecord(latency_class, elapsed);
+        }
+        break;
+
+    default:
+        /* not answered, nothing to learn */
+        break;
+    }
+}
+
+#ifdef OS_DEBUG_PRINTF_ENABLED
+void Modem_Latency_PrintStats(void)
+{
+    MODEM_PRINTF_INFO("AtLatency:\n");
+    for (uint8_t cls = 0U; cls < LATENCY_CLASS_COUNT; cls++)
+    {
+        MODEM_PRINTF_INFO("    %s: n %u, ewma %u ms, p99 %u ms, timeout %u ms\n",
+                          (latency_classes[cls].prefix != NULL) ? latency_classes[cls].prefix : "*",
+                          LatencySamples(cls), latency.ewma[cls], LatencyP99(cls), LatencyTimeout(cls));
+    }
+}
+#endif
@@ -0,0 +1,67 @@
+/*!
+ * \file    modem_latency.h
+ * \brief   Response latency tracking of the AT commands
+ *
+ * The commands are grouped into classes by their prefix. Per class a
+ * histogram of the observed response times gives the p99, the AT timeout is
+ * a multiple of it, clamped to the limits of the class. The histograms are
+ * kept in the store across power cycles.
+ *
+ * \note    Company    : Elster GmbH, Osnabrueck
+ * \n       Department : R&D Residential Gas Metering
+ * \n       Copyright  : 2026
+ *
+ * \author  agent
+ * \date    17.10.2026
+ *
+ *********************************************************/
+
+#ifndef SRC_APP_MODEM_MODEM_LATENCY_H_
+#define SRC_APP_MODEM_MODEM_LATENCY_H_
+
+
+/*-----------------------------------------------------------------------------
+Required header files
+-----------------------------------------------------------------------------*/
+#include <os/config.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <modem_at.h>
+
+/*-----------------------------------------------------------------------------
+Public defines
+-----------------------------------------------------------------------------*/
+/* samples of a class before its timeout is derived from them */
+#define MODEM_LATENCY_SAMPLES_MIN       16U
+/* timeout = MODEM_LATENCY_TIMEOUT_FACTOR * p99 */
+#define MODEM_LATENCY_TIMEOUT_FACTOR    2U
+
+/*-----------------------------------------------------------------------------
+Public data types
+-----------------------------------------------------------------------------*/
+/* None */
+
+/*-----------------------------------------------------------------------------
+ Public Data
+ -----------------------------------------------------------------------------*/
+/* None */
+
+/*-----------------------------------------------------------------------------
+Public functions
+-----------------------------------------------------------------------------*/
+void Modem_Latency_Init(void);
+void Modem_Latency_Save(void);
+uint32_t Modem_Latency_Timeout(const char *cmd);
+uint32_t Modem_Latency_P99(const char *cmd);
+uint32_t Modem_Latency_Ewma(const char *cmd);
+void Modem_Latency_Start(const char *cmd);
+void Modem_Latency_Done(enum modem_at_result_e result);
+
+#ifdef OS_DEBUG_PRINTF_ENABLED
+void Modem_Latency_PrintStats(void);
+#endif
+
+
+#endif /* SRC_APP_MODEM_MODEM_LATENCY_H_ */
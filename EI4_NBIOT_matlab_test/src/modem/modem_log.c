@@ -0,0 +1,142 @@
+/*!
+ * \file    modem_log.c
+ * \brief   Implementation of the tokenized binary log of the modem driver
+ *
+ * \note    Company    : Elster GmbH, Osnabrueck
+ * \n       Department : R&D Residential Gas Metering
+ * \n       Copyright  : 2026
+ *
+ * \author  agent
+ * \date    17.10.2026
+ *
+ *********************************************************/
+
+/*-----------------------------------------------------------------------------
+System level includes
+-----------------------------------------------------------------------------*/
+#include <os/config.h>
+
+/*-----------------------------------------------------------------------------
+Project level includes
+-----------------------------------------------------------------------------*/
+#include <os/types.h>
+
+/*-----------------------------------------------------------------------------
+Local includes
+-----------------------------------------------------------------------------*/
+#include <modem_log.h>
+
+/*-----------------------------------------------------------------------------
+Public data
+-----------------------------------------------------------------------------*/
+/* None */
+
+/*-----------------------------------------------------------------------------
+Private defines
+-----------------------------------------------------------------------------*/
+#if (MODEM_LOG_RING_WORDS & (MODEM_LOG_RING_WORDS - 1U)) != 0U
+#error "MODEM_LOG_RING_WORDS must be a power of two"
+#endif
+#define LOG_RING_MASK (MODEM_LOG_RING_WORDS - 1U)
+
+/* record header: id in the upper, argument count in the lower half word */
+#define LOG_HEADER(id, argc)    (((uint32_t)(id) << 16) | (uint32_t)(argc))
+#define LOG_HEADER_ID(hdr)      ((uint16_t)((hdr) >> 16))
+#define LOG_HEADER_ARGC(hdr)    ((uint8_t)((hdr) & 0xFFU))
+
+/*-----------------------------------------------------------------------------
+Private data types
+-----------------------------------------------------------------------------*/
+/* None */
+
+/*-----------------------------------------------------------------------------
+Private functions - declare static
+-----------------------------------------------------------------------------*/
+/* None */
+
+/*-----------------------------------------------------------------------------
+Private data - declare static
+-----------------------------------------------------------------------------*/
+/* free running word indices, written from the main loop only */
+static uint32_t log_ring[MODEM_LOG_RING_WORDS];
+static uint32_t log_head = 0U;
+static uint32_t log_tail = 0U;
+static uint32_t log_dropped = 0U;
+
+/*-----------------------------------------------------------------------------
+Private Function implementations
+-----------------------------------------------------------------------------*/
+/* None */
+
+/*-----------------------------------------------------------------------------
+Public Function implementations
+-----------------------------------------------------------------------------*/
+
+/*!
+ * \brief Records a message, use the MODEM_LOGn() macros
+ *
+ * When the ring is full the oldest records are dropped, so the most recent
+ * history is kept.
+ */
+void Modem_Log_Write(uint16_t id, uint8_t argc, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3)
+{
+    uint32_t need = 1U + (uint32_t)argc;
+
+    while ((MODEM_LOG_RING_WORDS - (log_head - log_tail)) < need)
+    {
+        log_tail += 1U + LOG_HEADER_ARGC(log_ring[log_tail & LOG_RING_MASK]);
+        log_dropped++;
+    }
+
+    log_ring[log_head & LOG_RING_MASK] = LOG_HEADER(id, argc);
+    switch (argc)
+    {
+    case 4U:
+        log_ring[(log_head + 4U) & LOG_RING_MASK] = a3;
+        /* fall through */
+    case 3U:
+        log_ring[(log_head + 3U) & LOG_RING_MASK] = a2;
+        /* fall through */
+    case 2U:
+        log_ring[(log_head + 2U) & LOG_RING_MASK] = a1;
+        /* fall through */
+    case 1U:
+        log_ring[(log_head + 1U) & LOG_RING_MASK] = a0;
+        break;
+    default:
+        break;
+    }
+    log_head += need;
+}
+
+/*!
+ * \brief Takes the oldest record out of the ring
+ *
+ * \return false if the ring is empty
+ */
+bool Modem_Log_Read(uint16_t *id, uint8_t *argc, uint32_t args[MODEM_LOG_ARGS_MAX])
+{
+    uint32_t hdr;
+
+    if (log_tail == log_head)
+    {
+        return false;
+    }
+    hdr = log_ring[log_tail & LOG_RING_MASK];
+    *id = LOG_HEADER_ID(hdr);
+    *argc = LOG_HEADER_ARGC(hdr);
+    for (uint8_t i = 0U; i < *argc; i++)
+    {
+        args[i] = log_ring[(log_tail + 1U + i) & LOG_RING_MASK];
+    }
+    log_tail += 1U + (uint32_t)*argc;
+    return true;
+}
+
+/*!
+ * \brief Number of records overwritten before they were read
+ */
+uint32_t Modem_Log_Dropped(void)
+{
+    return log_dropped;
+}
@@ -0,0 +1,70 @@
+/*!
+ * \file    modem_log.h
+ * \brief   Tokenized binary log of the modem driver
+ *
+ * A call site records a 16 bit message id and up to four 32 bit arguments
+ * into a RAM ring, nothing is formatted on the target. The text is rebuilt
+ * on the host from the formats in modem_log_entries.h.
+ *
+ * \note    Company    : Elster GmbH, Osnabrueck
+ * \n       Department : R&D Residential Gas Metering
+ * \n       Copyright  : 2026
+ *
+ * \author  agent
+ * \date    17.10.2026
+ *
+ *********************************************************/
+
+#ifndef SRC_APP_MODEM_MODEM_LOG_H_
+#define SRC_APP_MODEM_MODEM_LOG_H_
+
+
+/*-----------------------------------------------------------------------------
+Required header files
+-----------------------------------------------------------------------------*/
+#include <os/config.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*-----------------------------------------------------------------------------
+Public defines
+-----------------------------------------------------------------------------*/
+/* ring size in 32 bit words, power of two, a record takes 1 + argc words */
+#ifndef MODEM_LOG_RING_WORDS
+#define MODEM_LOG_RING_WORDS 256U
+#endif
+
+#define MODEM_LOG_ARGS_MAX 4U
+
+#define MODEM_LOG0(id)              Modem_Log_Write((id), 0U, 0U, 0U, 0U, 0U)
+#define MODEM_LOG1(id, a)           Modem_Log_Write((id), 1U, (uint32_t)(a), 0U, 0U, 0U)
+#define MODEM_LOG2(id, a, b)        Modem_Log_Write((id), 2U, (uint32_t)(a), (uint32_t)(b), 0U, 0U)
+#define MODEM_LOG3(id, a, b, c)     Modem_Log_Write((id), 3U, (uint32_t)(a), (uint32_t)(b), (uint32_t)(c), 0U)
+#define MODEM_LOG4(id, a, b, c, d)  Modem_Log_Write((id), 4U, (uint32_t)(a), (uint32_t)(b), (uint32_t)(c), (uint32_t)(d))
+
+/*-----------------------------------------------------------------------------
+Public data types
+-----------------------------------------------------------------------------*/
+#define MODEM_LOG_ENTRY(id, fmt) id,
+enum modem_log_id_e
+{
+#include <modem_log_entries.h>
+    MODEM_LOG_ID_COUNT
+};
+#undef MODEM_LOG_ENTRY
+
+/*-----------------------------------------------------------------------------
+ Public Data
+ -----------------------------------------------------------------------------*/
+/* None */
+
+/*-----------------------------------------------------------------------------
+Public functions
+-----------------------------------------------------------------------------*/
+void Modem_Log_Write(uint16_t id, uint8_t argc, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3);
+bool Modem_Log_Read(uint16_t *id, uint8_t *argc, uint32_t args[MODEM_LOG_ARGS_MAX]);
+uint32_t Modem_Log_Dropped(void);
+
+
+#endif /* SRC_APP_MODEM_MODEM_LOG_H_ */
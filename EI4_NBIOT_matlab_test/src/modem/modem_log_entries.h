@@ -0,0 +1,19 @@
+/*
+ * Messages of the tokenized modem log, MODEM_LOG_ENTRY(id, format)
+ *
+ * Only the ids are compiled into the firmware, the formats are used by the
+ * host side decoder. Arguments are 32 bit words, so the formats may only use
+ * integer conversions. Append new entries at the end to keep the ids stable.
+ */
+/* flags: 0x01 registered, 0x02 connected, 0x04 UDP session, 0x08 TCP session */
+MODEM_LOG_ENTRY(MODEM_LOG_NEXT_ACTION, "ModemNextAction %u, flags 0x%02x, last action %u\n")
+MODEM_LOG_ENTRY(MODEM_LOG_POWERED_DOWN, "Module powered down, all actions done\n")
+MODEM_LOG_ENTRY(MODEM_LOG_RETRY_CHECK, "tries: %u, limit: %u\n")
+MODEM_LOG_ENTRY(MODEM_LOG_RETRIES_EXCEEDED, "Modem max action retries exceeded, state %u, last action %u\n")
+MODEM_LOG_ENTRY(MODEM_LOG_NO_NETWORK, "Not able to access network!\n")
+/* flags: 0x01 connected, 0x02/0x04/0x08 session 0/1/2 open, 0x10 want to send, 0x20 tx packet queued, 0x40 cfg written */
+MODEM_LOG_ENTRY(MODEM_LOG_READY_FOR_COMM, "Ready for communication, flags 0x%02x, wait_for_rsp %u\n")
+MODEM_LOG_ENTRY(MODEM_LOG_READY_TO_SEND, "Ready to send!\n")
+MODEM_LOG_ENTRY(MODEM_LOG_UDP_SEND_RSP, "+KUDPSND: ready to send %u bytes via UDP\n")
+MODEM_LOG_ENTRY(MODEM_LOG_UDP_RECV_RSP, "+KUDPRCV: ready to receive %u bytes via UDP\n")
+MODEM_LOG_ENTRY(MODEM_LOG_TCP_RECV_RSP, "+KTCPRCV: ready to receive %u bytes\n")
@@ -60,6 +60,9 @@ Private functions - declare static
 Private data - declare static
 -----------------------------------------------------------------------------*/
 static umi_modem_statistics_native_object_t modem_statistics = {0};
+/* not part of the UMI object */
+static uint32_t at_rx_lines_discarded = 0U;
+static uint32_t at_cmds_dropped = 0U;
 
 /*-----------------------------------------------------------------------------
 Private Function implementations
@@ -153,6 +156,26 @@ void Modem_Stats_ModemLostBytes(uint16_t count)
 {
 }
 
+void Modem_Stats_AtRxLineDiscarded(void)
+{
+    at_rx_lines_discarded++;
+}
+
+uint32_t Modem_Stats_GetAtRxLinesDiscarded(void)
+{
+    return at_rx_lines_discarded;
+}
+
+void Modem_Stats_AtCmdDropped(void)
+{
+    at_cmds_dropped++;
+}
+
+uint32_t Modem_Stats_GetAtCmdsDropped(void)
+{
+    return at_cmds_dropped;
+}
+
 #ifdef OS_DEBUG_PRINTF_ENABLED
 void Modem_Stats_PrintStats(void)
 {
@@ -171,6 +194,8 @@ void Modem_Stats_PrintStats(void)
     MODEM_PRINTF_INFO("    TCPRxBytes : %u\n", modem_statistics.TCPRxBytes);
     MODEM_PRINTF_INFO("    TCPTxFrames: %u\n", modem_statistics.TCPTxFrames);
     MODEM_PRINTF_INFO("    TCPRxFrames: %u\n", modem_statistics.TCPRxFrames);
+    MODEM_PRINTF_INFO("    AtRxLinesDiscarded: %u\n", at_rx_lines_discarded);
+    MODEM_PRINTF_INFO("    AtCmdsDropped: %u\n", at_cmds_dropped);
 }
 #endif
 
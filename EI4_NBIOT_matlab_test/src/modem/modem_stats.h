@@ -56,6 +56,10 @@ void Modem_Stats_ModemStarted(void);
 void Modem_Stats_ModemFullFunction(void);
 void Modem_Stats_ModemEmptyPackets(void);
 void Modem_Stats_ModemLostBytes(uint16_t count);
+void Modem_Stats_AtRxLineDiscarded(void);
+void Modem_Stats_AtCmdDropped(void);
+uint32_t Modem_Stats_GetAtCmdsDropped(void);
+uint32_t Modem_Stats_GetAtRxLinesDiscarded(void);
 void Modem_Stats_Save(void);
 void Modem_Stats_Load(void);
 bool Modem_Stats_FirstPowerUp(void);
@@ -64,7 +64,7 @@ Private data types
 /*-----------------------------------------------------------------------------
 Private functions - declare static
 -----------------------------------------------------------------------------*/
-/* None */
+static bool Modem_Umi_ReadSimInfoStr(Umi_Member_t member, char *dest, size_t size);
 
 /*-----------------------------------------------------------------------------
 Private data - declare static
@@ -78,7 +78,23 @@ static umi_modem_cfg_native_object_t modem_configuration = {0};
 /*-----------------------------------------------------------------------------
 Private Function implementations
 -----------------------------------------------------------------------------*/
-/* None */
+#ifdef MODEM_ENABLED
+
+/* true if the member holds a string */
+static bool Modem_Umi_ReadSimInfoStr(Umi_Member_t member, char *dest, size_t size)
+{
+    egm_uint16_t data_used = 0U;
+
+    if ((Store_ReadMember(UMI_CODE_MODEM_SIM_INFO, member, dest, (uint16_t)size, &data_used) != EGM_ERR_OK) || (data_used > size))
+    {
+        data_used = 0U;
+    }
+    dest[(data_used < size) ? data_used : size - 1U] = 0;
+
+    return dest[0] != 0;
+}
+
+#endif
 
 /*-----------------------------------------------------------------------------
 Public Function implementations
@@ -98,6 +114,7 @@ void Modem_GetConfigurationFromUmi(void)
     strcpy((char*)modem_configuration.cnx_type, "UDP");
     //modem_configuration.wait_for_response_timeout = 0;
     modem_configuration.remote_port = 4154;
+    modem_configuration.communication_session_timeout = 300;
     modem_configuration.rat1 = 2;
     modem_configuration.rat2 = 1;
     
@@ -178,6 +195,29 @@ uint8_t Modem_Umi_CfgGetRat3(void)
     return modem_configuration.rat3;
 }
 
+uint8_t Modem_Umi_CfgGetPsmMode(void)
+{
+    return modem_configuration.psm_mode;
+}
+
+/* requested periodic TAU (T3412 extended), 8 bit string as in 3GPP 27.007 */
+char *Modem_Umi_CfgGetPsmPeriodicTau(void)
+{
+    return (char *)modem_configuration.psm_periodic_tau;
+}
+
+/* requested active time (T3324), 8 bit string as in 3GPP 27.007 */
+char *Modem_Umi_CfgGetPsmActiveTime(void)
+{
+    return (char *)modem_configuration.psm_active_time;
+}
+
+/* requested eDRX cycle, 4 bit string as in 3GPP 27.007 */
+char *Modem_Umi_CfgGetEdrxValue(void)
+{
+    return (char *)modem_configuration.edrx_value;
+}
+
 void Modem_Umi_ModemIdentification(const char *model, size_t model_len)
 {
     (void)Store_WriteMember(UMI_CODE_MODEM_SIM_INFO, UMI_STRUCT_MODEM_SIM_INFO_MODEL, model, (uint16_t)model_len);
@@ -198,6 +238,31 @@ void Modem_Umi_ProductSerialNumberIdentification(const char *imei, size_t imei_l
     (void)Store_WriteMember(UMI_CODE_MODEM_SIM_INFO, UMI_STRUCT_MODEM_SIM_INFO_IMEI, imei, (uint16_t)imei_len);
 }
 
+/*!
+ * \brief Reads back the identity written by the functions above
+ *
+ * \return true if all values were stored, else none of them is taken
+ */
+bool Modem_Umi_RestoreIdentity(struct modem_info_s *info)
+{
+    bool complete = Modem_Umi_ReadSimInfoStr(UMI_STRUCT_MODEM_SIM_INFO_MODEL, info->model, sizeof(info->model));
+
+    complete = Modem_Umi_ReadSimInfoStr(UMI_STRUCT_MODEM_SIM_INFO_SW_RELEASE, info->SW_release, sizeof(info->SW_release)) && complete;
+    complete = Modem_Umi_ReadSimInfoStr(UMI_STRUCT_MODEM_SIM_INFO_FSN, info->fsn, sizeof(info->fsn)) && complete;
+    complete = Modem_Umi_ReadSimInfoStr(UMI_STRUCT_MODEM_SIM_INFO_IMEI, info->imei, sizeof(info->imei)) && complete;
+    complete = Modem_Umi_ReadSimInfoStr(UMI_STRUCT_MODEM_SIM_INFO_ICCID, info->ICCID, sizeof(info->ICCID)) && complete;
+
+    if (complete == false)
+    {
+        info->model[0] = 0;
+        info->SW_release[0] = 0;
+        info->fsn[0] = 0;
+        info->imei[0] = 0;
+        info->ICCID[0] = 0;
+    }
+    return complete;
+}
+
 void Modem_Umi_WriteICCID(const char *iccid, size_t iccid_len)
 {
     (void)Store_WriteMember(UMI_CODE_MODEM_SIM_INFO, UMI_STRUCT_MODEM_SIM_INFO_ICCID, iccid, (uint16_t)iccid_len);
@@ -333,6 +398,42 @@ void Modem_Umi_RestoreStats(void *statistics, uint16_t len)
     }
 }
 
+void Modem_Umi_StoreAtLatency(const void *latency, size_t len)
+{
+    (void)Store_WriteObject(UMI_CODE_MODEM_AT_LATENCY, latency, (uint16_t)len);
+}
+
+void Modem_Umi_RestoreAtLatency(void *latency, uint16_t len)
+{
+    uint16_t dataUsed = len;
+    egm_error_t err = Store_ReadObject(UMI_CODE_MODEM_AT_LATENCY, latency, &dataUsed);
+    if (err != EGM_ERR_OK)
+    {
+        MODEM_PRINTF_ERROR("Error reading UMI_CODE_MODEM_AT_LATENCY (err: %u)\n", err);
+    }
+    if (dataUsed != len)
+    {
+        MODEM_PRINTF_ERROR("Error reading UMI_CODE_MODEM_AT_LATENCY (datalen mismatch)\n");
+    }
+}
+
+void Modem_Umi_StoreCfgFingerprint(const void *fingerprint, size_t len)
+{
+    (void)Store_WriteObject(UMI_CODE_MODEM_CFG_FINGERPRINT, fingerprint, (uint16_t)len);
+}
+
+/*!
+ * \brief Reads the fingerprint of the last verified configuration
+ *
+ * \return false if none was stored yet
+ */
+bool Modem_Umi_RestoreCfgFingerprint(void *fingerprint, uint16_t len)
+{
+    uint16_t dataUsed = len;
+
+    return (Store_ReadObject(UMI_CODE_MODEM_CFG_FINGERPRINT, fingerprint, &dataUsed) == EGM_ERR_OK) && (dataUsed == len);
+}
+
 umi_modem_cfg_native_object_t *Modem_Umi_GetCfg(void)
 {
     return &modem_configuration;
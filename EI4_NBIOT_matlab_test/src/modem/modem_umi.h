@@ -61,6 +61,7 @@ void Modem_Umi_ModemIdentification(const char *model, size_t model_len);
 void Modem_Umi_FactorySerialNumber(const char *fsn, size_t fsn_len);
 void Modem_Umi_ProductSerialNumberIdentification(const char *imei, size_t imei_len);
 void Modem_Umi_RevisionIdentification(const char *model, size_t model_len);
+bool Modem_Umi_RestoreIdentity(struct modem_info_s *info);
 void Modem_Umi_WriteActiveLTEBands(uint8_t rat, const char *bnd_bitmap, size_t bnd_bitmap_len);
 void Modem_Umi_WriteStatus(int8_t status);
 
@@ -68,11 +69,20 @@ uint8_t Modem_Umi_CfgGetRat1(void);
 uint8_t Modem_Umi_CfgGetRat2(void);
 uint8_t Modem_Umi_CfgGetRat3(void);
 
+uint8_t Modem_Umi_CfgGetPsmMode(void);
+char *Modem_Umi_CfgGetPsmPeriodicTau(void);
+char *Modem_Umi_CfgGetPsmActiveTime(void);
+char *Modem_Umi_CfgGetEdrxValue(void);
+
 uint16_t Modem_Umi_CfgGetWaitForRegistrationTimeout(void);
 uint16_t Modem_Umi_CfgGetCommunicationSessionTimeout(void);
 
 void Modem_Umi_StoreStats(void *statistics, size_t len);
 void Modem_Umi_RestoreStats(void *statistics, uint16_t len);
+void Modem_Umi_StoreAtLatency(const void *latency, size_t len);
+void Modem_Umi_RestoreAtLatency(void *latency, uint16_t len);
+void Modem_Umi_StoreCfgFingerprint(const void *fingerprint, size_t len);
+bool Modem_Umi_RestoreCfgFingerprint(void *fingerprint, uint16_t len);
 
 
 #endif /* SRC_APP_MODEM_MODEM_UMI_H_ */
@@ -4,3 +4,5 @@ SCHED_ENTRY_FOO(SCHED_MODEM_NEXT_ACTION, Modem_NextAction)
 SCHED_ENTRY_FOO(SCHED_MODEM_AT_TIMEOUT, Modem_At_Timeout)
 SCHED_ENTRY_FOO(SCHED_MODEM_RTS_CHANGED, Modem_RtsChanged)
 SCHED_ENTRY_FOO(SCHED_MODEM_CTS_CHANGED, Modem_CtsCheck)
+SCHED_ENTRY_FOO(SCHED_MODEM_WATCHDOG, Modem_Watchdog)
+SCHED_ENTRY_FOO(SCHED_LPUART_TX_DONE, LpuartTxDoneSched)
@@ -67,6 +67,13 @@ extern Rtc_DateTime_t Rtc_GetDateTime(void);
  * \date        05.02.2015
  */
 extern egm_uint32_t Rtc_GetUptimeSeconds(void);
+/**
+ * \brief  Returns the number of milliseconds since program start.
+ *
+ * \return      The number of milliseconds, wraps after 49 days.
+ * \protective_interface
+ */
+extern egm_uint32_t Rtc_GetUptimeMs(void);
 
 
 #ifdef __cplusplus
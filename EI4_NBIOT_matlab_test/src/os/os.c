@@ -15,9 +15,22 @@
 #include <os/timer.h>
 
 #include <stdio.h>
+#include <string.h>
+
+#include <store/umi_codes.h>
 
 #include <test_modem_app.h>
 
+/* the store keeps the members of MODEM_SIM_INFO and the MODEM_CFG_FINGERPRINT
+   object, everything else is dropped */
+#define STORE_SIM_INFO_MEMBERS 9U
+#define STORE_MEMBER_SIZE 32U
+
+static egm_uint8_t store_sim_info[STORE_SIM_INFO_MEMBERS][STORE_MEMBER_SIZE];
+static egm_uint16_t store_sim_info_len[STORE_SIM_INFO_MEMBERS];
+static egm_uint8_t store_cfg_fingerprint[128];
+static egm_uint16_t store_cfg_fingerprint_len = 0U;
+
 
 void Loop_DelayUs(egm_uint16_t delay)
 {
@@ -27,7 +40,7 @@ void Loop_DelayUs(egm_uint16_t delay)
 void Sched_SetEvent(
     Sched_Event_t event)
 {
-
+	test_env_sched_event(event);
 }
 
 void Timer_StartOnce(
@@ -43,6 +56,7 @@ void Timer_StartOnce(
         break;
     case 2:
         printf("Call MODEM_AT_TIMEOUT after %dms\n", periodMs);
+        test_env_timer_at_timeout(true);
         break;
     default:
         break;
@@ -60,6 +74,10 @@ void Timer_StartRecurring(
         printf("Call MODEM_NEXT_ACTION \n");
         test_env_timer_modem_next_action();
         break;
+    case 5:
+        printf("Call MODEM_WATCHDOG \n");
+        test_env_timer_modem_watchdog();
+        break;
     case 2:
         printf("Call MODEM_AT_TIMEOUT after %dms", periodMs);
         break;
@@ -71,7 +89,10 @@ void Timer_StartRecurring(
 void Timer_Stop(
     Sched_Event_t timer)
 {
-    
+    if (timer == 2)
+    {
+        test_env_timer_at_timeout(false);
+    }
 }
 
 egm_bool_t Timer_IsRunning(
@@ -88,7 +109,12 @@ Rtc_DateTime_t Rtc_GetDateTime(void)
 
 egm_uint32_t Rtc_GetUptimeSeconds(void)
 {
-	return 0;
+	return test_env_uptime_s();
+}
+
+egm_uint32_t Rtc_GetUptimeMs(void)
+{
+	return test_env_uptime_ms();
 }
 
 egm_error_t Gds_ReadAll(
@@ -144,6 +170,14 @@ egm_error_t Store_ReadObject(
     void *data,
     egm_uint16_t *pLength)
 {
+	if (code == UMI_CODE_MODEM_CFG_FINGERPRINT)
+	{
+		if (*pLength > store_cfg_fingerprint_len)
+		{
+			*pLength = store_cfg_fingerprint_len;
+		}
+		memcpy(data, store_cfg_fingerprint, *pLength);
+	}
 	return EGM_ERR_OK;
 }
 
@@ -154,8 +188,17 @@ egm_error_t Store_ReadMember(
     egm_uint16_t length,
     egm_uint16_t *dataUsed)
 {
-	
-	
+	if ((code == UMI_CODE_MODEM_SIM_INFO) && (memberIdx < STORE_SIM_INFO_MEMBERS))
+	{
+		egm_uint16_t n = store_sim_info_len[memberIdx];
+
+		if (n > length)
+		{
+			n = length;
+		}
+		memcpy(data, store_sim_info[memberIdx], n);
+		*dataUsed = n;
+	}
 	return EGM_ERR_OK;
 }
 
@@ -164,6 +207,11 @@ egm_error_t Store_WriteObject(
     const void *data,
     egm_uint16_t length)
 {
+	if ((code == UMI_CODE_MODEM_CFG_FINGERPRINT) && (length <= sizeof(store_cfg_fingerprint)))
+	{
+		memcpy(store_cfg_fingerprint, data, length);
+		store_cfg_fingerprint_len = length;
+	}
 	return EGM_ERR_OK;
 }
 
@@ -173,15 +221,24 @@ egm_error_t Store_WriteMember(
     const void *data,
     egm_uint16_t length)
 {
+	if ((code == UMI_CODE_MODEM_SIM_INFO) && (memberIdx < STORE_SIM_INFO_MEMBERS))
+	{
+		if (length > STORE_MEMBER_SIZE)
+		{
+			length = STORE_MEMBER_SIZE;
+		}
+		memcpy(store_sim_info[memberIdx], data, length);
+		store_sim_info_len[memberIdx] = length;
+	}
 	return EGM_ERR_OK;
 }
 
 void Modem_UpdPkgRecvdInd(void)
 {
-
+	test_env_rx_frame_ind();
 }
 
 void Modem_ReadyToSendInd(void)
 {
-
+	test_env_ready_to_send();
 }
@@ -19,6 +19,15 @@ System level includes
 
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 /*-----------------------------------------------------------------------------
 Project level includes
@@ -31,10 +40,20 @@ Project level includes
 #include <os/loop.h>
 #include <os/rtc.h>
 #include <os/utils.h>
+#include <os/gds.h>
+
+#include <store/umi_codes.h>
+#include <store/umi_metadata.h>
 
 #include <mex.h>
 #include <modem/modem.h>
 #include <modem/modem_umi.h>
+#include <modem/modem_hal.h>
+#include <modem/modem_at.h>
+#include <modem/modem_stats.h>
+#include <modem/modem_log.h>
+#include <modem/modem_latency.h>
+#include <modem/modem_cmd.h>
 #include <os/rtc.h>
 /*-----------------------------------------------------------------------------
 Local includes
@@ -42,15 +61,72 @@ Local includes
 //#include<unistd.h>
 
 static char last_tx_at_command[2048];
+static bool test_tx_quiet = false; /* benchmarks keep the tx trace out of the timing */
+static uint8_t last_tx_raw[4096];
+static uint32_t test_tx_count = 0U; /* transmissions, raw or AT, the session simulator answers each */
+static bool test_tx_last_raw = false;
+static size_t last_tx_raw_len = 0U;
+
+#define TEST_BENCHMARK_RX_LEN 4096U
+#define TEST_EOF_FRAME_LEN_MAX 256U
+#define TEST_EOF_PATTERN "--EOF--Pattern--"
+#define TEST_EOF_PATTERN_LEN (sizeof(TEST_EOF_PATTERN) - 1U)
+#define TEST_STREAM_LEN_MAX 16384U
+#define TEST_RING_BURST_LEN 16U
+
+/* payload collected by the streaming rx callback */
+static uint8_t test_stream_buf[TEST_STREAM_LEN_MAX];
+static size_t test_stream_len = 0U;
+static uint32_t test_stream_last = 0U;
+
+/* sequence check of the payload streamed through the uart rx ring */
+static uint32_t test_ring_seq = 0U;
+static uint32_t test_ring_errors = 0U;
+
+/* host side decoder of the modem log, built from the same list as the ids */
+#define MODEM_LOG_ENTRY(id, fmt) fmt,
+static const char *const test_log_formats[MODEM_LOG_ID_COUNT] = {
+#include <modem_log_entries.h>
+};
+#undef MODEM_LOG_ENTRY
+
+struct test_ring_producer_s {
+    uint32_t payloadLen;
+    uint32_t baud;
+    volatile bool done;
+};
+
+/* HL7810 responses recorded during startup, none of them changes the modem state */
+static const char *const test_trace_hl7810[] = {
+    "HL7810.4.6.9.4\r\n",
+    "+KGSN: D13062105213B1\r\n",
+    "354720510148914\r\n",
+    "+CGDCONT: 1,\"IPV4V6\",\"internet.cxn\",,0,0,0,0,0,,0,,,,\r\n",
+    "+CGDCONT: 2,\"IPV4V6\",,,0,0,0,0,0,,0,,,,\r\n",
+    "+KBNDCFG: 0,000000000000000A0A188E\r\n",
+    "+KBNDCFG: 1,0000000000000000080084\r\n",
+    "+KBNDCFG: 2,0\r\n",
+    "+KSELACQ: 0,2,1\r\n",
+    "+CFUN: 4\r\n",
+    "+KBND: 1,0000000000000000000080\r\n",
+    "+CCID: +491747365135\r\n",
+    "+CESQ: 99,99,255,255,20,39\r\n",
+    "+WDSI: 0\r\n",
+    "+KUDPCFG: 1\r\n",
+    "+KTCPSTAT: 1,3,-1,0,0\r\n",
+};
 
 
 /*static void sleepFunction(int seconds){
     sleep(seconds);
 
 }*/
+static bool test_session_done = false;
+
 static void Modem_cmdStartCb(egm_error_t result)
 {
     printf("Comm session done with result %d\n", result);
+    test_session_done = true;
 }
 
 void test_env_timer_modem_next_action(void) {
@@ -58,19 +134,378 @@ void test_env_timer_modem_next_action(void) {
     Modem_NextAction();
 }
 
+void test_env_timer_modem_watchdog(void) {
+    printf("***** Simulate OS Timer Call to MODEM_WATCHDOG\n");
+    Modem_Watchdog();
+}
+
 void test_env_rx_from_modem(char *rxStr) {
     printf("## Rx Message from Modem: %s \n", rxStr);
-    LpuartRxSched(rxStr, strlen(rxStr));
+    Modem_Hal_RxIsr((const uint8_t *)rxStr, strlen(rxStr));
+    /* the scheduler runs SCHED_LPUART_RX */
+    LpuartRxSched();
 }
 
 void test_env_tx_to_modem(char *txStr) {
     strcpy(last_tx_at_command, txStr);
-    printf("## Tx Message to Modem: %s \n", last_tx_at_command);
+    test_tx_count++;
+    test_tx_last_raw = false;
+    if (!test_tx_quiet) {
+        printf("## Tx Message to Modem: %s \n", last_tx_at_command);
+    }
+}
+
+/* gathers the parts of a raw transmission */
+void test_env_tx_raw_to_modem(const struct modem_hal_txv_s *v, unsigned char n) {
+    last_tx_raw_len = 0U;
+    for (unsigned char i = 0U; i < n; i++) {
+        if (last_tx_raw_len + v[i].len <= sizeof(last_tx_raw)) {
+            memcpy(&last_tx_raw[last_tx_raw_len], v[i].buf, v[i].len);
+            last_tx_raw_len += v[i].len;
+        }
+    }
+    test_tx_count++;
+    test_tx_last_raw = true;
+    printf("## Raw Tx to Modem: %u bytes in %u parts\n", (unsigned)last_tx_raw_len, n);
+}
+
+/* host uart model, a held transmission is moved by 'uart_tx_drain' */
+static bool test_uart_tx_hold = false;
+static bool test_at_timeout_running = false;
+
+void test_env_timer_at_timeout(bool running) {
+    test_at_timeout_running = running;
+}
+
+/* moves up to bytes bytes like the tx interrupt does */
+static uint32_t test_env_uart_tx_drain(size_t bytes) {
+    bool busy = Modem_Hal_TxBusy();
+    size_t n = Modem_Hal_TxIsr(bytes);
+
+    if (busy && !Modem_Hal_TxBusy()) {
+        /* the scheduler runs SCHED_LPUART_TX_DONE */
+        LpuartTxDoneSched();
+    }
+    return (uint32_t)n;
+}
+
+void test_env_uart_tx_kick(void) {
+    if (!test_uart_tx_hold) {
+        (void)test_env_uart_tx_drain(SIZE_MAX);
+    }
 }
 
 static bool test_eval_last_tx_at_command(char* expected_txStr) {
     return (strncmp(last_tx_at_command, expected_txStr, strlen(expected_txStr)) == 0);
 }
+/*
+ * Feeds a response line and compares the modemInfo fields it fills, printed
+ * as a comma separated list, with the expected string
+ */
+static bool test_eval_modem_info(const char *rsp, const char *fields, const char *expected) {
+    char line[256];
+    char actual[256] = "";
+
+    snprintf(line, sizeof(line), "%s\n", rsp);
+    test_env_rx_from_modem(line);
+
+    if (strcmp(fields, "cesq") == 0) {
+        snprintf(actual, sizeof(actual), "%u,%u,%u,%u,%u,%u", modemInfo.cesq.rxlev, modemInfo.cesq.ber, modemInfo.cesq.rscp,
+                 modemInfo.cesq.ecno, modemInfo.cesq.rsrq, modemInfo.cesq.rsrp);
+    }
+    else if (strcmp(fields, "prl") == 0) {
+        snprintf(actual, sizeof(actual), "%u,%u,%u", modemInfo.prl[0], modemInfo.prl[1], modemInfo.prl[2]);
+    }
+    else if (strcmp(fields, "bnd") == 0) {
+        snprintf(actual, sizeof(actual), "%u,%s", modemInfo.rat, modemInfo.bnd);
+    }
+    else if (strcmp(fields, "bnd_bitmap") == 0) {
+        snprintf(actual, sizeof(actual), "%s,%s,%s", modemInfo.bnd_bitmap[0], modemInfo.bnd_bitmap[1], modemInfo.bnd_bitmap[2]);
+    }
+    else if (strcmp(fields, "identity") == 0) {
+        snprintf(actual, sizeof(actual), "%s,%s,%s,%s", modemInfo.model, modemInfo.SW_release, modemInfo.fsn, modemInfo.imei);
+    }
+    else if (strcmp(fields, "pdp_context") == 0) {
+        snprintf(actual, sizeof(actual), "%s,%s,%s,%s", modemInfo.pdp_context[0].cid, modemInfo.pdp_context[0].PDP_type,
+                 modemInfo.pdp_context[0].APN, modemInfo.pdp_context[0].PDP_addr);
+    }
+    printf("modemInfo.%s: %s\n", fields, actual);
+    return strcmp(actual, expected) == 0;
+}
+/*
+ * Sends a +CESQ line padded to lineLen bytes followed by a valid one, in
+ * chunks of chunkLen bytes. Lines longer than the AT line buffer must be
+ * discarded and counted, the line behind must be parsed.
+ */
+static bool test_eval_at_line_overflow(size_t lineLen, size_t chunkLen, uint32_t expDiscarded) {
+    static char rx[2048];
+    static const char head[] = "+CESQ: 11,0,0,0,0,";
+    static const char next[] = "+CESQ: 12,1,2,3,4,5\r\n";
+    uint32_t discarded = Modem_Stats_GetAtRxLinesDiscarded();
+    size_t len;
+
+    if ((lineLen < sizeof(head) + 1U) || (lineLen + sizeof(next) > sizeof(rx))) {
+        return false;
+    }
+    memcpy(rx, head, sizeof(head) - 1U);
+    memset(&rx[sizeof(head) - 1U], '9', lineLen - (sizeof(head) - 1U) - 2U);
+    memcpy(&rx[lineLen - 2U], "\r\n", 2U);
+    memcpy(&rx[lineLen], next, sizeof(next) - 1U);
+    len = lineLen + sizeof(next) - 1U;
+
+    for (size_t i = 0U; i < len; i += chunkLen) {
+        Modem_Hal_RxBlockInd((const uint8_t *)&rx[i], (len - i < chunkLen) ? len - i : chunkLen);
+    }
+    return (modemInfo.cesq.rxlev == 12U) && (modemInfo.cesq.rsrp == 5U) && (Modem_Stats_GetAtRxLinesDiscarded() - discarded == expDiscarded);
+}
+static uint8_t test_at_queue_results[32];
+static uint8_t test_at_queue_done = 0U;
+
+static void test_env_at_cmd_done(enum modem_at_result_e result) {
+    if (test_at_queue_done < sizeof(test_at_queue_results)) {
+        test_at_queue_results[test_at_queue_done] = (uint8_t)result;
+    }
+    test_at_queue_done++;
+}
+
+/*
+ * Sends count commands while the first one waits for its response, then
+ * completes them with OK, ERROR and a final timeout. Each completion has to
+ * send the next queued command and report its result to the callback.
+ */
+static bool test_eval_at_queue(uint32_t count, uint32_t expDropped) {
+    static const char *rsp[] = { "OK\r\n", "ERROR\r\n" };
+    uint32_t dropped = Modem_Stats_GetAtCmdsDropped();
+    uint32_t queued = 0U;
+    char cmd[16];
+    char expected[20];
+    bool ok = (Modem_At_Busy() == false) && (count < sizeof(test_at_queue_results));
+
+    test_at_queue_done = 0U;
+    ok = ok && Modem_At_SendCmdCb("+CGSN", MODEM_AT_TIMEOUT_TIME_MS, test_env_at_cmd_done);
+    for (uint32_t n = 1U; n <= count; n++) {
+        snprintf(cmd, sizeof(cmd), "+KGSN=%u", n);
+        if (Modem_At_SendCmdCb(cmd, MODEM_AT_TIMEOUT_TIME_MS, test_env_at_cmd_done)) {
+            queued++;
+        }
+    }
+    ok = ok && test_eval_last_tx_at_command("AT+CGSN\r") && (Modem_At_QueuedCmds() == queued);
+    ok = ok && (Modem_Stats_GetAtCmdsDropped() - dropped == expDropped);
+
+    for (uint32_t n = 1U; n <= queued; n++) {
+        test_env_rx_from_modem((char *)rsp[(n - 1U) % 2U]);
+        snprintf(expected, sizeof(expected), "AT+KGSN=%u\r", n);
+        ok = ok && test_eval_last_tx_at_command(expected) && (test_at_queue_done == n);
+    }
+    Modem_At_Timeout();
+
+    ok = ok && (test_at_queue_done == queued + 1U) && (Modem_At_Busy() == false);
+    for (uint32_t n = 0U; ok && (n < queued); n++) {
+        ok = (test_at_queue_results[n] == ((n % 2U == 0U) ? modem_at_result_ok : modem_at_result_error));
+    }
+    return ok && (test_at_queue_results[queued] == modem_at_result_timeout);
+}
+/*
+ * A command built from the longest configuration value, a 127 character
+ * remote address, is sent in full, directly and from the AT queue
+ */
+static bool test_eval_long_cmd(void) {
+    char host[128];
+    char expected[MODEM_AT_CMD_LEN_MAX + 3U];
+    bool ok = (Modem_At_Busy() == false);
+
+    memset(host, 'h', sizeof(host) - 1U);
+    host[sizeof(host) - 1U] = '\0';
+    Modem_Cmd_TcpConnectionConfiguration("", host, 65535U);
+    snprintf(expected, sizeof(expected), "AT+KTCPCFG=1,0,\"%s\",65535\r", host);
+    ok = ok && test_eval_last_tx_at_command(expected);
+
+    Modem_Cmd_TcpConnectionConfiguration("", host, 1U);
+    ok = ok && (Modem_At_QueuedCmds() == 1U);
+    test_env_rx_from_modem("OK\r\n");
+    snprintf(expected, sizeof(expected), "AT+KTCPCFG=1,0,\"%s\",1\r", host);
+    ok = ok && test_eval_last_tx_at_command(expected);
+    test_env_rx_from_modem("OK\r\n");
+    return ok && (Modem_At_Busy() == false);
+}
+static uint32_t test_uptime_ms = 0U;
+static uint32_t test_uptime_s = 0U;
+
+unsigned int test_env_uptime_ms(void) {
+    return test_uptime_ms;
+}
+
+unsigned int test_env_uptime_s(void) {
+    return test_uptime_s;
+}
+
+/* uplink frames the app queues on Modem_ReadyToSendInd(), one empty frame for the first session */
+#define TEST_TX_FRAMES_MAX 8U
+
+struct test_tx_frame_s {
+    uint8_t data[64];
+    uint16_t len;
+    uint32_t payload_len; /* > 0: fragmented payload from test_tx_payload */
+    uint8_t priority;
+    uint32_t lifetime_s;
+};
+
+static struct test_tx_frame_s test_tx_frames[TEST_TX_FRAMES_MAX] = { { { 0U }, 0U, 0U, MODEM_TX_PRIORITY_NORMAL, 0U } };
+static uint8_t test_tx_payload[4096];
+static uint8_t test_tx_frame_count = 1U;
+static char test_tx_done[64];
+/* release assistance the app requests with its frames */
+static enum modem_tx_release_e test_tx_release = modem_tx_release_none;
+
+static void test_env_tx_frame_done(uint16_t tag, enum modem_tx_result_e result) {
+    size_t len = strlen(test_tx_done);
+
+    static const char *const names[] = { "sent", "expired", "failed" };
+
+    printf("tx frame %u %s\n", tag, names[result]);
+    snprintf(&test_tx_done[len], sizeof(test_tx_done) - len, "%s%u%c", (len > 0U) ? "," : "", tag, names[result][0]);
+}
+
+/* downlink frame the app got last, byte n holds n modulo 251 like the simulated reply */
+static uint16_t test_rx_frame_len = 0U;
+static bool test_rx_frame_ok = false;
+
+void test_env_rx_frame_ind(void) {
+    const uint8_t *rx;
+    uint16_t len = 0U;
+
+    test_rx_frame_ok = Modem_PeekRxFrame(&rx, &len);
+    for (uint16_t n = 0U; test_rx_frame_ok && (n < len); n++) {
+        test_rx_frame_ok = (rx[n] == (uint8_t)(n % 251U));
+    }
+    test_rx_frame_len = len;
+}
+
+void test_env_ready_to_send(void) {
+    for (uint8_t i = 0U; i < test_tx_frame_count; i++) {
+        struct test_tx_frame_s *f = &test_tx_frames[i];
+
+        if (f->payload_len > 0U) {
+            (void)Modem_QueueTxPayload(test_tx_payload, f->payload_len, f->priority, f->lifetime_s, test_env_tx_frame_done, i);
+        }
+        else {
+            (void)Modem_QueueTxFrameEx(f->data, f->len, f->priority, f->lifetime_s, test_env_tx_frame_done, i);
+        }
+    }
+    test_tx_frame_count = 0U;
+    Modem_SetTxRelease(test_tx_release);
+}
+
+/*
+ * Answers count commands after latency_ms each and checks the timeout the
+ * AT layer derives for the command class. A response slower than the armed
+ * timeout is a timeout. Starts and ends with an empty history, so the other
+ * tests keep the default timeouts.
+ */
+static bool test_eval_at_latency(const char *cmd, uint32_t latency_ms, uint32_t count, uint32_t expTimeout) {
+    bool ok = (Modem_At_Busy() == false);
+    uint32_t answered = 0U;
+
+    Modem_Latency_Init();
+    for (uint32_t n = 0U; ok && (n < count); n++) {
+        uint32_t armed = Modem_Latency_Timeout(cmd);
+
+        ok = Modem_At_SendCmdCb(cmd, MODEM_AT_TIMEOUT_ADAPTIVE, test_env_at_cmd_done);
+        if (latency_ms < armed) {
+            test_uptime_ms += latency_ms;
+            test_env_rx_from_modem("OK\r\n");
+            answered++;
+        } else {
+            test_uptime_ms += armed;
+            Modem_At_Timeout();
+        }
+    }
+    ok = ok && (Modem_At_Busy() == false);
+    ok = ok && ((answered < count) || (Modem_Latency_Ewma(cmd) == latency_ms));
+    ok = ok && ((answered > 0U) || (Modem_Latency_Ewma(cmd) == 0U));
+    printf("latency %s: p99 %u ms, timeout %u ms\n", cmd, Modem_Latency_P99(cmd), Modem_Latency_Timeout(cmd));
+    ok = ok && (Modem_Latency_Timeout(cmd) == expTimeout);
+    Modem_Latency_Init();
+    return ok;
+}
+/* prints the records logged by the driver since the last call */
+static void test_log_dump(void) {
+    uint16_t id;
+    uint8_t argc;
+    uint32_t args[MODEM_LOG_ARGS_MAX] = { 0U };
+
+    while (Modem_Log_Read(&id, &argc, args)) {
+        if (id < MODEM_LOG_ID_COUNT) {
+            printf(test_log_formats[id], args[0], args[1], args[2], args[3]);
+        }
+        else {
+            printf("unknown modem log id %u\n", id);
+        }
+    }
+}
+
+/*
+ * Logs more records than the ring holds and checks that the most recent ones
+ * are read back complete and in order
+ */
+static bool test_eval_log(uint32_t records) {
+    uint32_t dropped;
+    uint32_t expected;
+    uint32_t next = 0U;
+    uint16_t id;
+    uint8_t argc;
+    uint32_t args[MODEM_LOG_ARGS_MAX];
+    bool ok = true;
+
+    test_log_dump();
+    dropped = Modem_Log_Dropped();
+    for (uint32_t n = 0U; n < records; n++) {
+        MODEM_LOG2(MODEM_LOG_RETRY_CHECK, n, ~n);
+    }
+    /* a record takes a header and two argument words */
+    expected = (records < MODEM_LOG_RING_WORDS / 3U) ? records : MODEM_LOG_RING_WORDS / 3U;
+    next = records - expected;
+    while (Modem_Log_Read(&id, &argc, args)) {
+        ok = ok && (id == MODEM_LOG_RETRY_CHECK) && (argc == 2U) && (args[0] == next) && (args[1] == ~next);
+        next++;
+    }
+    return ok && (next == records) && (Modem_Log_Dropped() - dropped == records - expected);
+}
+
+/*
+ * Compares recording a message in the log with formatting it, returns the
+ * speedup of the log
+ */
+static double test_benchmark_log(uint32_t iterations) {
+    char text[128];
+    volatile size_t sink = 0U;
+    uint16_t id;
+    uint8_t argc;
+    uint32_t args[MODEM_LOG_ARGS_MAX];
+    clock_t start;
+    double logSec, fmtSec;
+
+    start = clock();
+    for (uint32_t n = 0U; n < iterations; n++) {
+        MODEM_LOG3(MODEM_LOG_NEXT_ACTION, n & 0xFU, 0x3U, 29U);
+    }
+    logSec = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    start = clock();
+    for (uint32_t n = 0U; n < iterations; n++) {
+        sink += (size_t)snprintf(text, sizeof(text), test_log_formats[MODEM_LOG_NEXT_ACTION], n & 0xFU, 0x3U, 29U);
+    }
+    fmtSec = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    /* the benchmark records are not of interest */
+    while (Modem_Log_Read(&id, &argc, args)) {
+    }
+    if ((logSec <= 0.0) || (fmtSec <= 0.0)) {
+        return 0.0;
+    }
+    printf("log record: %.1f ns, formatted: %.1f ns\n", logSec * 1e9 / iterations, fmtSec * 1e9 / iterations);
+    return fmtSec / logSec;
+}
 /*static void test_set_Wait_For_Response(){
     modem.wait_for_rsp= true;
    
@@ -79,60 +514,1207 @@ static void test_env_switch_modem_on(void) {
     Modem_Init();
     bool request_to_send = true;
     Modem_StartProcess(Modem_cmdStartCb, request_to_send);
-    test_env_timer_modem_next_action();
+    test_env_timer_modem_watchdog();
     test_env_hal_set_Cts(true);
     //Rtc_GetUptimeSeconds()== 21;
-    test_env_timer_modem_next_action();
+    test_env_timer_modem_watchdog();
     test_env_hal_set_Cts(false);
-    test_env_timer_modem_next_action();
+    test_env_timer_modem_watchdog();
     test_env_hal_set_Cts(true);
+    test_env_timer_modem_watchdog();
+}
+/*
+ * The modem does not answer the AT probe. The timer ticks in between
+ * must not queue more probes, the AT timeout paces the next one.
+ */
+static bool test_eval_at_probe(uint32_t ticks) {
+    uint32_t sent;
+    bool ok;
+
+    test_env_switch_modem_on();
+    sent = test_tx_count;
+    ok = test_eval_last_tx_at_command("AT");
+    for (uint32_t n = 0U; n < ticks; n++) {
+        test_env_timer_modem_next_action();
+    }
+    ok = ok && (test_tx_count == sent) && (Modem_At_QueuedCmds() == 0U);
+    Modem_At_Timeout();
     test_env_timer_modem_next_action();
+    printf("at probes: %u\n", test_tx_count - sent + 1U);
+    ok = ok && (test_tx_count == sent + 1U) && (Modem_At_QueuedCmds() == 0U);
+    /* the last probe times out as well, the AT layer is left idle */
+    Modem_At_Timeout();
+    return ok && (Modem_At_Busy() == false);
 }
+
 static void test_modem_reset(void){
-    test_env_timer_modem_next_action();
+    test_env_timer_modem_watchdog();
     test_env_hal_set_Cts(false);
-    test_env_timer_modem_next_action();
+    test_env_timer_modem_watchdog();
     test_env_hal_set_Cts(true);
-    test_env_timer_modem_next_action();
+    test_env_timer_modem_watchdog();
+}
+static size_t test_hex_to_bin(const char *hex, uint8_t *bin, size_t maxLen)
+{
+    size_t len = 0U;
+    unsigned int byte;
+
+    while ((len < maxLen) && (sscanf(&hex[2U * len], "%2x", &byte) == 1)) {
+        bin[len++] = (uint8_t)byte;
+    }
+    return len;
+}
+
+/* switches the AT parser into raw data mode the same way the modem does */
+static void test_env_start_raw_rx(uint16_t len)
+{
+    char cmd[32];
+
+    snprintf(cmd, sizeof(cmd), "AT+KUDPRCV=1,%u\r", len);
+    Modem_Hal_RxBlockInd((const uint8_t *)cmd, strlen(cmd));
+    Modem_Hal_RxBlockInd((const uint8_t *)"CONNECT\r", 8U);
+}
+
+/*
+ * Feeds a raw frame (hex, starting with the \n behind CONNECT) in chunks of
+ * chunkLen bytes and checks the payload reported in front of the EOF pattern
+ */
+static bool test_eval_eof_frame(const char *frameHex, const char *expHex, size_t chunkLen)
+{
+    uint8_t frame[TEST_EOF_FRAME_LEN_MAX];
+    uint8_t exp[TEST_EOF_FRAME_LEN_MAX];
+    const uint8_t *rx;
+    uint16_t rxLen = 0U;
+    bool rcvd;
+    size_t frameLen = test_hex_to_bin(frameHex, frame, sizeof(frame));
+    size_t expLen = test_hex_to_bin(expHex, exp, sizeof(exp));
+
+    Modem_ReleaseRxFrame();
+    /* the requested length only matters for the mismatch trace, 0 would not switch to raw mode */
+    test_env_start_raw_rx((uint16_t)frameLen);
+
+    for (size_t i = 0U; i < frameLen; i += chunkLen) {
+        Modem_Hal_RxBlockInd(&frame[i], (frameLen - i < chunkLen) ? frameLen - i : chunkLen);
+    }
+    rcvd = Modem_PeekRxFrame(&rx, &rxLen);
+    if (rcvd && (rxLen == expLen) && (memcmp(rx, exp, expLen) != 0)) {
+        rcvd = false;
+    }
+    Modem_ReleaseRxFrame();
+
+    return !Modem_At_WaitsForData() && (rcvd == (expLen > 0U)) && (rxLen == expLen) && !Modem_PeekRxFrame(&rx, &rxLen);
+}
+
+static void test_env_stage_tx_frame(const char *hex, uint8_t priority, uint32_t lifetime_s) {
+    struct test_tx_frame_s *f = &test_tx_frames[test_tx_frame_count];
+
+    if (test_tx_frame_count < TEST_TX_FRAMES_MAX) {
+        f->len = (uint16_t)test_hex_to_bin(hex, f->data, sizeof(f->data));
+        f->payload_len = 0U;
+        f->priority = priority;
+        f->lifetime_s = lifetime_s;
+        test_tx_frame_count++;
+        test_tx_done[0] = '\0';
+    }
+}
+
+/* compares the frame the application gets with the expected text */
+static bool test_eval_rx_frame(const char *expected) {
+    const uint8_t *rx;
+    uint16_t rxLen = 0U;
+    bool rcvd = Modem_PeekRxFrame(&rx, &rxLen);
+
+    printf("rx frame (%u): %.*s\n", rxLen, (int)rxLen, rcvd ? (const char *)rx : "");
+    return rcvd && (rxLen == strlen(expected)) && (memcmp(rx, expected, rxLen) == 0);
+}
+
+/* stages a payload of len bytes that is sent in fragments, byte n holds n modulo 251 */
+static void test_env_stage_tx_payload(uint32_t len, uint8_t priority) {
+    if ((len <= sizeof(test_tx_payload)) && (test_tx_frame_count < TEST_TX_FRAMES_MAX)) {
+        for (uint32_t n = 0U; n < len; n++) {
+            test_tx_payload[n] = (uint8_t)(n % 251U);
+        }
+        test_env_stage_tx_frame("", priority, 0U);
+        test_tx_frames[test_tx_frame_count - 1U].payload_len = len;
+    }
+}
+
+/* checks header, payload slice and EOF pattern of the last transmitted fragment */
+static bool test_eval_tx_fragment(uint32_t index, uint32_t count, uint32_t payloadLen) {
+    uint32_t pos = index * MODEM_TX_FRAGMENT_PAYLOAD_LEN;
+    uint32_t len = payloadLen - pos;
+    bool ok;
+
+    if (len > MODEM_TX_FRAGMENT_PAYLOAD_LEN) {
+        len = MODEM_TX_FRAGMENT_PAYLOAD_LEN;
+    }
+    ok = (last_tx_raw_len == MODEM_TX_FRAGMENT_HDR_LEN + len + TEST_EOF_PATTERN_LEN);
+    ok = ok && (last_tx_raw[0] == MODEM_TX_FRAGMENT_MARKER) && (last_tx_raw[2] == index) && (last_tx_raw[3] == count);
+    ok = ok && (memcmp(&last_tx_raw[MODEM_TX_FRAGMENT_HDR_LEN], &test_tx_payload[pos], len) == 0);
+    return ok && (memcmp(&last_tx_raw[MODEM_TX_FRAGMENT_HDR_LEN + len], TEST_EOF_PATTERN, TEST_EOF_PATTERN_LEN) == 0);
+}
+
+/* a frame starting with the fragment marker is refused, it would look like a fragment */
+static bool test_eval_tx_frame_rejected(const char *hex) {
+    uint8_t frame[64];
+    size_t len = test_hex_to_bin(hex, frame, sizeof(frame));
+    uint8_t queued = Modem_TxFramesQueued();
+
+    return !Modem_QueueTxFrameEx(frame, (uint16_t)len, MODEM_TX_PRIORITY_NORMAL, 0U, NULL, 0U) && (Modem_TxFramesQueued() == queued);
+}
+
+/* completions reported since the frames were staged, e.g. "1s,2e,3f" for tag 1 sent, tag 2 expired and tag 3 failed */
+static bool test_eval_tx_done(const char *expected) {
+    printf("tx frames done: %s\n", test_tx_done);
+    return (strcmp(test_tx_done, expected) == 0) && (Modem_TxFramesQueued() == 0U);
+}
+
+/*
+ * Sends a payload (hex) the way Modem_Cmd_SendUdpPacket() does and checks
+ * that the payload and the EOF pattern go out in one gathered transmission
+ */
+static bool test_eval_raw_tx(const char *payloadHex)
+{
+    static uint8_t payload[TEST_EOF_FRAME_LEN_MAX];
+    static const char eof[] = "--EOF--Pattern--";
+    size_t len = test_hex_to_bin(payloadHex, payload, sizeof(payload));
+    char cmd[48];
+    bool ok = (Modem_At_Busy() == false);
+
+    test_at_queue_done = 0U;
+    last_tx_raw_len = 0U;
+    Modem_At_QueuePacket(NULL, 0U, payload, (uint16_t)len);
+    snprintf(cmd, sizeof(cmd), "+KUDPSND=1,\"199.64.78.128\",4154,%u", (unsigned)len);
+    ok = ok && Modem_At_SendCmdCb(cmd, MODEM_AT_TIMEOUT_ADAPTIVE, test_env_at_cmd_done);
+    Modem_At_ReqSend((uint16_t)len);
+    test_env_rx_from_modem("CONNECT\r\n");
+
+    ok = ok && (last_tx_raw_len == len + strlen(eof)) && (memcmp(last_tx_raw, payload, len) == 0);
+    ok = ok && (memcmp(&last_tx_raw[len], eof, strlen(eof)) == 0);
+
+    test_env_rx_from_modem("OK\r\n");
+    return ok && (test_at_queue_done == 1U) && (test_at_queue_results[0] == modem_at_result_ok) && !Modem_At_Busy();
+}
+
+static void test_env_rx_chunk_cb(const uint8_t *p, size_t len, bool last)
+{
+    if ((test_stream_last > 0U) || (test_stream_len + len > sizeof(test_stream_buf))) {
+        /* chunk behind the last one or too much data, fails the check */
+        test_stream_last = 0xFFFFU;
+        return;
+    }
+    memcpy(&test_stream_buf[test_stream_len], p, len);
+    test_stream_len += len;
+    test_stream_last += last ? 1U : 0U;
+}
+
+/*
+ * Streams a raw frame (starting with the \n behind CONNECT) in chunks of
+ * chunkLen bytes and checks the payload, the final chunk and that not more
+ * than a partial EOF pattern is held back after each chunk
+ */
+static bool test_eval_eof_stream(const uint8_t *frame, size_t frameLen, const uint8_t *exp, size_t expLen, size_t chunkLen)
+{
+    const uint8_t *rx;
+    uint16_t rxLen;
+    bool heldOk = true;
+
+    test_stream_len = 0U;
+    test_stream_last = 0U;
+    Modem_SetRxChunkCb(test_env_rx_chunk_cb);
+    test_env_start_raw_rx((uint16_t)frameLen);
+
+    for (size_t i = 0U; i < frameLen; i += chunkLen) {
+        size_t fed = (frameLen - i < chunkLen) ? frameLen : i + chunkLen;
+        size_t payloadFed = (fed - 1U < expLen) ? fed - 1U : expLen;
+
+        Modem_Hal_RxBlockInd(&frame[i], fed - i);
+        if (test_stream_len + TEST_EOF_PATTERN_LEN - 1U < payloadFed) {
+            heldOk = false;
+        }
+    }
+    Modem_SetRxChunkCb(NULL);
+
+    return heldOk && !Modem_At_WaitsForData() && (test_stream_len == expLen) && (memcmp(test_stream_buf, exp, expLen) == 0) &&
+           (test_stream_last == ((expLen > 0U) ? 1U : 0U)) && !Modem_PeekRxFrame(&rx, &rxLen);
+}
+
+static bool test_eval_eof_stream_hex(const char *frameHex, const char *expHex, size_t chunkLen)
+{
+    uint8_t frame[TEST_EOF_FRAME_LEN_MAX];
+    uint8_t exp[TEST_EOF_FRAME_LEN_MAX];
+    size_t frameLen = test_hex_to_bin(frameHex, frame, sizeof(frame));
+    size_t expLen = test_hex_to_bin(expHex, exp, sizeof(exp));
+
+    return test_eval_eof_stream(frame, frameLen, exp, expLen, chunkLen);
+}
+
+/*
+ * Streams a frame larger than the raw rx buffer, the payload is full of
+ * partial EOF patterns
+ */
+static bool test_eval_eof_stream_large(size_t payloadLen, size_t chunkLen)
+{
+    static const char filler[] = "--EOF--Patter-";
+    static uint8_t frame[1U + TEST_STREAM_LEN_MAX + TEST_EOF_PATTERN_LEN];
+
+    if (payloadLen > TEST_STREAM_LEN_MAX) {
+        return false;
+    }
+    frame[0] = '\n';
+    for (size_t i = 0U; i < payloadLen; i++) {
+        frame[1U + i] = ((i % 64U) < 32U) ? (uint8_t)filler[i % (sizeof(filler) - 1U)] : (uint8_t)i;
+    }
+    memcpy(&frame[1U + payloadLen], TEST_EOF_PATTERN, TEST_EOF_PATTERN_LEN);
+
+    return test_eval_eof_stream(frame, 1U + payloadLen + TEST_EOF_PATTERN_LEN, &frame[1], payloadLen, chunkLen);
+}
+
+/*
+ * Receives 4 KB raw frames whose payload is full of partial EOF patterns and
+ * returns the raw data throughput in bytes/s
+ */
+static double test_benchmark_eof(uint32_t iterations)
+{
+    static const char filler[] = "--EOF--Patter-";
+    static uint8_t frame[TEST_BENCHMARK_RX_LEN];
+    size_t payloadLen = sizeof(frame) - 1U - TEST_EOF_PATTERN_LEN;
+    clock_t start;
+    double sec;
+
+    frame[0] = '\n';
+    for (size_t i = 0U; i < payloadLen; i++) {
+        frame[1U + i] = (uint8_t)filler[i % (sizeof(filler) - 1U)];
+    }
+    memcpy(&frame[1U + payloadLen], TEST_EOF_PATTERN, TEST_EOF_PATTERN_LEN);
+
+    start = clock();
+    for (uint32_t n = 0U; n < iterations; n++) {
+        test_env_start_raw_rx((uint16_t)payloadLen);
+        Modem_Hal_RxBlockInd(frame, sizeof(frame));
+    }
+    sec = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    if (sec <= 0.0) {
+        return 0.0;
+    }
+    printf("raw rx 4 KB frames: %.0f bytes/s\n", (double)sizeof(frame) * iterations / sec);
+    return (double)sizeof(frame) * iterations / sec;
+}
+
+static double test_wall_clock(void)
+{
+    struct timespec ts;
+
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* lets the other thread run on a single core host */
+static void test_thread_yield(void)
+{
+#ifdef _WIN32
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+static void test_env_rx_seq_cb(const uint8_t *p, size_t len, bool last)
+{
+    for (size_t i = 0U; i < len; i++) {
+        if (p[i] != (uint8_t)test_ring_seq) {
+            test_ring_errors++;
+        }
+        test_ring_seq++;
+    }
+    test_stream_last += last ? 1U : 0U;
+}
+
+/*
+ * Plays the uart rx interrupt: pushes a raw frame with a sequence payload in
+ * bursts of TEST_RING_BURST_LEN bytes. With a baud rate the bursts are paced
+ * to the line speed (10 bit per byte) and never wait for the consumer,
+ * without one each burst waits for space in the ring.
+ */
+static void test_ring_produce(struct test_ring_producer_s *prod)
+{
+    uint8_t burst[TEST_RING_BURST_LEN];
+    uint32_t total = 1U + prod->payloadLen + (uint32_t)TEST_EOF_PATTERN_LEN;
+    uint32_t sent = 0U;
+    double start = test_wall_clock();
+
+    while (sent < total) {
+        size_t n = (total - sent < TEST_RING_BURST_LEN) ? total - sent : TEST_RING_BURST_LEN;
+
+        if (prod->baud > 0U) {
+            while ((test_wall_clock() - start) * prod->baud < (double)(sent + n) * 10.0) {
+                test_thread_yield();
+            }
+        }
+        else {
+            while (Modem_Hal_RxRingFree() < n) {
+                test_thread_yield();
+            }
+        }
+        for (size_t k = 0U; k < n; k++) {
+            uint32_t pos = sent + (uint32_t)k;
+
+            if (pos == 0U) {
+                burst[k] = '\n';
+            }
+            else if (pos <= prod->payloadLen) {
+                burst[k] = (uint8_t)(pos - 1U);
+            }
+            else {
+                burst[k] = (uint8_t)TEST_EOF_PATTERN[pos - 1U - prod->payloadLen];
+            }
+        }
+        Modem_Hal_RxIsr(burst, n);
+        sent += (uint32_t)n;
+    }
+    prod->done = true;
+}
+
+#ifdef _WIN32
+static DWORD WINAPI test_ring_producer_thread(LPVOID arg)
+{
+    test_ring_produce((struct test_ring_producer_s *)arg);
+    return 0;
+}
+#else
+static void *test_ring_producer_thread(void *arg)
+{
+    test_ring_produce((struct test_ring_producer_s *)arg);
+    return NULL;
+}
+#endif
+
+/*
+ * Streams a raw frame through the uart rx ring, produced by a second thread
+ * and drained by this one as the scheduler would. Returns the byte rate, 0
+ * if a byte was lost or corrupted.
+ */
+static double test_benchmark_rx_ring(uint32_t payloadLen, uint32_t baud)
+{
+    struct test_ring_producer_s prod = { payloadLen, baud, false };
+    uint32_t overflows = Modem_Hal_RxRingOverflows();
+    double start, sec;
+#ifdef _WIN32
+    HANDLE thread;
+#else
+    pthread_t thread;
+#endif
+
+    test_ring_seq = 0U;
+    test_ring_errors = 0U;
+    test_stream_last = 0U;
+    Modem_SetRxChunkCb(test_env_rx_seq_cb);
+    test_env_start_raw_rx((uint16_t)payloadLen);
+
+    start = test_wall_clock();
+#ifdef _WIN32
+    thread = CreateThread(NULL, 0, test_ring_producer_thread, &prod, 0, NULL);
+#else
+    pthread_create(&thread, NULL, test_ring_producer_thread, &prod);
+#endif
+    while (!prod.done) {
+        LpuartRxSched();
+        test_thread_yield();
+    }
+#ifdef _WIN32
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    pthread_join(thread, NULL);
+#endif
+    LpuartRxSched();
+    sec = test_wall_clock() - start;
+    Modem_SetRxChunkCb(NULL);
+
+    printf("rx ring at %u baud: %.0f bytes/s, high water %u of %u, %u bytes lost\n", baud,
+           (double)payloadLen / sec, Modem_Hal_RxRingHighWater(), MODEM_HAL_RX_RING_SIZE, Modem_Hal_RxRingOverflows() - overflows);
+    if ((test_ring_errors > 0U) || (test_ring_seq != payloadLen) || (test_stream_last != 1U) ||
+        (Modem_Hal_RxRingOverflows() != overflows) || Modem_At_WaitsForData() || (sec <= 0.0)) {
+        return 0.0;
+    }
+    return (double)payloadLen / sec;
+}
+
+/*
+ * Feeds the same 4 KB of URC lines through the per-char and the block rx
+ * path and returns the speedup of the block path
+ */
+static double test_benchmark_rx(uint32_t iterations)
+{
+    static const char line[] = "+CESQ: 99,99,255,255,20,39\r\n";
+    static uint8_t rxBuf[TEST_BENCHMARK_RX_LEN];
+    size_t len = 0U;
+    clock_t start;
+    double charSec, blockSec;
+
+    while (len + sizeof(line) - 1U <= sizeof(rxBuf)) {
+        memcpy(&rxBuf[len], line, sizeof(line) - 1U);
+        len += sizeof(line) - 1U;
+    }
+
+    start = clock();
+    for (uint32_t n = 0U; n < iterations; n++) {
+        for (size_t i = 0U; i < len; i++) {
+            Modem_Hal_CharRxIndCb((char)rxBuf[i]);
+        }
+    }
+    charSec = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    start = clock();
+    for (uint32_t n = 0U; n < iterations; n++) {
+        Modem_Hal_RxBlockInd(rxBuf, len);
+    }
+    blockSec = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    if (charSec <= 0.0 || blockSec <= 0.0) {
+        return 0.0;
+    }
+    printf("rx per char: %.0f bytes/s\n", (double)len * iterations / charSec);
+    printf("rx block   : %.0f bytes/s\n", (double)len * iterations / blockSec);
+    return charSec / blockSec;
+}
+
+/*
+ * Feeds the recorded HL7810 trace through the rx path and returns the
+ * number of parsed lines per second
+ */
+static double test_benchmark_urc(uint32_t iterations)
+{
+    static uint8_t rxBuf[TEST_BENCHMARK_RX_LEN];
+    size_t len = 0U;
+    uint32_t lines = 0U;
+    clock_t start;
+    double sec;
+
+    for (size_t i = 0U; i < sizeof(test_trace_hl7810) / sizeof(test_trace_hl7810[0]); i++) {
+        size_t n = strlen(test_trace_hl7810[i]);
+        memcpy(&rxBuf[len], test_trace_hl7810[i], n);
+        len += n;
+        lines++;
+    }
+
+    start = clock();
+    for (uint32_t n = 0U; n < iterations; n++) {
+        Modem_Hal_RxBlockInd(rxBuf, len);
+    }
+    sec = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    if (sec <= 0.0) {
+        return 0.0;
+    }
+    printf("urc dispatch: %.0f lines/s\n", (double)lines * iterations / sec);
+    return (double)lines * iterations / sec;
+}
+
+/* builds and transmits a mix of AT commands, each is ended by the AT timeout */
+static double test_benchmark_at_cmd(uint32_t iterations)
+{
+    uint32_t cmds = 0U;
+    clock_t start;
+    double sec;
+
+    /* ends what the previous tests left pending */
+    Modem_At_FlushQueue();
+    for (uint32_t n = 0U; Modem_At_Busy() && (n < 4U); n++) {
+        Modem_At_Timeout();
+    }
+    if (Modem_At_Busy()) {
+        return 0.0;
+    }
+    test_tx_quiet = true;
+    start = clock();
+    for (uint32_t n = 0U; n < iterations; n++) {
+        Modem_Cmd_SetPhoneFunctionality(1, 1);
+        Modem_At_Timeout();
+        Modem_Cmd_ConfigurePreferredRadioAccessTechnologyList(2, 1, 0);
+        Modem_At_Timeout();
+        Modem_Cmd_UdpCloseSession(1);
+        Modem_At_Timeout();
+        (void)Modem_Cmd_AtGetData(1024, "UDP", NULL);
+        Modem_At_Timeout();
+        Modem_Cmd_ReadExtendedSignalQuality(NULL);
+        Modem_At_Timeout();
+        cmds += 5U;
+    }
+    sec = (double)(clock() - start) / CLOCKS_PER_SEC;
+    test_tx_quiet = false;
+
+    if (sec <= 0.0) {
+        return 0.0;
+    }
+    printf("at commands: %.0f ns/cmd (%s)\n", sec * 1e9 / cmds, last_tx_at_command);
+    return cmds / sec;
 }
+
+/*
+ * Session simulator: a scripted HL7810 answers the driver while the time and
+ * the charge drawn by the modem are accounted. The driver runs unchanged, the
+ * scheduler events and the watchdog are emulated, the watchdog advances the
+ * time in steps of one second like on the target.
+ *
+ * The currents and durations are assumed typical values for an HL7810 on
+ * NB-IoT in normal coverage, not measurements. The comparison only depends on
+ * which phases the driver goes through and for how long.
+ */
+#define TEST_SIM_I_OFF_MA           0.001 /* powered off by AT+CPOF */
+#define TEST_SIM_I_PSM_MA           0.003 /* hibernate, still attached */
+#define TEST_SIM_I_BOOT_MA          20.0
+#define TEST_SIM_I_AWAKE_MA         8.0   /* radio off, uart active */
+#define TEST_SIM_I_ATTACH_MA        60.0  /* cell search and attach */
+#define TEST_SIM_I_TX_MA            120.0
+#define TEST_SIM_I_CONNECTED_MA     35.0  /* RRC connected until the inactivity timer expires */
+#define TEST_SIM_I_IDLE_DRX_MA      1.0   /* idle, paging every 2.56 s */
+#define TEST_SIM_I_IDLE_EDRX_MA     0.1
+#define TEST_SIM_T_BOOT_S           2.5
+#define TEST_SIM_T_ATTACH_S         8.0
+#define TEST_SIM_T_DETACH_S         1.5
+#define TEST_SIM_T_TX_S             1.0
+#define TEST_SIM_T_RRC_INACTIVITY_S 10.0
+#define TEST_SIM_T_RAI_REPLY_S      1.0   /* single downlink reply before the release */
+#define TEST_SIM_T_WAKE_S           0.05
+#define TEST_SIM_T_AT_S             0.02
+#define TEST_SIM_T_TAU_S            2.0   /* periodic TAU while in PSM, at TEST_SIM_I_ATTACH_MA */
+#define TEST_SIM_TAU_PERIOD_S       21600U /* "00100110", 6 h */
+#define TEST_SIM_STEPS_MAX          2000U
+
+enum test_sim_power_e {
+    test_sim_power_off,
+    test_sim_power_booting,
+    test_sim_power_awake,
+    test_sim_power_psm,
+};
+
+struct test_sim_s {
+    enum test_sim_power_e power;
+    double t_s;
+    double charge_mas;
+    double ready_s;         /* end of the boot or the wake up */
+    double attached_s;      /* registration completes, < 0: not attaching */
+    double rrc_release_s;   /* end of the RRC connection after the last uplink */
+    double uplink_s;        /* first uplink confirmed in the session, < 0: none yet */
+    bool attached;
+    bool psm_requested;
+    bool psm_denied;        /* the network does not grant PSM */
+    bool no_network;        /* the modem never registers */
+    bool tx_rejected;       /* the modem answers AT+KUDPSND with ERROR */
+    bool edrx_requested;
+    bool wake_up;           /* WAKE_UP pin */
+    uint8_t fun;
+    uint32_t cfun_cmds;     /* AT+CFUN=, AT+CPOF and AT+CPSMS= sent in the session */
+    uint32_t cpof_cmds;
+    uint32_t psm_cmds;
+    uint32_t rai_cmds;      /* AT+KUDPSND with release assistance */
+    uint8_t rai;            /* of the uplink in progress */
+    uint16_t downlink_len;  /* reply to the first uplink of a session, 0: none */
+    uint16_t downlink_pos;  /* bytes of the reply read so far */
+    bool downlink_sent;
+    double downlink_s;      /* end of the last read of the reply */
+    uint32_t cesq_cmds;     /* AT+CESQ sent after the reply was announced */
+};
+
+static struct test_sim_s test_sim;
+static bool test_sim_active = false;
+static uint16_t test_sim_registration_timeout = 0U;
+static bool test_sched_next_action = false;
+
+/* defined in modem_umi.c, the harness writes the PSM configuration */
+umi_modem_cfg_native_object_t *Modem_Umi_GetCfg(void);
+
+void test_env_sched_event(unsigned int event) {
+    if (event == SCHED_MODEM_NEXT_ACTION) {
+        test_sched_next_action = true;
+    }
+}
+
+void test_env_hal_reset(bool high) {
+    if (test_sim_active && high) {
+        test_sim.power = test_sim_power_booting;
+        test_sim.ready_s = test_sim.t_s + TEST_SIM_T_BOOT_S;
+        test_sim.attached = false;
+        test_sim.attached_s = -1.0;
+        test_sim.fun = 4U;
+        test_env_hal_set_Cts(true);
+    }
+}
+
+void test_env_hal_wake_up(bool high) {
+    if (!test_sim_active) {
+        return;
+    }
+    test_sim.wake_up = high;
+    if (high && (test_sim.power == test_sim_power_psm)) {
+        test_sim.power = test_sim_power_booting;
+        test_sim.ready_s = test_sim.t_s + TEST_SIM_T_WAKE_S;
+    }
+}
+
+/* modem current in the current phase */
+static double test_sim_current_ma(void) {
+    switch (test_sim.power) {
+    case test_sim_power_off:
+        return TEST_SIM_I_OFF_MA;
+    case test_sim_power_psm:
+        return TEST_SIM_I_PSM_MA;
+    case test_sim_power_booting:
+        return TEST_SIM_I_BOOT_MA;
+    default:
+        break;
+    }
+    if (test_sim.attached_s >= 0.0) {
+        return TEST_SIM_I_ATTACH_MA;
+    }
+    if (!test_sim.attached) {
+        return TEST_SIM_I_AWAKE_MA;
+    }
+    if (test_sim.t_s < test_sim.rrc_release_s) {
+        return TEST_SIM_I_CONNECTED_MA;
+    }
+    return test_sim.edrx_requested ? TEST_SIM_I_IDLE_EDRX_MA + TEST_SIM_I_AWAKE_MA : TEST_SIM_I_IDLE_DRX_MA + TEST_SIM_I_AWAKE_MA;
+}
+
+static void test_sim_spend(double s, double ma) {
+    test_sim.t_s += s;
+    test_sim.charge_mas += s * ma;
+    test_uptime_ms = (uint32_t)(test_sim.t_s * 1000.0);
+    test_uptime_s = (uint32_t)test_sim.t_s;
+}
+
+/* boot, wake up, attach and PSM entry complete in the background */
+static void test_sim_modem_events(void) {
+    if ((test_sim.power == test_sim_power_booting) && (test_sim.t_s >= test_sim.ready_s)) {
+        test_sim.power = test_sim_power_awake;
+        test_env_hal_set_Cts(false);
+        if ((test_sim.fun == 1U) && !test_sim.no_network) {
+            test_sim.attached_s = test_sim.ready_s + TEST_SIM_T_ATTACH_S;
+        }
+    }
+    if ((test_sim.power == test_sim_power_awake) && (test_sim.attached_s >= 0.0) && (test_sim.t_s >= test_sim.attached_s)) {
+        test_sim.attached_s = -1.0;
+        test_sim.attached = true;
+        test_env_rx_from_modem("+CEREG: 1,\"DAD9\",\"01AF8F0D\",9\r\n");
+    }
+    /* the modem hibernates once the active timer expired, 2 s as configured */
+    if ((test_sim.power == test_sim_power_awake) && test_sim.attached && test_sim.psm_requested && !test_sim.psm_denied && !test_sim.wake_up &&
+        (test_sim.t_s >= test_sim.rrc_release_s + 2.0)) {
+        test_sim.power = test_sim_power_psm;
+        test_env_hal_set_Cts(true);
+    }
+}
+
+/* raw data of AT+KUDPRCV: the \n behind CONNECT, the next len bytes of the reply and the EOF pattern */
+static void test_sim_downlink(uint16_t len) {
+    static uint8_t raw[1U + MODEM_RX_READ_SIZE_MAX + TEST_EOF_PATTERN_LEN];
+
+    if (len > test_sim.downlink_len - test_sim.downlink_pos) {
+        len = test_sim.downlink_len - test_sim.downlink_pos;
+    }
+    if (len > MODEM_RX_READ_SIZE_MAX) {
+        len = MODEM_RX_READ_SIZE_MAX;
+    }
+    raw[0] = '\n';
+    for (uint16_t n = 0U; n < len; n++) {
+        raw[1U + n] = (uint8_t)((test_sim.downlink_pos + n) % 251U);
+    }
+    memcpy(&raw[1U + len], TEST_EOF_PATTERN, TEST_EOF_PATTERN_LEN);
+    test_sim.downlink_pos += len;
+    test_sim.downlink_s = test_sim.t_s;
+
+    Modem_Hal_RxBlockInd((const uint8_t *)"CONNECT\r", 8U);
+    Modem_Hal_RxBlockInd(raw, 1U + len + TEST_EOF_PATTERN_LEN);
+}
+
+static void test_sim_answer_part(const char *p, char *final) {
+    char line[64];
+
+    if (strcmp(p, "I") == 0) {
+        test_env_rx_from_modem("HL7810\r\n");
+    }
+    else if (strcmp(p, "+CGMR") == 0) {
+        test_env_rx_from_modem("HL7810.4.6.9.4\r\n");
+    }
+    else if (strcmp(p, "+KGSN=3") == 0) {
+        test_env_rx_from_modem("+KGSN: D13062105213B1\r\n");
+    }
+    else if (strcmp(p, "+CGSN") == 0) {
+        test_env_rx_from_modem("354720510148914\r\n");
+    }
+    else if (strcmp(p, "+CGDCONT?") == 0) {
+        test_env_rx_from_modem("+CGDCONT: 1,\"IPV4V6\",\"'internet.cxn'\",,0,0,0,0,0,,0,,,,\r\n");
+    }
+    else if (strcmp(p, "+KBNDCFG?") == 0) {
+        test_env_rx_from_modem("+KBNDCFG: 0,000000000000000A0A188E\r\n");
+        test_env_rx_from_modem("+KBNDCFG: 1,0000000000000000080084\r\n");
+        test_env_rx_from_modem("+KBNDCFG: 2,0\r\n");
+    }
+    else if (strcmp(p, "+KSELACQ?") == 0) {
+        test_env_rx_from_modem("+KSELACQ: 2,1,0\r\n");
+    }
+    else if (strcmp(p, "+CEREG?") == 0) {
+        test_env_rx_from_modem(test_sim.attached ? "+CEREG: 2,1\r\n" : "+CEREG: 2,0\r\n");
+    }
+    else if (strcmp(p, "+CFUN?") == 0) {
+        snprintf(line, sizeof(line), "+CFUN: %u\r\n", test_sim.fun);
+        test_env_rx_from_modem(line);
+    }
+    else if (strcmp(p, "+KBND?") == 0) {
+        test_env_rx_from_modem("+KBND: 1,0000000000000000000080\r\n");
+    }
+    else if (strcmp(p, "+CCID") == 0) {
+        test_env_rx_from_modem("+CCID: +491747365135\r\n");
+    }
+    else if (strcmp(p, "+CESQ") == 0) {
+        test_sim.cesq_cmds += test_sim.downlink_sent ? 1U : 0U;
+        test_env_rx_from_modem("+CESQ: 99,99,255,255,20,39\r\n");
+    }
+    else if (strncmp(p, "+KUDPCFG=", 9) == 0) {
+        test_env_rx_from_modem("+KUDPCFG: 1\r\n");
+        strcpy(final, "OK\r\n+KCNX_IND: 1,1,0\r\n+KUDP_IND: 1,1\r\n");
+    }
+    else if (strncmp(p, "+KUDPSND=", 9) == 0) {
+        /* session, address, port, length and the optional rai */
+        const char *rai = p;
+
+        for (int i = 0; (i < 4) && (rai != NULL); i++) {
+            rai = strchr(rai + 1, ',');
+        }
+        test_sim.rai = (rai != NULL) ? (uint8_t)atoi(rai + 1) : 0U;
+        test_sim.rai_cmds += (test_sim.rai > 0U) ? 1U : 0U;
+        strcpy(final, test_sim.tx_rejected ? "ERROR\r\n" : "CONNECT\r\n");
+    }
+    else if (strncmp(p, "+KUDPRCV=", 9) == 0) {
+        test_sim_downlink((uint16_t)atoi(strchr(p, ',') + 1));
+    }
+    else if (strcmp(p, "+CFUN=1,1") == 0) {
+        test_sim.fun = 1U;
+        test_sim.cfun_cmds++;
+    }
+    else if (strcmp(p, "+CFUN=4,1") == 0) {
+        test_sim.fun = 4U;
+        test_sim.cfun_cmds++;
+        strcpy(final, "OK\r\n+CEREG: 0\r\n+KCNX_IND: 1,0,0\r\n");
+    }
+    else if (strcmp(p, "+CPOF") == 0) {
+        test_sim.cpof_cmds++;
+    }
+    else if (strncmp(p, "+CPSMS=1", 8) == 0) {
+        test_sim.psm_requested = true;
+        test_sim.psm_cmds++;
+    }
+    else if (strncmp(p, "+CEDRXS=1", 9) == 0) {
+        test_sim.edrx_requested = true;
+    }
+    else if (strcmp(p, "+CEDRXS=0") == 0) {
+        test_sim.edrx_requested = false;
+    }
+}
+
+/* answers the last command, restarts and detaches take effect after the OK */
+static void test_sim_answer(void) {
+    char cmd[sizeof(last_tx_at_command)];
+    char echo[sizeof(last_tx_at_command) + 2U];
+    char final[64] = "OK\r\n";
+    char *p;
+
+    if (test_tx_last_raw) {
+        /* uplink over the air, the RRC connection stays until the inactivity
+           timer or the release the modem asked for */
+        test_sim_spend(TEST_SIM_T_TX_S, TEST_SIM_I_TX_MA);
+        if (test_sim.rai == (uint8_t)modem_tx_release_no_reply) {
+            test_sim.rrc_release_s = test_sim.t_s;
+        }
+        else if (test_sim.rai == (uint8_t)modem_tx_release_single_reply) {
+            test_sim.rrc_release_s = test_sim.t_s + TEST_SIM_T_RAI_REPLY_S;
+        }
+        else {
+            test_sim.rrc_release_s = test_sim.t_s + TEST_SIM_T_RRC_INACTIVITY_S;
+        }
+        if (test_sim.uplink_s < 0.0) {
+            test_sim.uplink_s = test_sim.t_s;
+        }
+        test_env_rx_from_modem("OK\r\n");
+        if ((test_sim.downlink_len > 0U) && !test_sim.downlink_sent) {
+            snprintf(echo, sizeof(echo), "+KUDP_DATA: 1,%u\r\n", test_sim.downlink_len);
+            test_env_rx_from_modem(echo);
+            test_sim.downlink_sent = true;
+        }
+        return;
+    }
+
+    strcpy(cmd, last_tx_at_command);
+    cmd[strcspn(cmd, "\r\n")] = '\0';
+    if (strncmp(cmd, "AT", 2) != 0) {
+        return;
+    }
+    test_sim_spend(TEST_SIM_T_AT_S, test_sim_current_ma());
+    /* echo */
+    snprintf(echo, sizeof(echo), "%s\r\n", cmd);
+    test_env_rx_from_modem(echo);
+    /* the parts of a compound command, split in place */
+    p = &cmd[2];
+    while (*p != '\0') {
+        size_t len = strcspn(p, ";");
+        bool last = (p[len] == '\0');
+
+        p[len] = '\0';
+        if (len > 0U) {
+            test_sim_answer_part(p, final);
+        }
+        p = last ? &p[len] : &p[len + 1U];
+    }
+    test_env_rx_from_modem(final);
+
+    if (strstr(last_tx_at_command, "+CFUN=4,1") != NULL) {
+        test_sim_spend(TEST_SIM_T_DETACH_S, TEST_SIM_I_ATTACH_MA);
+        test_sim.attached = false;
+    }
+    if (strstr(last_tx_at_command, "+CFUN=") != NULL) {
+        test_sim.power = test_sim_power_booting;
+        test_sim.ready_s = test_sim.t_s + TEST_SIM_T_BOOT_S;
+        test_env_hal_set_Cts(true);
+    }
+    if (strncmp(cmd, "AT+CPOF", 7) == 0) {
+        test_sim.power = test_sim_power_off;
+        test_sim.attached = false;
+        test_env_hal_set_Cts(false);
+    }
+}
+
+/*
+ * Runs one session with the given number of uplink frames, returns the
+ * charge drawn in mAs or a negative value if the session did not end
+ */
+static double test_sim_session(double *uplink_s, uint8_t frames) {
+    uint32_t seen = test_tx_count;
+    double start_s = test_sim.t_s;
+    double start_mas = test_sim.charge_mas;
+
+    test_tx_frame_count = 0U;
+    for (uint8_t i = 0U; i < frames; i++) {
+        test_env_stage_tx_frame("00010001000A0102030405", MODEM_TX_PRIORITY_NORMAL, 0U);
+    }
+    test_sim.uplink_s = -1.0;
+    test_sim.cfun_cmds = 0U;
+    test_sim.cpof_cmds = 0U;
+    test_sim.psm_cmds = 0U;
+    test_sim.rai_cmds = 0U;
+    test_sim.downlink_pos = 0U;
+    test_sim.downlink_sent = false;
+    test_sim.cesq_cmds = 0U;
+    test_session_done = false;
+    Modem_StartProcess(Modem_cmdStartCb, true);
+
+    for (uint32_t steps = 0U; !test_session_done; steps++) {
+        if (steps >= TEST_SIM_STEPS_MAX) {
+            printf("simulated session did not end\n");
+            return -1.0;
+        }
+        test_sim_modem_events();
+        if (test_tx_count != seen) {
+            seen = test_tx_count;
+            test_sim_answer();
+        }
+        else if (test_sched_next_action) {
+            test_sched_next_action = false;
+            Modem_NextAction();
+        }
+        else {
+            test_sim_spend(1.0, test_sim_current_ma());
+            test_env_timer_modem_watchdog();
+        }
+    }
+    *uplink_s = test_sim.uplink_s - start_s;
+    return test_sim.charge_mas - start_mas;
+}
+
+/* PSM configuration of the next sessions, an empty eDRX value keeps the stored one */
+static void test_env_set_psm_mode(uint8_t mode, const char *tau, const char *active_time, const char *edrx) {
+    umi_modem_cfg_native_object_t *cfg = Modem_Umi_GetCfg();
+
+    cfg->psm_mode = mode;
+    snprintf((char *)cfg->psm_periodic_tau, sizeof(cfg->psm_periodic_tau), "%s", tau);
+    snprintf((char *)cfg->psm_active_time, sizeof(cfg->psm_active_time), "%s", active_time);
+    if (edrx[0] != '\0') {
+        snprintf((char *)cfg->edrx_value, sizeof(cfg->edrx_value), "%s", edrx);
+    }
+}
+
+/* switches the modem model in, the driver starts from a cold modem */
+static void test_sim_start(enum modem_psm_mode_e mode, bool psm_denied) {
+    umi_modem_cfg_native_object_t *cfg = Modem_Umi_GetCfg();
+
+    /* the harness configuration leaves the registration timeout at 0 */
+    test_sim_registration_timeout = cfg->wait_for_registration_timeout;
+    cfg->wait_for_registration_timeout = 60U;
+    /* periodic TAU 6 h, active time 2 s, eDRX 81.92 s */
+    test_env_set_psm_mode((uint8_t)mode, "00100110", "00000001", "0101");
+
+    memset(&test_sim, 0, sizeof(test_sim));
+    test_sim.attached_s = -1.0;
+    test_sim.rrc_release_s = -1.0;
+    test_sim.fun = 4U;
+    test_sim.psm_denied = psm_denied;
+    test_sim_active = true;
+    test_tx_quiet = true;
+
+    Modem_Init();
+}
+
+static void test_sim_stop(void) {
+    umi_modem_cfg_native_object_t *cfg = Modem_Umi_GetCfg();
+
+    test_tx_quiet = false;
+    test_sim_active = false;
+    cfg->psm_mode = (uint8_t)modem_psm_mode_off;
+    cfg->wait_for_registration_timeout = test_sim_registration_timeout;
+}
+
+/*
+ * Simulates a cold start session and a second session with the given PSM
+ * mode. Returns the charge per report in uAh, the second session plus the
+ * sleep until the next report, and the delay to its uplink in uplink_s.
+ */
+static double test_sim_report(enum modem_psm_mode_e mode, uint32_t interval_s, double *uplink_s) {
+    double charge_mas, sleep_s, start_s;
+
+    test_sim_start(mode, false);
+    charge_mas = test_sim_session(uplink_s, 1U);
+    start_s = test_sim.t_s;
+    if (charge_mas >= 0.0) {
+        charge_mas = test_sim_session(uplink_s, 1U);
+    }
+    if (charge_mas >= 0.0) {
+        sleep_s = (double)interval_s - (test_sim.t_s - start_s);
+        if (mode == modem_psm_mode_off) {
+            charge_mas += sleep_s * TEST_SIM_I_OFF_MA;
+        }
+        else {
+            /* each session restarts the periodic TAU timer */
+            charge_mas += sleep_s * TEST_SIM_I_PSM_MA + (double)(interval_s / TEST_SIM_TAU_PERIOD_S) * TEST_SIM_T_TAU_S * TEST_SIM_I_ATTACH_MA;
+        }
+    }
+    test_sim_stop();
+    return charge_mas / 3.6;
+}
+
+/*
+ * Two simulated sessions with PSM. The first one configures PSM and ends in
+ * PSM, the second one wakes the attached modem and sends without restarting
+ * the radio. If the network denies PSM the first session powers off.
+ */
+static bool test_eval_psm_session(bool psm_denied) {
+    double uplink_s;
+    bool ok;
+
+    test_sim_start(modem_psm_mode_psm, psm_denied);
+    ok = (test_sim_session(&uplink_s, 1U) >= 0.0) && (uplink_s > 0.0) && (test_sim.psm_cmds == 1U);
+    printf("session 1: %u cfun, %u cpof, power %d\n", test_sim.cfun_cmds, test_sim.cpof_cmds, (int)test_sim.power);
+    if (psm_denied) {
+        ok = ok && (test_sim.cpof_cmds == 1U) && (test_sim.power == test_sim_power_off);
+    }
+    else {
+        ok = ok && (test_sim.cfun_cmds == 1U) && (test_sim.cpof_cmds == 0U) && (test_sim.power == test_sim_power_psm);
+        ok = ok && (test_sim_session(&uplink_s, 1U) >= 0.0) && (uplink_s > 0.0) && (test_sim.psm_cmds == 0U);
+        printf("session 2: %u cfun, %u cpof, power %d\n", test_sim.cfun_cmds, test_sim.cpof_cmds, (int)test_sim.power);
+        ok = ok && (test_sim.cfun_cmds == 0U) && (test_sim.cpof_cmds == 0U) && (test_sim.power == test_sim_power_psm);
+    }
+    test_sim_stop();
+    return ok;
+}
+
+/*
+ * The network denies PSM, the driver waits for the modem to sleep as long as
+ * the requested active time plus a margin. Compares the session with the
+ * given active time (GPRS timer 2) to one without, true if it took expWait_s
+ * longer.
+ */
+static bool test_eval_psm_entry_wait(const char *active_time, uint32_t expWait_s) {
+    const char *times[2] = { "00000000", active_time };
+    double duration_s[2];
+    double uplink_s;
+
+    for (int i = 0; i < 2; i++) {
+        test_sim_start(modem_psm_mode_psm, true);
+        test_env_set_psm_mode((uint8_t)modem_psm_mode_psm, "00100110", times[i], "");
+        duration_s[i] = test_sim.t_s;
+        duration_s[i] = (test_sim_session(&uplink_s, 1U) >= 0.0) ? test_sim.t_s - duration_s[i] : -1.0;
+        test_sim_stop();
+    }
+    printf("PSM entry with active time %s: %.1f s longer\n", active_time, duration_s[1] - duration_s[0]);
+    return (duration_s[0] >= 0.0) && (duration_s[1] >= 0.0) && (fabs(duration_s[1] - duration_s[0] - (double)expWait_s) <= 2.0);
+}
+
+/*
+ * Compares the charge per report and the latency to the uplink of the power
+ * off cycle with PSM and PSM with eDRX, true if PSM is better in both
+ */
+static bool test_eval_psm_energy(uint32_t interval_s) {
+    static const char *const names[] = { "power off", "PSM", "PSM+eDRX" };
+    double uah[3], uplink_s[3];
+
+    for (int mode = (int)modem_psm_mode_off; mode <= (int)modem_psm_mode_psm_edrx; mode++) {
+        uah[mode] = test_sim_report((enum modem_psm_mode_e)mode, interval_s, &uplink_s[mode]);
+        printf("%-9s: %8.2f uAh per report every %u s, uplink after %5.2f s\n", names[mode], uah[mode], interval_s, uplink_s[mode]);
+    }
+    return (uah[modem_psm_mode_off] > 0.0) && (uah[modem_psm_mode_psm] > 0.0) && (uah[modem_psm_mode_psm_edrx] > 0.0) &&
+           (uah[modem_psm_mode_psm] < uah[modem_psm_mode_off]) && (uplink_s[modem_psm_mode_psm] < uplink_s[modem_psm_mode_off]);
+}
+
+/*
+ * Frames which cannot be sent are reported as failed: a frame the modem
+ * keeps rejecting at the end of its retries, frames without a network after
+ * MODEM_TX_SESSIONS_MAX sessions.
+ */
+static bool test_eval_tx_failed(void) {
+    double uplink_s;
+    bool ok;
+
+    test_sim_start(modem_psm_mode_off, false);
+    test_sim.tx_rejected = true;
+    ok = (test_sim_session(&uplink_s, 1U) >= 0.0);
+    printf("rejected: %s\n", test_tx_done);
+    ok = ok && (strcmp(test_tx_done, "0f") == 0) && (Modem_TxFramesQueued() == 0U);
+    test_sim_stop();
+
+    test_sim_start(modem_psm_mode_off, false);
+    /* queued up front, without a network the app is never asked */
+    test_sim.no_network = true;
+    test_tx_frame_count = 0U;
+    test_env_stage_tx_frame("0102", MODEM_TX_PRIORITY_NORMAL, 0U);
+    test_env_stage_tx_frame("0304", MODEM_TX_PRIORITY_NORMAL, 0U);
+    test_env_ready_to_send();
+    ok = ok && (Modem_TxFramesQueued() == 2U);
+    for (uint32_t n = 0U; ok && (n < MODEM_TX_SESSIONS_MAX); n++) {
+        ok = (test_tx_done[0] == '\0') && (Modem_TxFramesQueued() == 2U) && (test_sim_session(&uplink_s, 0U) >= 0.0);
+    }
+    printf("no network: %s\n", test_tx_done);
+    ok = ok && (strcmp(test_tx_done, "1f,0f") == 0) && (Modem_TxFramesQueued() == 0U);
+    test_sim_stop();
+    return ok;
+}
+
+/*
+ * The simulated modem replies to the uplink with a downlink of len bytes,
+ * read in chunks of readSize. The app gets the frame in one piece, a frame
+ * larger than MODEM_RX_READ_SIZE_MAX read in chunks is dropped. In both cases
+ * all bytes are read and the session ends.
+ */
+static bool test_eval_rx_downlink(uint16_t len, uint16_t readSize) {
+    bool delivered = (len <= MODEM_RX_READ_SIZE_MAX);
+    double uplink_s;
+    bool ok;
+
+    test_sim_start(modem_psm_mode_off, false);
+    test_sim.downlink_len = len;
+    test_rx_frame_len = 0U;
+    test_rx_frame_ok = false;
+    Modem_SetRxReadSize(readSize);
+    ok = (test_sim_session(&uplink_s, 1U) >= 0.0) && (test_sim.downlink_pos == len);
+    printf("downlink of %u bytes in chunks of %u: %u bytes received\n", len, readSize, test_rx_frame_len);
+    ok = ok && (delivered ? (test_rx_frame_ok && (test_rx_frame_len == len)) : (test_rx_frame_len == 0U));
+    Modem_SetRxReadSize(MODEM_RX_READ_SIZE_DEFAULT);
+    Modem_ReleaseRxFrame();
+    test_sim_stop();
+    return ok;
+}
+
+/*
+ * Release assistance on the last uplink. Two frames in a PSM session, only
+ * the second one asks for the release. Compares the charge per report with
+ * and without it, true if the release saves charge with PSM.
+ */
+static bool test_eval_tx_release(uint32_t interval_s) {
+    double uah[2][2], uplink_s;
+    bool ok;
+
+    test_sim_start(modem_psm_mode_psm, false);
+    test_tx_release = modem_tx_release_no_reply;
+    ok = (test_sim_session(&uplink_s, 2U) >= 0.0) && (test_sim.rai_cmds == 1U) && (test_sim.rai == (uint8_t)modem_tx_release_no_reply);
+    test_tx_release = modem_tx_release_none;
+    ok = ok && (test_sim_session(&uplink_s, 1U) >= 0.0) && (test_sim.rai_cmds == 0U);
+    test_sim_stop();
+
+    for (int release = 0; release < 2; release++) {
+        test_tx_release = (release > 0) ? modem_tx_release_no_reply : modem_tx_release_none;
+        uah[0][release] = test_sim_report(modem_psm_mode_off, interval_s, &uplink_s);
+        uah[1][release] = test_sim_report(modem_psm_mode_psm, interval_s, &uplink_s);
+        printf("release %d: power off %8.2f uAh, PSM %8.2f uAh per report every %u s\n", release, uah[0][release], uah[1][release], interval_s);
+    }
+    test_tx_release = modem_tx_release_none;
+
+    return ok && (uah[0][1] > 0.0) && (uah[0][1] <= uah[0][0]) && (uah[1][1] > 0.0) && (uah[1][1] < uah[1][0]);
+}
+
+/*
+ * Release assistance expecting a single reply. The session waits for the
+ * downlink instead of the response timeout, ends right after it and skips
+ * the signal quality read behind it.
+ */
+static bool test_eval_tx_release_reply(uint16_t len) {
+    umi_modem_cfg_native_object_t *cfg = Modem_Umi_GetCfg();
+    uint16_t rsp_timeout = cfg->wait_for_response_timeout;
+    double uplink_s;
+    bool ok;
+
+    test_sim_start(modem_psm_mode_off, false);
+    cfg->wait_for_response_timeout = 30U;
+    test_sim.downlink_len = len;
+    test_rx_frame_len = 0U;
+    test_tx_release = modem_tx_release_single_reply;
+    ok = (test_sim_session(&uplink_s, 1U) >= 0.0) && (test_sim.rai_cmds == 1U) && (test_sim.rai == (uint8_t)modem_tx_release_single_reply);
+    printf("single reply of %u bytes: %u received, %u cesq, session ends %.1f s after it\n", len, test_rx_frame_len, test_sim.cesq_cmds,
+           test_sim.t_s - test_sim.downlink_s);
+    ok = ok && test_rx_frame_ok && (test_rx_frame_len == len) && (test_sim.cesq_cmds == 0U) && (test_sim.t_s - test_sim.downlink_s < 10.0);
+    test_tx_release = modem_tx_release_none;
+    cfg->wait_for_response_timeout = rsp_timeout;
+    Modem_ReleaseRxFrame();
+    test_sim_stop();
+    return ok;
+}
+
 /*void TestCase01()
 {
     Modem_Init();
     printf("### Step Modem_Wakeup() ### \n");
     Modem_Wakeup();
-    test_env_timer_modem_next_action();
+    test_env_timer_modem_watchdog();
     test_env_hal_set_Cts(true);
-    test_env_timer_modem_next_action();
+    test_env_timer_modem_watchdog();
     test_env_hal_set_Cts(false);
-    test_env_timer_modem_next_action();
+    test_env_timer_modem_watchdog();
 
-    test_env_timer_modem_next_action();
+    test_env_timer_modem_watchdog();
     // TEST CRITERIA => Check if Application has sent AT to Modem
     test_eval_last_tx_at_command("AT");
 
     test_env_rx_from_modem("AT\n");
     test_env_rx_from_modem("OK\n");
 
-    test_env_timer_modem_next_action();
+    test_env_timer_modem_watchdog();
     // Expect ATI from modem application
     test_env_rx_from_modem("ATI\n");
     test_env_rx_from_modem("HL7810\n");
     test_env_rx_from_modem("OK\n");
     
-    test_env_timer_modem_next_action();
+    test_env_timer_modem_watchdog();
     //Expect AT+CGMR from modem application
     test_env_rx_from_modem("AT+CGMR\n");
     test_env_rx_from_modem("HL7810.4.6.9.4\n");
     test_env_rx_from_modem("OK\n");
 
-    test_env_timer_modem_next_action();
+    test_env_timer_modem_watchdog();
     //Expect AT+KGSN=3 from modem application
     test_env_rx_from_modem("AT+KGSN=3\n");
     test_env_rx_from_modem("+KGSN: D13062105213B1\n");
     test_env_rx_from_modem("OK\n");
 
     
-    test_env_timer_modem_next_action();
+    test_env_timer_modem_watchdog();
     //Expect AT+CGSN from modem application
     if (test_eval_last_tx_at_command("AT+CGSN")) {
         printf("PASSED\n");
@@ -140,8 +1722,8 @@ static void test_modem_reset(void){
     else
     {
         printf("##### FAILED #####\n");
-        test_env_timer_modem_next_action();
-        test_env_timer_modem_next_action();
+        test_env_timer_modem_watchdog();
+        test_env_timer_modem_watchdog();
         return;
     }
 
@@ -149,50 +1731,50 @@ static void test_modem_reset(void){
     test_env_rx_from_modem("354720510148914\n");
     test_env_rx_from_modem("OK\n");
     
-    test_env_timer_modem_next_action();
+    test_env_timer_modem_watchdog();
     //Expect AT+CGDCONT? from modem application
     test_env_rx_from_modem("AT+CGDCONT?\n");
     test_env_rx_from_modem("+CGDCONT: 1,'IPV4V6','internet.cxn',,0,0,0,0,0,,0,,,,\n");
     test_env_rx_from_modem("+CGDCONT: 2,'IPV4V6',,,0,0,0,0,0,,0,,,,\n");
     test_env_rx_from_modem("OK\n");
     
-    test_env_timer_modem_next_action();
+    test_env_timer_modem_watchdog();
     //Expect AT+KBNDCFG? from modem application
     test_env_rx_from_modem("+KBNDCFG: 0,000000000000000A0A188E\n");
     test_env_rx_from_modem("+KBNDCFG: 1,0000000000000000080084\n");
     test_env_rx_from_modem("+KBNDCFG: 2,0\n");
     test_env_rx_from_modem("OK\n");
 
-    test_env_timer_modem_next_action();
+    test_env_timer_modem_watchdog();
     
     test_env_rx_from_modem("+KSELACQ:2,1\n");
     test_env_rx_from_modem("OK\n");
     
-    test_env_timer_modem_next_action();
+    test_env_timer_modem_watchdog();
     test_env_rx_from_modem("OK\n");
     
-    test_env_timer_modem_next_action();
+    test_env_timer_modem_watchdog();
     
   
     //test_env_rx_from_modem("OK\n", 3);
     
-    //test_env_timer_modem_next_action();
+    //test_env_timer_modem_watchdog();
     //test_env_rx_from_modem("+CGDCONT=1,IPV4V6,"",,0,0,0,0,0,,0,,,,,\n", 38);
     //test_env_rx_from_modem("OK\n", 3);
-    //test_env_timer_modem_next_action();
+    //test_env_timer_modem_watchdog();
     
     
-    //test_env_timer_modem_next_action();
+    //test_env_timer_modem_watchdog();
     
     //printf("### Step Modem_StartProcess ### \n");
     //bool request_to_send = true;
     //Modem_StartProcess(Modem_cmdStartCb, request_to_send);
 
-    //test_env_timer_modem_next_action();
-    //test_env_timer_modem_next_action();
-    //test_env_timer_modem_next_action();
-    //test_env_timer_modem_next_action();
-    //test_env_timer_modem_next_action();
+    //test_env_timer_modem_watchdog();
+    //test_env_timer_modem_watchdog();
+    //test_env_timer_modem_watchdog();
+    //test_env_timer_modem_watchdog();
+    //test_env_timer_modem_watchdog();
 
 }*/
 
@@ -219,12 +1801,132 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs,
             plhs[0] = mxCreateLogicalScalar(test_eval_last_tx_at_command(mxArrayToString(prhs[1])));
 
         }
+        else if (strcmp(cmd, "check_modem_info") == 0) {
+            plhs[0] = mxCreateLogicalScalar(test_eval_modem_info(mxArrayToString(prhs[1]), mxArrayToString(prhs[2]), mxArrayToString(prhs[3])));
+        }
+        else if (strcmp(cmd, "check_at_line_overflow") == 0) {
+            plhs[0] = mxCreateLogicalScalar(test_eval_at_line_overflow((size_t)mxGetScalar(prhs[1]), (size_t)mxGetScalar(prhs[2]), (uint32_t)mxGetScalar(prhs[3])));
+        }
+        else if (strcmp(cmd, "check_at_probe") == 0) {
+            plhs[0] = mxCreateLogicalScalar(test_eval_at_probe((uint32_t)mxGetScalar(prhs[1])));
+        }
+        else if (strcmp(cmd, "check_at_queue") == 0) {
+            plhs[0] = mxCreateLogicalScalar(test_eval_at_queue((uint32_t)mxGetScalar(prhs[1]), (uint32_t)mxGetScalar(prhs[2])));
+        }
+        else if (strcmp(cmd, "check_long_cmd") == 0) {
+            plhs[0] = mxCreateLogicalScalar(test_eval_long_cmd());
+        }
+        else if (strcmp(cmd, "check_raw_tx") == 0) {
+            plhs[0] = mxCreateLogicalScalar(test_eval_raw_tx(mxArrayToString(prhs[1])));
+        }
+        else if (strcmp(cmd, "queue_tx_frame") == 0) {
+            test_env_stage_tx_frame(mxArrayToString(prhs[1]), (uint8_t)mxGetScalar(prhs[2]), (uint32_t)mxGetScalar(prhs[3]));
+        }
+        else if (strcmp(cmd, "queue_tx_payload") == 0) {
+            test_env_stage_tx_payload((uint32_t)mxGetScalar(prhs[1]), (uint8_t)mxGetScalar(prhs[2]));
+        }
+        else if (strcmp(cmd, "check_tx_fragment") == 0) {
+            plhs[0] = mxCreateLogicalScalar(test_eval_tx_fragment((uint32_t)mxGetScalar(prhs[1]), (uint32_t)mxGetScalar(prhs[2]), (uint32_t)mxGetScalar(prhs[3])));
+        }
+        else if (strcmp(cmd, "set_rx_read_size") == 0) {
+            Modem_SetRxReadSize((uint16_t)mxGetScalar(prhs[1]));
+        }
+        else if (strcmp(cmd, "set_registration_pipeline") == 0) {
+            Modem_SetRegistrationPipeline(mxGetScalar(prhs[1]) != 0);
+        }
+        else if (strcmp(cmd, "check_rx_frame") == 0) {
+            plhs[0] = mxCreateLogicalScalar(test_eval_rx_frame(mxArrayToString(prhs[1])));
+        }
+        else if (strcmp(cmd, "check_tx_frame_rejected") == 0) {
+            plhs[0] = mxCreateLogicalScalar(test_eval_tx_frame_rejected(mxArrayToString(prhs[1])));
+        }
+        else if (strcmp(cmd, "check_tx_done") == 0) {
+            plhs[0] = mxCreateLogicalScalar(test_eval_tx_done(mxArrayToString(prhs[1])));
+        }
+        else if (strcmp(cmd, "set_uart_tx_hold") == 0) {
+            test_uart_tx_hold = mxGetScalar(prhs[1]) != 0;
+        }
+        else if (strcmp(cmd, "set_uart_flow_stop") == 0) {
+            Modem_Hal_TxFlowInd(mxGetScalar(prhs[1]) != 0);
+        }
+        else if (strcmp(cmd, "uart_tx_drain") == 0) {
+            plhs[0] = mxCreateDoubleScalar(test_env_uart_tx_drain((size_t)mxGetScalar(prhs[1])));
+        }
+        else if (strcmp(cmd, "check_at_timeout_running") == 0) {
+            plhs[0] = mxCreateLogicalScalar(test_at_timeout_running);
+        }
+        else if (strcmp(cmd, "advance_time") == 0) {
+            test_uptime_s += (uint32_t)mxGetScalar(prhs[1]);
+        }
+        else if (strcmp(cmd, "check_at_latency") == 0) {
+            plhs[0] = mxCreateLogicalScalar(test_eval_at_latency(mxArrayToString(prhs[1]), (uint32_t)mxGetScalar(prhs[2]), (uint32_t)mxGetScalar(prhs[3]), (uint32_t)mxGetScalar(prhs[4])));
+        }
+        else if (strcmp(cmd, "check_log") == 0) {
+            plhs[0] = mxCreateLogicalScalar(test_eval_log((uint32_t)mxGetScalar(prhs[1])));
+        }
+        else if (strcmp(cmd, "benchmark_log") == 0) {
+            plhs[0] = mxCreateDoubleScalar(test_benchmark_log((uint32_t)mxGetScalar(prhs[1])));
+        }
         else if (strcmp(cmd, "timer_modem_next_action") == 0) {
             test_env_timer_modem_next_action();
         }
+        else if (strcmp(cmd, "timer_modem_watchdog") == 0) {
+            test_env_timer_modem_watchdog();
+        }
         else if (strcmp(cmd, "modem_reset") == 0){
             test_modem_reset();
         }
+        else if (strcmp(cmd, "benchmark_rx") == 0) {
+            plhs[0] = mxCreateDoubleScalar(test_benchmark_rx((uint32_t)mxGetScalar(prhs[1])));
+        }
+        else if (strcmp(cmd, "check_eof_frame") == 0) {
+            plhs[0] = mxCreateLogicalScalar(test_eval_eof_frame(mxArrayToString(prhs[1]), mxArrayToString(prhs[2]), (size_t)mxGetScalar(prhs[3])));
+        }
+        else if (strcmp(cmd, "check_eof_stream") == 0) {
+            plhs[0] = mxCreateLogicalScalar(test_eval_eof_stream_hex(mxArrayToString(prhs[1]), mxArrayToString(prhs[2]), (size_t)mxGetScalar(prhs[3])));
+        }
+        else if (strcmp(cmd, "check_eof_stream_large") == 0) {
+            plhs[0] = mxCreateLogicalScalar(test_eval_eof_stream_large((size_t)mxGetScalar(prhs[1]), (size_t)mxGetScalar(prhs[2])));
+        }
+        else if (strcmp(cmd, "benchmark_eof") == 0) {
+            plhs[0] = mxCreateDoubleScalar(test_benchmark_eof((uint32_t)mxGetScalar(prhs[1])));
+        }
+        else if (strcmp(cmd, "benchmark_at_cmd") == 0) {
+            plhs[0] = mxCreateDoubleScalar(test_benchmark_at_cmd((uint32_t)mxGetScalar(prhs[1])));
+        }
+        else if (strcmp(cmd, "benchmark_urc") == 0) {
+            plhs[0] = mxCreateDoubleScalar(test_benchmark_urc((uint32_t)mxGetScalar(prhs[1])));
+        }
+        else if (strcmp(cmd, "set_psm_mode") == 0) {
+            test_env_set_psm_mode((uint8_t)mxGetScalar(prhs[1]), mxArrayToString(prhs[2]), mxArrayToString(prhs[3]), mxArrayToString(prhs[4]));
+        }
+        else if (strcmp(cmd, "check_rx_downlink") == 0) {
+            plhs[0] = mxCreateLogicalScalar(test_eval_rx_downlink((uint16_t)mxGetScalar(prhs[1]), (uint16_t)mxGetScalar(prhs[2])));
+        }
+        else if (strcmp(cmd, "check_tx_release_reply") == 0) {
+            plhs[0] = mxCreateLogicalScalar(test_eval_tx_release_reply((uint16_t)mxGetScalar(prhs[1])));
+        }
+        else if (strcmp(cmd, "check_tx_failed") == 0) {
+            plhs[0] = mxCreateLogicalScalar(test_eval_tx_failed());
+        }
+        else if (strcmp(cmd, "set_tx_release") == 0) {
+            test_tx_release = (enum modem_tx_release_e)mxGetScalar(prhs[1]);
+        }
+        else if (strcmp(cmd, "check_tx_release") == 0) {
+            plhs[0] = mxCreateLogicalScalar(test_eval_tx_release((uint32_t)mxGetScalar(prhs[1])));
+        }
+        else if (strcmp(cmd, "check_psm_session") == 0) {
+            plhs[0] = mxCreateLogicalScalar(test_eval_psm_session(mxGetScalar(prhs[1]) != 0));
+        }
+        else if (strcmp(cmd, "check_psm_entry_wait") == 0) {
+            plhs[0] = mxCreateLogicalScalar(test_eval_psm_entry_wait(mxArrayToString(prhs[1]), (uint32_t)mxGetScalar(prhs[2])));
+        }
+        else if (strcmp(cmd, "check_psm_energy") == 0) {
+            plhs[0] = mxCreateLogicalScalar(test_eval_psm_energy((uint32_t)mxGetScalar(prhs[1])));
+        }
+        else if (strcmp(cmd, "benchmark_rx_ring") == 0) {
+            plhs[0] = mxCreateDoubleScalar(test_benchmark_rx_ring((uint32_t)mxGetScalar(prhs[1]), (uint32_t)mxGetScalar(prhs[2])));
+        }
        /* else if (strcmp(cmd, "sleep") == 0){
             sleepFunction(5);
         }*/
@@ -232,6 +1934,7 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs,
         /*else if (strcmp(cmd, "test_set_Wait_For_Response") == 0) {
             test_set_Wait_For_Response();
         }*/
+        test_log_dump();
     }
 
     if (nlhs > nrhs)
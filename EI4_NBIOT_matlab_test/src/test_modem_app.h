@@ -29,5 +29,17 @@
  -----------------------------------------------------------------------------*/
 
 void test_env_timer_modem_next_action(void);
+void test_env_timer_modem_watchdog(void);
+void test_env_timer_at_timeout(bool running);
+unsigned int test_env_uptime_ms(void);
+unsigned int test_env_uptime_s(void);
+void test_env_ready_to_send(void);
+void test_env_rx_frame_ind(void);
 void test_env_rx_from_modem(char* rxStr, unsigned short rxStrLen);
-void test_env_tx_to_modem(char* txStr);
\ No newline at end of file
+void test_env_tx_to_modem(char* txStr);
+struct modem_hal_txv_s;
+void test_env_tx_raw_to_modem(const struct modem_hal_txv_s *v, unsigned char n);
+void test_env_uart_tx_kick(void);
+void test_env_sched_event(unsigned int event);
+void test_env_hal_reset(bool high);
+void test_env_hal_wake_up(bool high);
\ No newline at end of file
@@ -11,6 +11,8 @@ if (1)
         src/modem/modem_at.c ...
         src/modem/modem_cmd.c ...
         src/modem/modem_hal.c ...
+        src/modem/modem_log.c ...
+        src/modem/modem_latency.c ...
         src/modem/modem_stats.c ...
         src/modem/modem_umi.c ...
         src/os/os.c ...